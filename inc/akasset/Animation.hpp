@@ -34,22 +34,23 @@ namespace aka {
 		Cubic
 	);
 
+	// Widest first so the only padding is at the end, blobs write it as zeros
 	struct AnimPosFrame final {
 		uint64 boneID;
-		Interpolation interpolation;
 		akm::Vec3 position;
+		Interpolation interpolation;
 	};
 
 	struct AnimRotFrame final {
 		uint64 boneID;
-		Interpolation interpolation;
 		akm::Quat rotation;
+		Interpolation interpolation;
 	};
 
 	struct AnimSclFrame final {
 		uint64 boneID;
-		Interpolation interpolation;
 		akm::Vec3 scale;
+		Interpolation interpolation;
 	};
 
 	struct Animation final {
@@ -65,21 +66,24 @@ AK_SMART_ENUM_SERIALIZE(aka, Interpolation)
 
 AK_SMART_CLASS(aka::AnimPosFrame,
 	FIELD, boneID,
-	FIELD, interpolation,
-	FIELD, position
+	FIELD, position,
+	FIELD, interpolation
 )
+AK_SMART_CLASS_POD(aka::AnimPosFrame)
 
 AK_SMART_CLASS(aka::AnimRotFrame,
 	FIELD, boneID,
-	FIELD, interpolation,
-	FIELD, rotation
+	FIELD, rotation,
+	FIELD, interpolation
 )
+AK_SMART_CLASS_POD(aka::AnimRotFrame)
 
 AK_SMART_CLASS(aka::AnimSclFrame,
 	FIELD, boneID,
-	FIELD, interpolation,
-	FIELD, scale
+	FIELD, scale,
+	FIELD, interpolation
 )
+AK_SMART_CLASS_POD(aka::AnimSclFrame)
 
 AK_SMART_CLASS(aka::Animation,
 	FIELD, boneNames,
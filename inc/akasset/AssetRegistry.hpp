@@ -19,6 +19,7 @@
 
 #include <akasset/Asset.hpp>
 #include <akcommon/SlotMap.hpp>
+#include <akengine/data/Document.hpp>
 #include <akengine/data/SUID.hpp>
 #include <akengine/filesystem/Path.hpp>
 #include <optional>
@@ -37,6 +38,8 @@ namespace aka {
 			std::unordered_map<akfs::Path, akc::SlotID> m_assetByDestination;
 			std::unordered_map<akfs::Path, akc::SlotID> m_assetBySource;
 
+			akd::Document m_scanDocument; /// Reused between files, so a rescan settles on one arena block
+
 			bool proccessFile(const akfs::Path& path);
 
 		public:
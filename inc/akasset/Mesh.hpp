@@ -60,11 +60,13 @@ AK_SMART_CLASS(aka::VertexSurfaceData,
 	FIELD, bitangent,
 	FIELD, normal
 )
+AK_SMART_CLASS_POD(aka::VertexSurfaceData)
 
 AK_SMART_CLASS(aka::VertexWeightData,
 	FIELD, bones,
 	FIELD, weights
 )
+AK_SMART_CLASS_POD(aka::VertexWeightData)
 
 AK_SMART_CLASS(aka::Primitive,
 	FIELD, drawType,
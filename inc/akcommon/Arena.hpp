@@ -0,0 +1,113 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_COMMON_ARENA_HPP_
+#define AK_COMMON_ARENA_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace akc {
+
+	/**
+	 * Bump allocator that only frees everything at once, on reset or destruction.
+	 * Nothing allocated from it is destructed, so it only hands out trivially destructible types.
+	 */
+	class MonotonicArena final {
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+		public:
+			static constexpr akSize DEFAULT_BLOCK_SIZE = 4*1024;
+			static constexpr akSize MAX_BLOCK_SIZE = 1024*1024;
+
+		private:
+			struct Block final {
+				std::unique_ptr<uint8[]> data;
+				akSize size;
+			};
+
+			std::vector<Block> m_blocks;
+			akSize m_offset;
+			akSize m_nextBlockSize;
+
+			static akSize alignOffset(akSize offset, akSize alignment) { return (offset + alignment - 1) & ~(alignment - 1); }
+
+			void* allocateBlock(akSize size) {
+				// Oversized requests get their own block behind the current one, so its free space isn't abandoned
+				if ((size > m_nextBlockSize/2) && !m_blocks.empty()) {
+					m_blocks.insert(m_blocks.end() - 1, Block{std::unique_ptr<uint8[]>(new uint8[size]), size});
+					return m_blocks[m_blocks.size() - 2].data.get();
+				}
+
+				auto blockSize = std::max(size, m_nextBlockSize);
+				m_blocks.push_back(Block{std::unique_ptr<uint8[]>(new uint8[blockSize]), blockSize});
+				m_nextBlockSize = std::min(m_nextBlockSize*2, MAX_BLOCK_SIZE);
+				m_offset = size;
+				return m_blocks.back().data.get();
+			}
+
+		public:
+			explicit MonotonicArena(akSize initialBlockSize = DEFAULT_BLOCK_SIZE) : m_blocks(), m_offset(0), m_nextBlockSize(std::max<akSize>(initialBlockSize, 64)) {}
+			MonotonicArena(MonotonicArena&&) = default;
+			MonotonicArena& operator=(MonotonicArena&&) = default;
+
+			/**
+			 * @param alignment Must be a power of two, no greater than alignof(std::max_align_t)
+			 */
+			void* allocate(akSize size, akSize alignment = alignof(std::max_align_t)) {
+				if (!m_blocks.empty()) {
+					auto offset = alignOffset(m_offset, alignment);
+					if (offset + size <= m_blocks.back().size) {
+						m_offset = offset + size;
+						return m_blocks.back().data.get() + offset;
+					}
+				}
+				return allocateBlock(size);
+			}
+
+			template<typename type_t> type_t* allocate(akSize count) {
+				static_assert(std::is_trivially_destructible<type_t>::value, "Arena allocations are never destructed.");
+				return static_cast<type_t*>(allocate(static_cast<akSize>(count*sizeof(type_t)), alignof(type_t)));
+			}
+
+			/**
+			 * Releases every allocation, the largest block is kept for reuse.
+			 */
+			void reset() {
+				if (m_blocks.size() > 1) {
+					auto largest = std::max_element(m_blocks.begin(), m_blocks.end(), [](const Block& lhs, const Block& rhs){ return lhs.size < rhs.size; });
+					auto block = std::move(*largest);
+					m_blocks.clear();
+					m_blocks.push_back(std::move(block));
+				}
+				m_offset = 0;
+			}
+
+			akSize capacity() const {
+				akSize result = 0;
+				for(const auto& block : m_blocks) result += block.size;
+				return result;
+			}
+	};
+
+}
+
+#endif
@@ -40,6 +40,19 @@ namespace akc {
 		while(power < val) power *= 2;
 		return power;
 	}
+
+	/**
+	 * @return Index of the most significant set bit, val must not be 0
+	 */
+	inline uint32 highestSetBit(uint64 val) {
+#		if defined(__GNUC__) || defined(__clang__)
+			return 63u - static_cast<uint32>(__builtin_clzll(val));
+#		else
+			uint32 result = 0;
+			while(val >>= 1) result++;
+			return result;
+#		endif
+	}
 }
 
 #endif
@@ -0,0 +1,148 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_COMMON_DELEGATE_HPP_
+#define AK_COMMON_DELEGATE_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace akc {
+
+	template<typename signature_t, akSize capacity_v = 4*sizeof(void*)> class Delegate;
+
+	/**
+	 * A callable wrapper with inline storage that never allocates.
+	 * Callables that don't fit are rejected at compile time, and member functions bound with bind<&Class::method>(obj)
+	 * are called directly from a stub rather than through a pointer-to-member.
+	 * @tparam capacity_v Bytes of inline storage
+	 */
+	template<typename result_t, typename... vargs_t, akSize capacity_v> class Delegate<result_t(vargs_t...), capacity_v> final {
+		private:
+			enum class Operation : uint8 { Copy, Move, Destroy };
+
+			using invoke_f = result_t(*)(void*, vargs_t...);
+			using manage_f = void(*)(Operation, void*, void*);
+
+			alignas(std::max_align_t) mutable unsigned char m_storage[capacity_v];
+			invoke_f m_invoke;
+			manage_f m_manage; /// nullptr for trivially copyable callables
+
+			template<typename func_t> static result_t invokeCallable(void* storage, vargs_t... vargs) {
+				return (*static_cast<func_t*>(storage))(std::forward<vargs_t>(vargs)...);
+			}
+
+			template<auto method_v, typename class_t> static result_t invokeMethod(void* storage, vargs_t... vargs) {
+				return ((*static_cast<class_t**>(storage))->*method_v)(std::forward<vargs_t>(vargs)...);
+			}
+
+			template<auto func_v> static result_t invokeFunction(void* /*storage*/, vargs_t... vargs) {
+				return func_v(std::forward<vargs_t>(vargs)...);
+			}
+
+			static result_t invokeEmpty(void* /*storage*/, vargs_t... /*vargs*/) {
+				throw std::bad_function_call();
+			}
+
+			template<typename func_t> static void manageCallable(Operation operation, void* dst, void* src) {
+				switch(operation) {
+					case Operation::Copy:    new(dst) func_t(*static_cast<const func_t*>(src)); return;
+					case Operation::Move:    new(dst) func_t(std::move(*static_cast<func_t*>(src))); return;
+					case Operation::Destroy: static_cast<func_t*>(dst)->~func_t(); return;
+				}
+			}
+
+			void assign(const Delegate& other, Operation operation) {
+				m_invoke = other.m_invoke;
+				m_manage = other.m_manage;
+				if (m_manage) m_manage(operation, m_storage, other.m_storage);
+				else std::memcpy(m_storage, other.m_storage, capacity_v);
+			}
+
+			void destroy() {
+				if (m_manage) m_manage(Operation::Destroy, m_storage, nullptr);
+				m_invoke = &invokeEmpty;
+				m_manage = nullptr;
+			}
+
+		public:
+			Delegate() : m_storage(), m_invoke(&invokeEmpty), m_manage(nullptr) {}
+			Delegate(std::nullptr_t) : Delegate() {}
+
+			template<typename func_t, typename = std::enable_if_t<!std::is_same_v<std::decay_t<func_t>, Delegate>>> Delegate(func_t&& func) : Delegate() {
+				using callable_t = std::decay_t<func_t>;
+				static_assert(sizeof(callable_t) <= capacity_v, "Delegate: Callable exceeds inline storage, capture less or raise the capacity.");
+				static_assert(alignof(callable_t) <= alignof(std::max_align_t), "Delegate: Callable is over-aligned.");
+				static_assert(std::is_invocable_r_v<result_t, callable_t&, vargs_t...>, "Delegate: Callable does not match the signature.");
+
+				new(m_storage) callable_t(std::forward<func_t>(func));
+				m_invoke = &invokeCallable<callable_t>;
+				if constexpr (!std::is_trivially_copyable_v<callable_t>) m_manage = &manageCallable<callable_t>;
+			}
+
+			Delegate(const Delegate& other) : m_storage() { assign(other, Operation::Copy); }
+			Delegate(Delegate&& other) : m_storage() { assign(other, Operation::Move); }
+			~Delegate() { destroy(); }
+
+			Delegate& operator=(const Delegate& other) {
+				if (this == &other) return *this;
+				destroy();
+				assign(other, Operation::Copy);
+				return *this;
+			}
+
+			Delegate& operator=(Delegate&& other) {
+				if (this == &other) return *this;
+				destroy();
+				assign(other, Operation::Move);
+				return *this;
+			}
+
+			/**
+			 * Binds a member function to an object, the object must outlive the delegate.
+			 * @tparam method_v The member function, e.g. &Class::method
+			 */
+			template<auto method_v, typename class_t> static Delegate bind(class_t& obj) {
+				Delegate result;
+				*reinterpret_cast<class_t**>(result.m_storage) = &obj;
+				result.m_invoke = &invokeMethod<method_v, class_t>;
+				return result;
+			}
+
+			/**
+			 * Binds a free or static function.
+			 * @tparam func_v The function, e.g. &function
+			 */
+			template<auto func_v> static Delegate bind() {
+				Delegate result;
+				result.m_invoke = &invokeFunction<func_v>;
+				return result;
+			}
+
+			result_t operator()(vargs_t... vargs) const { return m_invoke(m_storage, std::forward<vargs_t>(vargs)...); }
+
+			explicit operator bool() const { return m_invoke != &invokeEmpty; }
+	};
+
+}
+
+#endif
@@ -0,0 +1,248 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_COMMON_FLATMAP_HPP_
+#define AK_COMMON_FLATMAP_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace akc {
+
+	template<typename key_t, typename val_t, typename compare_t> class FlatMap;
+
+	/**
+	 * Random access iterator over a vector of pairs that only exposes the key as const.
+	 * Dereferencing gives a pair of references rather than a reference to a pair, like std::flat_map.
+	 */
+	template<typename base_t, typename key_t, typename val_t> class FlatMapIterator final {
+		template<typename, typename, typename> friend class FlatMapIterator;
+		template<typename, typename, typename> friend class FlatMap;
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = std::pair<const key_t, val_t>;
+			using difference_type = typename std::iterator_traits<base_t>::difference_type;
+			using reference = std::pair<const key_t&, val_t&>;
+
+			/// Holds the pair of references so operator-> has something to point at
+			struct pointer final {
+				reference ref;
+				const reference* operator->() const { return &ref; }
+			};
+
+		private:
+			base_t m_base;
+
+		public:
+			FlatMapIterator() = default;
+			explicit FlatMapIterator(base_t base) : m_base(base) {}
+
+			/// Mutable to const conversion
+			template<typename other_t, typename val2_t, typename = std::enable_if_t<std::is_convertible_v<other_t, base_t>>>
+			FlatMapIterator(const FlatMapIterator<other_t, key_t, val2_t>& other) : m_base(other.m_base) {}
+
+			reference operator*() const { return reference(m_base->first, m_base->second); }
+			pointer operator->() const { return pointer{**this}; }
+			reference operator[](difference_type offset) const { return *(*this + offset); }
+
+			FlatMapIterator& operator++() { ++m_base; return *this; }
+			FlatMapIterator& operator--() { --m_base; return *this; }
+			FlatMapIterator operator++(int) { auto result = *this; ++m_base; return result; }
+			FlatMapIterator operator--(int) { auto result = *this; --m_base; return result; }
+
+			FlatMapIterator& operator+=(difference_type offset) { m_base += offset; return *this; }
+			FlatMapIterator& operator-=(difference_type offset) { m_base -= offset; return *this; }
+			FlatMapIterator operator+(difference_type offset) const { return FlatMapIterator(m_base + offset); }
+			FlatMapIterator operator-(difference_type offset) const { return FlatMapIterator(m_base - offset); }
+			friend FlatMapIterator operator+(difference_type offset, const FlatMapIterator& iter) { return iter + offset; }
+			difference_type operator-(const FlatMapIterator& other) const { return m_base - other.m_base; }
+
+			bool operator==(const FlatMapIterator& other) const { return m_base == other.m_base; }
+			bool operator!=(const FlatMapIterator& other) const { return m_base != other.m_base; }
+			bool operator< (const FlatMapIterator& other) const { return m_base <  other.m_base; }
+			bool operator> (const FlatMapIterator& other) const { return m_base >  other.m_base; }
+			bool operator<=(const FlatMapIterator& other) const { return m_base <= other.m_base; }
+			bool operator>=(const FlatMapIterator& other) const { return m_base >= other.m_base; }
+	};
+
+	/**
+	 * A std::map-like container kept as a sorted vector, for small maps that are read far more than written.
+	 * Iterates in key order like std::map, but any insert or erase invalidates references to all entries.
+	 * Keys can't be modified through iterators, they dereference to a std::pair<const key_t&, val_t&>.
+	 */
+	template<typename key_t, typename val_t, typename compare_t = std::less<>> class FlatMap final {
+		public:
+			using key_type = key_t;
+			using mapped_type = val_t;
+			using value_type = std::pair<const key_t, val_t>;
+			using container_type = std::vector<std::pair<key_t, val_t>>;
+			using size_type = typename container_type::size_type;
+			using iterator = FlatMapIterator<typename container_type::iterator, key_t, val_t>;
+			using const_iterator = FlatMapIterator<typename container_type::const_iterator, key_t, const val_t>;
+
+		private:
+			using entry_type = typename container_type::value_type;
+			using base_iterator = typename container_type::iterator;
+			using base_const_iterator = typename container_type::const_iterator;
+
+			container_type m_data;
+
+			template<typename lookup_t> base_iterator lowerBound(const lookup_t& key) {
+				return std::lower_bound(m_data.begin(), m_data.end(), key, [](const entry_type& entry, const lookup_t& val){ return compare_t()(entry.first, val); });
+			}
+
+			template<typename lookup_t> base_const_iterator lowerBound(const lookup_t& key) const {
+				return std::lower_bound(m_data.begin(), m_data.end(), key, [](const entry_type& entry, const lookup_t& val){ return compare_t()(entry.first, val); });
+			}
+
+			template<typename lookup_t> bool matches(base_const_iterator iter, const lookup_t& key) const {
+				return (iter != m_data.end()) && !compare_t()(key, iter->first);
+			}
+
+		public:
+			FlatMap() = default;
+			FlatMap(std::initializer_list<value_type> vals) { for(const auto& val : vals) insert(val); }
+
+			// /////////// //
+			// // Query // //
+			// /////////// //
+
+			template<typename lookup_t> iterator find(const lookup_t& key) {
+				auto iter = lowerBound(key);
+				return iterator(matches(iter, key) ? iter : m_data.end());
+			}
+
+			template<typename lookup_t> const_iterator find(const lookup_t& key) const {
+				auto iter = lowerBound(key);
+				return const_iterator(matches(iter, key) ? iter : m_data.end());
+			}
+
+			template<typename lookup_t> size_type count(const lookup_t& key) const { return matches(lowerBound(key), key) ? 1 : 0; }
+
+			template<typename lookup_t> val_t& at(const lookup_t& key) {
+				auto iter = lowerBound(key);
+				if (!matches(iter, key)) throw std::out_of_range("FlatMap does not contain key.");
+				return iter->second;
+			}
+
+			template<typename lookup_t> const val_t& at(const lookup_t& key) const {
+				auto iter = lowerBound(key);
+				if (!matches(iter, key)) throw std::out_of_range("FlatMap does not contain key.");
+				return iter->second;
+			}
+
+			val_t& operator[](const key_t& key) { return try_emplace(key).first->second; }
+			val_t& operator[](key_t&& key) { return try_emplace(std::move(key)).first->second; }
+
+			// //////////// //
+			// // Insert // //
+			// //////////// //
+
+			template<typename... vals_t> std::pair<iterator, bool> try_emplace(const key_t& key, vals_t&&... vals) {
+				auto iter = lowerBound(key);
+				if (matches(iter, key)) return {iterator(iter), false};
+				return {iterator(m_data.emplace(iter, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<vals_t>(vals)...))), true};
+			}
+
+			template<typename... vals_t> std::pair<iterator, bool> try_emplace(key_t&& key, vals_t&&... vals) {
+				auto iter = lowerBound(key);
+				if (matches(iter, key)) return {iterator(iter), false};
+				return {iterator(m_data.emplace(iter, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<vals_t>(vals)...))), true};
+			}
+
+			template<typename val2_t> std::pair<iterator, bool> emplace(key_t key, val2_t&& val) { return try_emplace(std::move(key), std::forward<val2_t>(val)); }
+
+			std::pair<iterator, bool> insert(const value_type& val) { return try_emplace(val.first, val.second); }
+			std::pair<iterator, bool> insert(std::pair<key_t, val_t>&& val) { return try_emplace(std::move(val.first), std::move(val.second)); }
+
+			template<typename val2_t> std::pair<iterator, bool> insert_or_assign(key_t key, val2_t&& val) {
+				auto result = try_emplace(std::move(key), std::forward<val2_t>(val));
+				if (!result.second) result.first->second = std::forward<val2_t>(val);
+				return result;
+			}
+
+			/**
+			 * Appends an entry without keeping the map sorted, for filling it in one pass such as when parsing.
+			 * Only appendUnsorted and sortAppended may be used until the map is sorted again.
+			 * @return The appended value, valid until the next append
+			 */
+			template<typename... vals_t> val_t& appendUnsorted(key_t key, vals_t&&... vals) {
+				return m_data.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<vals_t>(vals)...)).second;
+			}
+
+			/**
+			 * Sorts entries added by appendUnsorted. The first entry for each key is kept, as try_emplace would.
+			 */
+			void sortAppended() {
+				auto compare = [](const entry_type& lhs, const entry_type& rhs){ return compare_t()(lhs.first, rhs.first); };
+				if (!std::is_sorted(m_data.begin(), m_data.end(), compare)) std::stable_sort(m_data.begin(), m_data.end(), compare);
+				m_data.erase(std::unique(m_data.begin(), m_data.end(), [](const entry_type& lhs, const entry_type& rhs){ return !compare_t()(lhs.first, rhs.first); }), m_data.end());
+			}
+
+			// /////////// //
+			// // Erase // //
+			// /////////// //
+
+			iterator erase(iterator iter) { return iterator(m_data.erase(iter.m_base)); }
+			iterator erase(const_iterator iter) { return iterator(m_data.erase(iter.m_base)); }
+
+			template<typename lookup_t> size_type erase(const lookup_t& key) {
+				auto iter = lowerBound(key);
+				if (!matches(iter, key)) return 0;
+				m_data.erase(iter);
+				return 1;
+			}
+
+			void clear() { m_data.clear(); }
+
+			// ////////////// //
+			// // Capacity // //
+			// ////////////// //
+
+			void reserve(size_type size) { m_data.reserve(size); }
+			void shrink_to_fit() { m_data.shrink_to_fit(); }
+
+			bool empty() const { return m_data.empty(); }
+			size_type size() const { return m_data.size(); }
+			size_type capacity() const { return m_data.capacity(); }
+
+			// /////////////// //
+			// // Iterators // //
+			// /////////////// //
+
+			iterator begin() { return iterator(m_data.begin()); }
+			iterator end() { return iterator(m_data.end()); }
+
+			const_iterator begin() const { return const_iterator(m_data.begin()); }
+			const_iterator end() const { return const_iterator(m_data.end()); }
+
+			const_iterator cbegin() const { return const_iterator(m_data.cbegin()); }
+			const_iterator cend() const { return const_iterator(m_data.cend()); }
+
+			bool operator==(const FlatMap& other) const { return m_data == other.m_data; }
+			bool operator!=(const FlatMap& other) const { return m_data != other.m_data; }
+	};
+
+}
+
+#endif
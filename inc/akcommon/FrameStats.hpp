@@ -0,0 +1,218 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_COMMON_FRAMESTATS_HPP_
+#define AK_COMMON_FRAMESTATS_HPP_
+
+#include <akcommon/Bits.hpp>
+#include <akcommon/PrimitiveTypes.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace akc {
+
+	/**
+	 * Fixed size histogram of nanosecond durations with buckets that are linear within each power of two.
+	 * Values are kept to within 1/SUB_BUCKETS of their true value, from 0 up to 2^MAX_BIT ns (~18 minutes), larger values are clamped.
+	 * A single writer and any number of readers may use it concurrently, readers see approximate counts.
+	 */
+	class LogLinearHistogram final {
+		public:
+			static constexpr uint32 SUB_BITS = 5;
+			static constexpr uint32 SUB_BUCKETS = 1u << SUB_BITS;
+			static constexpr uint32 MAX_BIT = 40;
+			static constexpr uint32 BUCKET_COUNT = (MAX_BIT - SUB_BITS + 1)*SUB_BUCKETS;
+
+			static uint32 bucketFor(uint64 value) {
+				if (value < SUB_BUCKETS) return static_cast<uint32>(value);
+				auto bit = highestSetBit(value);
+				if (bit >= MAX_BIT) return BUCKET_COUNT - 1;
+				auto shift = bit - SUB_BITS;
+				return (shift + 1)*SUB_BUCKETS + static_cast<uint32>((value >> shift) - SUB_BUCKETS);
+			}
+
+			/// @return The midpoint of the values counted in the bucket
+			static uint64 bucketValue(uint32 bucket) {
+				if (bucket < SUB_BUCKETS) return bucket;
+				auto shift = bucket/SUB_BUCKETS - 1;
+				auto lower = static_cast<uint64>(SUB_BUCKETS + bucket%SUB_BUCKETS) << shift;
+				return lower + ((static_cast<uint64>(1) << shift) >> 1);
+			}
+
+		private:
+			std::array<std::atomic<uint32>, BUCKET_COUNT> m_buckets;
+			std::atomic<uint64> m_count;
+			std::atomic<uint64> m_sum;
+			std::atomic<uint64> m_max;
+
+		public:
+			LogLinearHistogram() : m_buckets(), m_count(0), m_sum(0), m_max(0) { clear(); }
+
+			void record(uint64 value) {
+				auto& bucket = m_buckets[bucketFor(value)];
+				bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+				if (value > m_max.load(std::memory_order_relaxed)) m_max.store(value, std::memory_order_relaxed);
+			}
+
+			void clear() {
+				for(auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+				m_count.store(0, std::memory_order_relaxed);
+				m_sum.store(0, std::memory_order_relaxed);
+				m_max.store(0, std::memory_order_relaxed);
+			}
+
+			uint32 bucket(uint32 index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+			uint64 count() const { return m_count.load(std::memory_order_relaxed); }
+			uint64 sum()   const { return m_sum.load(std::memory_order_relaxed); }
+			uint64 max()   const { return m_max.load(std::memory_order_relaxed); }
+	};
+
+	struct FrameStatsSummary {
+		uint64 count = 0;
+		uint64 meanNS = 0;
+		uint64 p50NS = 0;
+		uint64 p95NS = 0;
+		uint64 p99NS = 0;
+		uint64 maxNS = 0;
+	};
+
+	/**
+	 * Duration percentiles over a rolling window and over the whole run.
+	 * The window is WINDOW_SLOTS histograms of slotMS each, the oldest is cleared as time moves on. Nothing is allocated after construction.
+	 * Single writer, summaries may be taken from any thread.
+	 */
+	class FrameStats final {
+		FrameStats(const FrameStats&) = delete;
+		FrameStats& operator=(const FrameStats&) = delete;
+		public:
+			static constexpr uint32 WINDOW_SLOTS = 10;
+
+		private:
+			using clock_t = std::chrono::steady_clock;
+
+			uint64 m_slotMS;
+			clock_t::time_point m_start;
+
+			std::array<LogLinearHistogram, WINDOW_SLOTS> m_slots;
+			std::array<std::atomic<int64>, WINDOW_SLOTS> m_slotEpochs; /// Which slot period each histogram holds, -1 if unused
+			LogLinearHistogram m_total;
+
+			int64 currentEpoch() const {
+				return static_cast<int64>(std::chrono::duration_cast<std::chrono::milliseconds>(clock_t::now() - m_start).count()/static_cast<int64>(m_slotMS));
+			}
+
+			template<typename func_t> static FrameStatsSummary summarize(uint64 count, uint64 sum, uint64 max, const func_t& bucketCount) {
+				FrameStatsSummary result;
+				result.count = count;
+				result.maxNS = max;
+				if (count == 0) return result;
+				result.meanNS = sum/count;
+
+				// Nearest rank: the smallest value with at least p% of samples at or below it
+				auto rank = [&](uint64 percent) { return std::max<uint64>(1, (count*percent + 99)/100); };
+				std::array<uint64, 3> ranks{{rank(50), rank(95), rank(99)}};
+				std::array<uint64*, 3> outputs{{&result.p50NS, &result.p95NS, &result.p99NS}};
+
+				uint64 cumulative = 0;
+				akSize next = 0;
+				for(uint32 i = 0; (i < LogLinearHistogram::BUCKET_COUNT) && (next < ranks.size()); i++) {
+					cumulative += bucketCount(i);
+					while((next < ranks.size()) && (cumulative >= ranks[next])) *outputs[next++] = std::min(LogLinearHistogram::bucketValue(i), max);
+				}
+				for(; next < ranks.size(); next++) *outputs[next] = max;
+
+				return result;
+			}
+
+		public:
+			explicit FrameStats(uint64 slotMS = 1000) : m_slotMS(std::max<uint64>(slotMS, 1)), m_start(clock_t::now()), m_slots(), m_slotEpochs(), m_total() {
+				for(auto& epoch : m_slotEpochs) epoch.store(-1, std::memory_order_relaxed);
+			}
+
+			void record(uint64 durationNS) {
+				auto epoch = currentEpoch();
+				auto slot = static_cast<akSize>(epoch % WINDOW_SLOTS);
+				if (m_slotEpochs[slot].load(std::memory_order_relaxed) != epoch) {
+					m_slots[slot].clear();
+					m_slotEpochs[slot].store(epoch, std::memory_order_relaxed);
+				}
+
+				m_slots[slot].record(durationNS);
+				m_total.record(durationNS);
+			}
+
+			template<typename rep_t, typename period_t> void record(const std::chrono::duration<rep_t, period_t>& duration) {
+				record(static_cast<uint64>(std::max<int64>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count())));
+			}
+
+			/**
+			 * @return Percentiles of the samples recorded in the last WINDOW_SLOTS*slotMS milliseconds
+			 */
+			FrameStatsSummary window() const {
+				auto epoch = currentEpoch();
+				std::array<bool, WINDOW_SLOTS> live;
+				uint64 count = 0, sum = 0, max = 0;
+				for(akSize i = 0; i < WINDOW_SLOTS; i++) {
+					auto slotEpoch = m_slotEpochs[i].load(std::memory_order_relaxed);
+					live[i] = (slotEpoch >= 0) && (epoch - slotEpoch < static_cast<int64>(WINDOW_SLOTS));
+					if (!live[i]) continue;
+					count += m_slots[i].count();
+					sum += m_slots[i].sum();
+					max = std::max(max, m_slots[i].max());
+				}
+
+				// Bucket counts are read separately from the totals, recount to keep ranks consistent with them
+				uint64 bucketTotal = 0;
+				for(uint32 b = 0; b < LogLinearHistogram::BUCKET_COUNT; b++) for(akSize i = 0; i < WINDOW_SLOTS; i++) if (live[i]) bucketTotal += m_slots[i].bucket(b);
+				if (bucketTotal == 0) return FrameStatsSummary{};
+
+				auto result = summarize(bucketTotal, sum, max, [&](uint32 b) {
+					uint64 total = 0;
+					for(akSize i = 0; i < WINDOW_SLOTS; i++) if (live[i]) total += m_slots[i].bucket(b);
+					return total;
+				});
+				result.meanNS = (count > 0) ? sum/count : 0;
+				return result;
+			}
+
+			/**
+			 * @return Percentiles of every sample since construction or reset
+			 */
+			FrameStatsSummary total() const {
+				return summarize(m_total.count(), m_total.sum(), m_total.max(), [&](uint32 b) { return static_cast<uint64>(m_total.bucket(b)); });
+			}
+
+			/**
+			 * Clears all samples, only call from the writing thread.
+			 */
+			void reset() {
+				for(akSize i = 0; i < WINDOW_SLOTS; i++) {
+					m_slots[i].clear();
+					m_slotEpochs[i].store(-1, std::memory_order_relaxed);
+				}
+				m_total.clear();
+			}
+
+			uint64 slotMS() const { return m_slotMS; }
+	};
+
+}
+
+#endif
@@ -19,8 +19,8 @@
 
 #include <akcommon/DynamicBitset.hpp>
 #include <akcommon/PrimitiveTypes.hpp>
-#include <crtdefs.h>
 #include <algorithm>
+#include <cstddef>
 #include <deque>
 #include <stdexcept>
 #include <type_traits>
@@ -0,0 +1,61 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_COMMON_SPAN_HPP_
+#define AK_COMMON_SPAN_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <algorithm>
+
+namespace akc {
+
+	/**
+	 * A non-owning view over a contiguous range of elements.
+	 */
+	template<typename type_t> class Span final {
+		public:
+			using value_type = type_t;
+			using iterator = type_t*;
+
+		private:
+			type_t* m_data;
+			akSize m_size;
+
+		public:
+			Span() : m_data(nullptr), m_size(0) {}
+			Span(type_t* data, akSize size) : m_data(data), m_size(size) {}
+			template<typename container_t> Span(container_t& container) : m_data(container.data()), m_size(static_cast<akSize>(container.size())) {}
+
+			type_t& operator[](akSize index) const { return m_data[index]; }
+			type_t& front() const { return m_data[0]; }
+			type_t& back() const { return m_data[m_size - 1]; }
+
+			iterator begin() const { return m_data; }
+			iterator end() const { return m_data + m_size; }
+
+			type_t* data() const { return m_data; }
+			akSize size() const { return m_size; }
+			bool empty() const { return m_size == 0; }
+
+			Span subspan(akSize offset, akSize count) const {
+				offset = std::min(offset, m_size);
+				return Span(m_data + offset, std::min(count, m_size - offset));
+			}
+	};
+
+}
+
+#endif
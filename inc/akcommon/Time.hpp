@@ -18,6 +18,7 @@
 #define AK_COMMON_TIME_HPP_
 
 #include <akcommon/PrimitiveTypes.hpp>
+#include <chrono>
 #include <ctime>
 
 namespace akc {
@@ -32,6 +33,13 @@ namespace akc {
 	 */
 	Timestamp utcTimestamp();
 
+	/**
+	 * Returns the UTC timestamp of the given time
+	 * @param time The time to convert
+	 * @return The UTC timestamp
+	 */
+	Timestamp utcTimestamp(const std::chrono::system_clock::time_point& time);
+
 	/**
 	 * Returns the current local timestamp
 	 * @return The current local timestamp
@@ -0,0 +1,293 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_ENGINE_DATA_DOCUMENT_HPP_
+#define AK_ENGINE_DATA_DOCUMENT_HPP_
+
+#include <akcommon/Arena.hpp>
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akcommon/Span.hpp>
+#include <akcommon/String.hpp>
+#include <akengine/data/PValue.hpp>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace akd {
+
+	namespace internal {
+		struct DocMember;
+
+		struct DocNode final {
+			union Value {
+				int64 sint;
+				uint64 uint;
+				fpDouble dec;
+				bool boolean;
+				const char* str;
+				const uint8* bin;
+				const DocNode* elements;
+				const DocMember* members;
+			};
+
+			PType type;
+			uint32 size; /// Length of strings and binary, entry count of arrays and objects
+			Value value;
+		};
+
+		/// Members are sorted by key
+		struct DocMember final {
+			std::string_view key;
+			DocNode value;
+		};
+	}
+
+	/**
+	 * Read-only handle to a value inside a Document, only valid while the document is alive.
+	 * Missing entries read as null, like the const accessors of PValue.
+	 */
+	class PValueView final {
+		private:
+			const internal::DocNode* m_node;
+
+			const internal::DocNode* findMember(std::string_view name) const {
+				if (!isObj()) return nullptr;
+				auto members = m_node->value.members, membersEnd = members + m_node->size;
+				auto iter = std::lower_bound(members, membersEnd, name, [](const internal::DocMember& member, std::string_view key){ return member.key < key; });
+				return ((iter != membersEnd) && (iter->key == name)) ? &iter->value : nullptr;
+			}
+
+			std::string toDebugString() const {
+				return isStr() ? akc::buildString("<str:", getStr(), ">") : akc::buildString("<type:", static_cast<uint32>(type()), ">");
+			}
+
+		public:
+			PValueView() : m_node(nullptr) {}
+			explicit PValueView(const internal::DocNode* node) : m_node(node) {}
+
+			// //////////////// //
+			// // Navigation // //
+			// //////////////// //
+
+			PValueView atOrDef(std::string_view name) const {
+				return PValueView(findMember(name));
+			}
+
+			PValueView atOrDef(akSize id) const {
+				if (!isArr() || (id >= m_node->size)) return PValueView();
+				return PValueView(&m_node->value.elements[id]);
+			}
+
+			PValueView at(std::string_view name) const {
+				auto node = findMember(name);
+				if (!node) throw std::out_of_range(akc::buildString("PValueView does not contain key: ", name));
+				return PValueView(node);
+			}
+
+			PValueView at(akSize id) const {
+				if (!exists(id)) throw std::out_of_range(akc::buildString("PValueView does not contain index: ", id));
+				return atOrDef(id);
+			}
+
+			PValueView operator[](std::string_view name) const { return atOrDef(name); }
+			PValueView operator[](akSize id) const { return atOrDef(id); }
+
+			bool exists(std::string_view name) const { return findMember(name) != nullptr; }
+			bool exists(akSize id) const { return isArr() && (id < m_node->size); }
+
+			/// Object members in key order, use with valueAt
+			std::string_view keyAt(akSize id) const {
+				if (!isObj() || (id >= m_node->size)) throw std::out_of_range("PValueView does not contain member.");
+				return m_node->value.members[id].key;
+			}
+
+			PValueView valueAt(akSize id) const {
+				if (!isObj() || (id >= m_node->size)) throw std::out_of_range("PValueView does not contain member.");
+				return PValueView(&m_node->value.members[id].value);
+			}
+
+			// //////////// //
+			// // Values // //
+			// //////////// //
+
+			std::string_view getStr() const {
+				if (isStr()) return std::string_view(m_node->value.str, m_node->size);
+				throw std::logic_error("PValueView does not contain a string.");
+			}
+
+			akc::Span<const uint8> getBin() const {
+				if (isBin()) return akc::Span<const uint8>(m_node->value.bin, m_node->size);
+				throw std::logic_error("PValueView does not contain binary data.");
+			}
+
+			PValue::sint_t getSInt() const {
+				if (isSInt()) return m_node->value.sint;
+				throw std::logic_error("PValueView does not contain a signed integer.");
+			}
+
+			PValue::uint_t getUInt() const {
+				if (isUInt()) return m_node->value.uint;
+				throw std::logic_error("PValueView does not contain an unsigned integer.");
+			}
+
+			PValue::dec_t getDec() const {
+				if (isDec()) return m_node->value.dec;
+				throw std::logic_error("PValueView does not contain a floating point number.");
+			}
+
+			PValue::bool_t getBool() const {
+				if (isBool()) return m_node->value.boolean;
+				throw std::logic_error("PValueView does not contain a boolean.");
+			}
+
+			/// Deep copies into a mutable tree
+			PValue toPValue() const;
+
+			// ////////// //
+			// // Info // //
+			// ////////// //
+
+			PType type() const { return m_node ? m_node->type : PType::Null; }
+
+			bool isNull() const { return type() == PType::Null; }
+			bool isObj()  const { return type() == PType::Object; }
+			bool isArr()  const { return type() == PType::Array; }
+			bool isStr()  const { return type() == PType::String; }
+			bool isSInt() const { return type() == PType::Signed; }
+			bool isUInt() const { return type() == PType::Unsigned; }
+			bool isDec()  const { return type() == PType::Decimal; }
+			bool isBool() const { return type() == PType::Boolean; }
+			bool isBin()  const { return type() == PType::Binary; }
+
+			bool isInteger() const { return isSInt() || isUInt(); }
+			bool isNumber() const { return isSInt() || isUInt() || isDec(); }
+			bool isPrimitive() const { return isSInt() || isUInt() || isDec() || isBool(); }
+
+			/// Entry count of arrays and objects, 0 otherwise
+			akSize size() const { return (isArr() || isObj()) ? m_node->size : 0; }
+
+			// //////////////// //
+			// // Conversion // //
+			// //////////////// //
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, std::string_view>::value || std::is_same<type_t, std::string>::value, std::optional<type_t>>::type tryAs() const { // String
+				return isStr() ? std::optional<type_t>(type_t(getStr())) : std::optional<type_t>();
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, PValue::bin_t>::value, std::optional<type_t>>::type tryAs() const { // Binary
+				if (!isBin()) return std::optional<type_t>();
+				auto data = getBin();
+				return type_t(data.begin(), data.end());
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_arithmetic<type_t>::value && !std::is_same<type_t, bool>::value, std::optional<type_t>>::type tryAs() const { // Number
+				if (isSInt()) return static_cast<type_t>(getSInt());
+				if (isUInt()) return static_cast<type_t>(getUInt());
+				if (isDec())  return static_cast<type_t>(getDec());
+				return std::optional<type_t>();
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, bool>::value, std::optional<type_t>>::type tryAs() const { // Boolean
+				if (isBool()) return getBool();
+				return std::optional<type_t>();
+			}
+
+			template<typename type_t> type_t as() const {
+				auto result = tryAs<type_t>();
+				if (!result) throw std::logic_error(akc::buildString("Failed to convert value from PValueView containing ", toDebugString()));
+				return *result;
+			}
+
+			template<typename type_t> type_t asOrDef(const type_t& val) const {
+				auto result = tryAs<type_t>();
+				if (!result) return val;
+				return *result;
+			}
+	};
+
+	/**
+	 * An immutable parse result held in a single arena, freed all at once.
+	 * Fill with the Document overloads of fromJson/fromMsgPack, parsing again reuses the memory.
+	 */
+	class Document final {
+		friend class DocumentBuilder;
+		private:
+			akc::MonotonicArena m_arena;
+			const internal::DocNode* m_root;
+
+		public:
+			Document() : m_arena(), m_root(nullptr) {}
+			Document(Document&&) = default;
+			Document& operator=(Document&&) = default;
+
+			PValueView root() const { return PValueView(m_root); }
+
+			void clear() { m_arena.reset(); m_root = nullptr; }
+
+			akSize memoryUsage() const { return m_arena.capacity(); }
+	};
+
+	/**
+	 * Event interface for parsers writing into a Document, containers are packed into the arena once they close.
+	 */
+	class DocumentBuilder final {
+		DocumentBuilder(const DocumentBuilder&) = delete;
+		DocumentBuilder& operator=(const DocumentBuilder&) = delete;
+		private:
+			struct Frame final {
+				akSize start;
+				std::string_view key;
+				bool isObject;
+			};
+
+			Document& m_document;
+			std::vector<internal::DocMember> m_pending;
+			std::vector<Frame> m_frames;
+			std::string_view m_key;
+			bool m_hasRoot;
+
+			void add(const internal::DocNode& node);
+			std::string_view copyString(std::string_view val);
+
+		public:
+			/// Clears the destination
+			explicit DocumentBuilder(Document& dest);
+
+			void setKey(std::string_view key);
+
+			void addNull();
+			void addBool(bool val);
+			void addSInt(int64 val);
+			void addUInt(uint64 val);
+			void addDec(fpDouble val);
+			void addStr(std::string_view val);
+			void addBin(const uint8* data, akSize size);
+
+			void startObject();
+			void endObject();
+			void startArray();
+			void endArray();
+
+			/// @return If exactly one complete value was written, otherwise the document is cleared
+			bool finish();
+	};
+}
+
+#endif
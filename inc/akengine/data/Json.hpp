@@ -17,11 +17,16 @@
 #ifndef AK_ENGINE_DATA_JSON_PVALUEPARSER_HPP_
 #define AK_ENGINE_DATA_JSON_PVALUEPARSER_HPP_
 
+#include <akengine/data/Document.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/filesystem/Path.hpp>
+#include <functional>
 #include <string>
 
 namespace akd {
+	class Reader;
+	class Writer;
+
 	/**
 	 * Attempts to serialize a PValue tree as a JSON string
 	 * @param src The source PValue tree
@@ -41,6 +46,43 @@ namespace akd {
 	bool toJsonFile(const akd::PValue& src, const akfs::Path& filepath, bool pretty = true, bool overwrite = true);
 
 	akd::PValue fromJsonFile(const akfs::Path& filepath);
+
+	/**
+	 * Attempts to deserialize a JSON string into an arena backed document, for read-only access
+	 * @param dest The target document, its memory is reused
+	 * @param jsonStr The json string to parse
+	 * @return If the JSON string was deserialized, otherwise dest is left empty
+	 */
+	bool fromJson(akd::Document& dest, const std::string& jsonStr);
+
+	bool fromJsonFile(akd::Document& dest, const akfs::Path& filepath);
+
+	/**
+	 * Streams JSON straight to a file through a Writer, without building a PValue tree
+	 * @param filepath The file to write
+	 * @param func Writes exactly one value
+	 * @param pretty Should the output be pretty (ie. new lines, tabs etc.)
+	 * @param overwrite Should an existing file be replaced, fails if it exists otherwise
+	 * @return If the file was fully written, on failure the destination is left untouched
+	 */
+	bool streamToJsonFile(const akfs::Path& filepath, const std::function<void(akd::Writer&)>& func, bool pretty = true, bool overwrite = true);
+
+	/**
+	 * Streams JSON straight from a file through a Reader, only the current token is held in memory
+	 * @param filepath The file to read
+	 * @param func Reads exactly one value, returning if it succeeded
+	 * @return The result of func, or false if the file could not be opened or was malformed
+	 */
+	bool streamFromJsonFile(const akfs::Path& filepath, const std::function<bool(akd::Reader&)>& func);
+
+	/// Requires the write/read overloads from Stream.hpp (or SmartClass.hpp) for type_t at the call site
+	template<typename type_t> bool streamToJsonFile(const type_t& src, const akfs::Path& filepath, bool pretty = true, bool overwrite = true) {
+		return streamToJsonFile(filepath, [&src](akd::Writer& writer){ write(writer, src); }, pretty, overwrite);
+	}
+
+	template<typename type_t> bool streamFromJsonFile(type_t& dst, const akfs::Path& filepath) {
+		return streamFromJsonFile(filepath, [&dst](akd::Reader& reader){ return read(reader, dst); });
+	}
 }
 
 #endif
@@ -18,16 +18,44 @@
 #define AK_ENGINE_DATA_MSGPACK_HPP_
 
 #include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/data/Document.hpp>
+#include <akengine/data/MsgPackView.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/filesystem/Path.hpp>
+#include <functional>
 #include <vector>
 
 namespace akd {
+	class Reader;
+	class Writer;
+
 	std::vector<uint8> toMsgPack(const akd::PValue& src);
 	bool fromMsgPack(akd::PValue& dest, const std::vector<uint8>& msgPackStream);
 
 	bool toMsgPackFile(const akd::PValue& src, const akfs::Path& filepath, bool compress = true, bool overwrite = true);
 	akd::PValue fromMsgPackFile(const akfs::Path& filepath, bool decompress);
+
+	/// Parses into an arena backed document for read-only access, dest's memory is reused
+	bool fromMsgPack(akd::Document& dest, const std::vector<uint8>& msgPackStream);
+	bool fromMsgPackFile(akd::Document& dest, const akfs::Path& filepath, bool decompress);
+
+	/// Indexes the file contents in place for lazy read-only access, values are only decoded when a view reads them
+	bool fromMsgPackFile(akd::MsgPackIndex& dest, const akfs::Path& filepath, bool decompress);
+
+	/// Streams MsgPack through a Writer without building a PValue tree, compressed output is buffered as bytes until the end.
+	/// Written to a temporary file first, so on failure an existing destination is left untouched.
+	bool streamToMsgPackFile(const akfs::Path& filepath, const std::function<void(akd::Writer&)>& func, bool compress = true, bool overwrite = true);
+	/// Streams MsgPack through a Reader, uncompressed files are read in blocks
+	bool streamFromMsgPackFile(const akfs::Path& filepath, const std::function<bool(akd::Reader&)>& func, bool decompress = true);
+
+	/// Requires the write/read overloads from Stream.hpp (or SmartClass.hpp) for type_t at the call site
+	template<typename type_t> bool streamToMsgPackFile(const type_t& src, const akfs::Path& filepath, bool compress = true, bool overwrite = true) {
+		return streamToMsgPackFile(filepath, [&src](akd::Writer& writer){ write(writer, src); }, compress, overwrite);
+	}
+
+	template<typename type_t> bool streamFromMsgPackFile(type_t& dst, const akfs::Path& filepath, bool decompress = true) {
+		return streamFromMsgPackFile(filepath, [&dst](akd::Reader& reader){ return read(reader, dst); }, decompress);
+	}
 }
 
 #endif
@@ -0,0 +1,212 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_ENGINE_DATA_MSGPACKVIEW_HPP_
+#define AK_ENGINE_DATA_MSGPACKVIEW_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akcommon/Span.hpp>
+#include <akcommon/String.hpp>
+#include <akengine/data/PValue.hpp>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace akd {
+
+	namespace internal {
+		/// Children of arrays and objects are a contiguous run in the index, objects store key then value
+		struct MsgPackNode final {
+			uint32 offset;   /// Start of the value in the buffer
+			uint32 children; /// First child in the index
+		};
+	}
+
+	/**
+	 * Read-only handle to a value inside a MsgPackIndex, only valid while the index and its buffer are alive.
+	 * Values are decoded from the buffer on access, strings and binary point straight into it.
+	 * Missing entries read as null, like PValueView.
+	 */
+	class MsgPackView final {
+		private:
+			const uint8* m_data;
+			const internal::MsgPackNode* m_nodes;
+			const internal::MsgPackNode* m_node;
+
+			MsgPackView child(akSize id) const { return MsgPackView(m_data, m_nodes, &m_nodes[m_node->children + id]); }
+
+			std::string toDebugString() const {
+				return isStr() ? akc::buildString("<str:", getStr(), ">") : akc::buildString("<type:", static_cast<uint32>(type()), ">");
+			}
+
+		public:
+			MsgPackView() : m_data(nullptr), m_nodes(nullptr), m_node(nullptr) {}
+			MsgPackView(const uint8* data, const internal::MsgPackNode* nodes, const internal::MsgPackNode* node) : m_data(data), m_nodes(nodes), m_node(node) {}
+
+			// //////////////// //
+			// // Navigation // //
+			// //////////////// //
+
+			/// Object keys are searched in stored order
+			MsgPackView atOrDef(std::string_view name) const;
+			MsgPackView atOrDef(akSize id) const { return exists(id) ? child(id) : MsgPackView(); }
+
+			MsgPackView at(std::string_view name) const {
+				auto result = atOrDef(name);
+				if (!result.m_node) throw std::out_of_range(akc::buildString("MsgPackView does not contain key: ", name));
+				return result;
+			}
+
+			MsgPackView at(akSize id) const {
+				if (!exists(id)) throw std::out_of_range(akc::buildString("MsgPackView does not contain index: ", id));
+				return child(id);
+			}
+
+			MsgPackView operator[](std::string_view name) const { return atOrDef(name); }
+			MsgPackView operator[](akSize id) const { return atOrDef(id); }
+
+			bool exists(std::string_view name) const { return atOrDef(name).m_node != nullptr; }
+			bool exists(akSize id) const { return isArr() && (id < size()); }
+
+			/// Object members in stored order, use with valueAt. Non-string keys read as empty.
+			std::string_view keyAt(akSize id) const {
+				if (!isObj() || (id >= size())) throw std::out_of_range("MsgPackView does not contain member.");
+				auto key = child(id*2);
+				return key.isStr() ? key.getStr() : std::string_view();
+			}
+
+			MsgPackView valueAt(akSize id) const {
+				if (!isObj() || (id >= size())) throw std::out_of_range("MsgPackView does not contain member.");
+				return child(id*2 + 1);
+			}
+
+			// //////////// //
+			// // Values // //
+			// //////////// //
+
+			/// Extension types read as strings, with the type byte first
+			std::string_view getStr() const;
+			akc::Span<const uint8> getBin() const;
+			PValue::sint_t getSInt() const;
+			PValue::uint_t getUInt() const;
+			PValue::dec_t getDec() const;
+			PValue::bool_t getBool() const;
+
+			/// Deep copies into a mutable tree
+			PValue toPValue() const;
+
+			// ////////// //
+			// // Info // //
+			// ////////// //
+
+			/// Non-negative integers are always unsigned, as with the PValue parser
+			PType type() const;
+
+			bool isNull() const { return type() == PType::Null; }
+			bool isObj()  const { return type() == PType::Object; }
+			bool isArr()  const { return type() == PType::Array; }
+			bool isStr()  const { return type() == PType::String; }
+			bool isSInt() const { return type() == PType::Signed; }
+			bool isUInt() const { return type() == PType::Unsigned; }
+			bool isDec()  const { return type() == PType::Decimal; }
+			bool isBool() const { return type() == PType::Boolean; }
+			bool isBin()  const { return type() == PType::Binary; }
+
+			bool isInteger() const { return isSInt() || isUInt(); }
+			bool isNumber() const { return isSInt() || isUInt() || isDec(); }
+			bool isPrimitive() const { return isSInt() || isUInt() || isDec() || isBool(); }
+
+			/// Entry count of arrays and objects, 0 otherwise
+			akSize size() const;
+
+			// //////////////// //
+			// // Conversion // //
+			// //////////////// //
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, std::string_view>::value || std::is_same<type_t, std::string>::value, std::optional<type_t>>::type tryAs() const { // String
+				return isStr() ? std::optional<type_t>(type_t(getStr())) : std::optional<type_t>();
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, PValue::bin_t>::value, std::optional<type_t>>::type tryAs() const { // Binary
+				if (!isBin()) return std::optional<type_t>();
+				auto data = getBin();
+				return type_t(data.begin(), data.end());
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_arithmetic<type_t>::value && !std::is_same<type_t, bool>::value, std::optional<type_t>>::type tryAs() const { // Number
+				switch(type()) {
+					case PType::Signed:   return static_cast<type_t>(getSInt());
+					case PType::Unsigned: return static_cast<type_t>(getUInt());
+					case PType::Decimal:  return static_cast<type_t>(getDec());
+					default: return std::optional<type_t>();
+				}
+			}
+
+			template<typename type_t> typename std::enable_if<std::is_same<type_t, bool>::value, std::optional<type_t>>::type tryAs() const { // Boolean
+				if (isBool()) return getBool();
+				return std::optional<type_t>();
+			}
+
+			template<typename type_t> type_t as() const {
+				auto result = tryAs<type_t>();
+				if (!result) throw std::logic_error(akc::buildString("Failed to convert value from MsgPackView containing ", toDebugString()));
+				return *result;
+			}
+
+			template<typename type_t> type_t asOrDef(const type_t& val) const {
+				auto result = tryAs<type_t>();
+				if (!result) return val;
+				return *result;
+			}
+	};
+
+	/**
+	 * Offset table over a MsgPack buffer, built in a single validating pass without decoding any values.
+	 * Fill with parse or fromMsgPackFile, parsing again reuses the table's memory.
+	 */
+	class MsgPackIndex final {
+		MsgPackIndex(const MsgPackIndex&) = delete;
+		MsgPackIndex& operator=(const MsgPackIndex&) = delete;
+		private:
+			std::vector<uint8> m_storage;
+			akc::Span<const uint8> m_data;
+			std::vector<internal::MsgPackNode> m_nodes;
+
+			bool build();
+
+		public:
+			MsgPackIndex() : m_storage(), m_data(), m_nodes() {}
+			MsgPackIndex(MsgPackIndex&&) = default;
+			MsgPackIndex& operator=(MsgPackIndex&&) = default;
+
+			/// The buffer is referenced, it must outlive the index and any views
+			bool parse(akc::Span<const uint8> data);
+
+			/// Takes ownership of the buffer
+			bool parse(std::vector<uint8>&& data);
+
+			MsgPackView root() const { return m_nodes.empty() ? MsgPackView() : MsgPackView(m_data.data(), m_nodes.data(), m_nodes.data()); }
+
+			void clear() { m_storage.clear(); m_data = akc::Span<const uint8>(); m_nodes.clear(); }
+
+			akSize memoryUsage() const { return static_cast<akSize>(m_storage.capacity() + m_nodes.capacity()*sizeof(internal::MsgPackNode)); }
+	};
+}
+
+#endif
@@ -17,6 +17,7 @@
 #ifndef AK_ENGINE_DATA_PVALUE_HPP_
 #define AK_ENGINE_DATA_PVALUE_HPP_
 
+#include <akcommon/FlatMap.hpp>
 #include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/String.hpp>
 #include <akengine/data/PVPath.hpp>
@@ -28,6 +29,7 @@
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -58,11 +60,15 @@ namespace akd {
 
 	void traversePValue(const PValue& cNode, const std::function<void(const PVPath& path, TraverseAction action, const PValue& value)>& callback);
 
+	/**
+	 * Objects and arrays are stored flat, so inserting into one invalidates references to its direct children.
+	 * Take references after the last insert into a parent, or navigate again.
+	 */
 	class PValue final {
 		public:
 			using null_t = std::nullptr_t;
-			using obj_t = std::map<std::string, PValue>;
-			using arr_t = std::deque<PValue>;
+			using obj_t = akc::FlatMap<std::string, PValue>;
+			using arr_t = std::vector<PValue>;
 			using str_t = std::string;
 			using sint_t = int64;
 			using uint_t = uint64;
@@ -96,6 +102,7 @@ namespace akd {
 			static const PValue* navigate_internal(const PValue* currentNode, const PVPath& path);
 
 			PValue& setPValue(const PValue& val);
+			void movePValue(PValue& val) noexcept;
 
 			std::string toDebugString() const {
 				if (isNull()) return "<null>";
@@ -115,10 +122,12 @@ namespace akd {
 
 			PValue() : m_type(PType::Null) {}
 			PValue(const PValue& val) : m_type(PType::Null) { setPValue(val); }
+			PValue(PValue&& val) noexcept : m_type(PType::Null) { movePValue(val); }
 
 			~PValue() { setNull(); }
 
 			PValue& operator=(const PValue& val) { setPValue(val); return *this; }
+			PValue& operator=(PValue&& val) noexcept { if (this != &val) { PValue tmp(std::move(val)); setNull().movePValue(tmp); } return *this; }
 
 			bool operator==(const PValue& o) const {
 				if (m_type != o.m_type) return false;
@@ -143,19 +152,22 @@ namespace akd {
 			// // Navigation // //
 			// //////////////// //
 
-			const PValue& at(const std::string& name) const {
+			const PValue& at(std::string_view name) const {
 				return getObj().at(name);
 			}
 
-			PValue& at(const std::string& name) {
+			PValue& at(std::string_view name) {
 				return getObj().at(name);
 			}
 
-			PValue& atOrSet(const std::string& name, const PValue& val = PValue()) {
-				return getObjOrSet().emplace(name, val).first->second;
+			PValue& atOrSet(std::string_view name, const PValue& val = PValue()) {
+				auto& obj = getObjOrSet();
+				auto iter = obj.find(name);
+				if (iter != obj.end()) return iter->second;
+				return obj.try_emplace(std::string(name), val).first->second;
 			}
 
-			const PValue& atOrDef(const std::string& name, const PValue& val = PValue()) const {
+			const PValue& atOrDef(std::string_view name, const PValue& val = PValue()) const {
 				if (!isObj()) return val;
 				auto iter = getObj().find(name);
 				return (iter == getObj().end()) ? val : iter->second;
@@ -180,14 +192,14 @@ namespace akd {
 				return (id < getArr().size()) ? getArr()[id] : val;
 			}
 
-			PValue& operator[](const std::string& name) { return atOrSet(name); }
+			PValue& operator[](std::string_view name) { return atOrSet(name); }
 			PValue& operator[](const akSize& id) { return atOrSet(id); }
 
 
-			bool exists(const std::string& name) const { return (isObj()) && (getObj().find(name) != getObj().end()); }
+			bool exists(std::string_view name) const { return (isObj()) && (getObj().find(name) != getObj().end()); }
 			bool exists(akSize id) const { return (isArr()) && (id < getArr().size()); }
 
-			const PValue& operator[](const std::string& name) const { return atOrDef(name); }
+			const PValue& operator[](std::string_view name) const { return atOrDef(name); }
 			const PValue& operator[](const akSize& id) const { return atOrDef(id); }
 
 			// ///////////// //
@@ -196,13 +208,17 @@ namespace akd {
 
 			PValue& setNull();
 			PValue& setObj(const obj_t& val = obj_t());
+			PValue& setObj(obj_t&& val);
 			PValue& setArr(const arr_t& val = arr_t());
+			PValue& setArr(arr_t&& val);
 			PValue& setStr(const str_t& val = str_t());
+			PValue& setStr(str_t&& val);
 			PValue& setSInt(const sint_t& val = sint_t());
 			PValue& setUInt(const uint_t& val = uint_t());
 			PValue& setDec(const dec_t& val = dec_t());
 			PValue& setBool(const bool_t& val =  bool_t());
 			PValue& setBin(const bin_t& val = bin_t());
+			PValue& setBin(bin_t&& val);
 			PValue& setBin(const void* val, akSize size);
 
 			obj_t&  getObj();
@@ -19,14 +19,19 @@
 
 #include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/String.hpp>
+#include <akengine/data/Document.hpp>
+#include <akengine/data/MsgPackView.hpp>
 #include <akengine/data/PValue.hpp>
+#include <akengine/filesystem/Path.hpp>
 #include <stddef.h>
 #include <array>
+#include <cstring>
 #include <deque>
 #include <map>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -98,6 +103,125 @@ namespace akd {
 	}
 }
 
+// /////////////// //
+// // POD Blobs // //
+// /////////////// //
+namespace akd {
+	/// Opt in with AK_SMART_CLASS_POD, vectors of the type are then stored as a single binary blob
+	template<typename type_t> struct isPODBlob : std::false_type {};
+
+	namespace internal {
+		/// The bytes of an element that belong to its fields, anything else is padding
+		struct PODLayout final {
+			struct Span final {
+				akSize offset;
+				akSize size;
+			};
+
+			std::vector<Span> spans; /// Sorted and merged once finished
+			bool padded;
+			std::string description; /// Name, offset, size and kind of every field, in declaration order
+			uint64 fingerprint;      /// Hash of the description
+		};
+
+		/**
+		 * Stands in for the destination PValue in the SmartClass serialize macros, to record where each field lives.
+		 * Nested SmartClass fields are walked with the same base, so every span is relative to the outermost element.
+		 * Nested names are prefixed with their parent's (ie. "surface.normal"), array elements share their field's name.
+		 */
+		struct FieldLayout final {
+			PODLayout& layout;
+			const uint8* base;
+			std::string prefix;
+			std::string name;
+			FieldLayout& operator[](const char* key) { name = key; return *this; }
+			FieldLayout& operator[](akSize) { return *this; }
+		};
+
+		template<typename type_t> constexpr char podKind() {
+			if constexpr (std::is_enum<type_t>::value) return 'e';
+			else if constexpr (std::is_same<type_t, bool>::value) return 'b';
+			else if constexpr (std::is_floating_point<type_t>::value) return 'f';
+			else if constexpr (std::is_signed<type_t>::value) return 'i';
+			else return 'u';
+		}
+
+		template<typename type_t> typename std::enable_if<std::is_arithmetic<type_t>::value || std::is_enum<type_t>::value>::type serialize(FieldLayout& fields, const type_t& src) {
+			auto offset = static_cast<akSize>(reinterpret_cast<const uint8*>(&src) - fields.base);
+			fields.layout.spans.push_back(PODLayout::Span{offset, static_cast<akSize>(sizeof(type_t))});
+			fields.layout.description += akc::buildString(fields.prefix, fields.name, ":", offset, ":", sizeof(type_t), ":", podKind<type_t>(), ";");
+		}
+
+		template<typename type_t, size_t l> void serialize(FieldLayout& fields, const std::array<type_t, l>& src) {
+			for(const auto& entry : src) serialize(fields, entry);
+		}
+
+		/// Anything else must be a SmartClass, AK_SMART_CLASS provides describeLayout
+		template<typename type_t> typename std::enable_if<!std::is_arithmetic<type_t>::value && !std::is_enum<type_t>::value>::type serialize(FieldLayout& fields, const type_t& src) {
+			auto prefix = fields.prefix;
+			fields.prefix += fields.name + ".";
+			describeLayout(fields, src);
+			fields.prefix = std::move(prefix);
+		}
+
+		/// Sorts and merges the spans, marks the layout as padded if they don't cover the whole element, then hashes the description
+		void finishPODLayout(PODLayout& layout, akSize elementSize);
+
+		template<typename type_t> const PODLayout& podLayout() {
+			static const PODLayout layout = []{
+				PODLayout result{{}, false, {}, 0};
+				type_t sample{};
+				FieldLayout fields{result, reinterpret_cast<const uint8*>(&sample), {}, {}};
+				describeLayout(fields, sample);
+				finishPODLayout(result, static_cast<akSize>(sizeof(type_t)));
+				return result;
+			}();
+			return layout;
+		}
+
+		/**
+		 * Resizes dst to hold a layout header followed by count elements.
+		 * @throw std::length_error If the blob wouldn't fit in 32-bits
+		 * @return Where the element data should be copied to
+		 */
+		uint8* startPODBlob(PValue::bin_t& dst, akSize elementSize, akSize elementAlign, uint64 fingerprint, size_t count);
+
+		/**
+		 * Checks the header against the element layout of this build.
+		 * @return The element data, or nullptr if the blob is malformed or was written with a different layout or byte order
+		 */
+		const uint8* checkPODBlob(const uint8* data, akSize size, akSize elementSize, akSize elementAlign, uint64 fingerprint, akSize& count);
+
+		/// Padding is written as zeros, so the output only depends on the field values
+		template<typename type_t> void serializePODBlob(PValue::bin_t& dst, const type_t* src, size_t count) {
+			const auto& layout = podLayout<type_t>();
+			auto elements = startPODBlob(dst, sizeof(type_t), alignof(type_t), layout.fingerprint, count);
+			if (count == 0) return;
+
+			if (!layout.padded) {
+				std::memcpy(elements, src, count*sizeof(type_t));
+				return;
+			}
+
+			std::memset(elements, 0, count*sizeof(type_t));
+			for(size_t i = 0; i < count; i++) {
+				auto element = reinterpret_cast<const uint8*>(&src[i]);
+				for(const auto& span : layout.spans) std::memcpy(elements + i*sizeof(type_t) + span.offset, element + span.offset, span.size);
+			}
+		}
+
+		template<typename type_t, typename alloc_t> bool deserializePODBlob(std::vector<type_t, alloc_t>& dst, const uint8* data, akSize size) {
+			akSize count = 0;
+			auto elements = checkPODBlob(data, size, sizeof(type_t), alignof(type_t), podLayout<type_t>().fingerprint, count);
+			if (!elements) return false;
+			std::vector<type_t, alloc_t> result(count);
+			if (count > 0) std::memcpy(result.data(), elements, count*sizeof(type_t));
+			dst = std::move(result);
+			return true;
+		}
+	}
+}
+
 // ///////// //
 // // STL // //
 // ///////// //
@@ -105,6 +229,12 @@ namespace akd {
 // Vector
 namespace akd {
 	template<typename type_t, typename alloc_t> void serialize(akd::PValue& dst, const std::vector<type_t, alloc_t>& val) {
+		if constexpr (isPODBlob<type_t>::value) {
+			if (!dst.isBin()) dst.setBin();
+			internal::serializePODBlob(dst.getBin(), val.data(), val.size());
+			return;
+		}
+
 		if (!dst.isArr()) dst.setArr();
 		for(akSize i = 0; i < val.size(); i++) {
 			serialize(dst[i], val[i]);
@@ -112,6 +242,10 @@ namespace akd {
 	}
 
 	template<typename type_t, typename alloc_t> bool deserialize(std::vector<type_t, alloc_t>& dst, const akd::PValue& val) {
+		if constexpr (isPODBlob<type_t>::value) {
+			if (val.isBin()) return internal::deserializePODBlob(dst, val.getBin().data(), static_cast<akSize>(val.getBin().size()));
+		}
+
 		if (!val.isArr()) return false;
 		std::vector<type_t, alloc_t> result;
 		for(akSize i = 0; i < val.size(); i++) {
@@ -358,4 +492,121 @@ namespace akd {
 	inline bool deserialize(PValue::bool_t& dst, const PValue& src) { return internal::methodDeserialize(dst, src); }
 }
 
+// //////////////// //
+// // PValueView // //
+// //////////////// //
+namespace akd {
+	namespace internal {
+		template<typename type_t> bool methodDeserialize(type_t& dst, const PValueView& src) {
+			auto tmp = src.tryAs<type_t>();
+			if (tmp) dst = *tmp;
+			return tmp.has_value();
+		}
+	}
+
+	// Types without a view overload (SmartClass and SmartEnum provide one) are read by copying out just their subtree
+	template<typename type_t> bool deserialize(type_t& dst, const PValueView& src) { return deserialize(dst, src.toPValue()); }
+
+	// Blobs are copied straight out of the document, anything else takes the fallback
+	template<typename type_t, typename alloc_t> bool deserialize(std::vector<type_t, alloc_t>& dst, const PValueView& src) {
+		if constexpr (isPODBlob<type_t>::value) {
+			if (src.isBin()) return internal::deserializePODBlob(dst, src.getBin().data(), static_cast<akSize>(src.getBin().size()));
+		}
+		return deserialize(dst, src.toPValue());
+	}
+
+	inline bool deserialize(PValue::bin_t& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(PValue::str_t& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(int8&  dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int16& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int32& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int64& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(uint8&  dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint16& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint32& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint64& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(fpSingle& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(fpDouble& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(PValue::bool_t& dst, const PValueView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(akfs::Path& dst, const PValueView& src) {
+		if (!src.isStr()) return false;
+		dst = akfs::Path(std::string(src.getStr()));
+		return true;
+	}
+
+	template<typename type_t> std::optional<type_t> tryDeserialize(const PValueView& root) {
+		type_t result;
+		return deserialize(result, root) ?  std::optional<type_t>{result} :  std::optional<type_t>{};
+	}
+
+	template<typename type_t> type_t deserialize(const PValueView& root) {
+		auto result = tryDeserialize<type_t>(root);
+		if (result) return *result;
+		else throw std::logic_error("Failed to deserialize value.");
+	}
+}
+
+// ///////////////// //
+// // MsgPackView // //
+// ///////////////// //
+namespace akd {
+	namespace internal {
+		template<typename type_t> bool methodDeserialize(type_t& dst, const MsgPackView& src) {
+			auto tmp = src.tryAs<type_t>();
+			if (tmp) dst = *tmp;
+			return tmp.has_value();
+		}
+	}
+
+	// As with PValueView, types without a view overload copy out just their subtree
+	template<typename type_t> bool deserialize(type_t& dst, const MsgPackView& src) { return deserialize(dst, src.toPValue()); }
+
+	template<typename type_t, typename alloc_t> bool deserialize(std::vector<type_t, alloc_t>& dst, const MsgPackView& src) {
+		if constexpr (isPODBlob<type_t>::value) {
+			if (src.isBin()) return internal::deserializePODBlob(dst, src.getBin().data(), src.getBin().size());
+		}
+		return deserialize(dst, src.toPValue());
+	}
+
+	inline bool deserialize(PValue::bin_t& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(PValue::str_t& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(int8&  dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int16& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int32& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(int64& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(uint8&  dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint16& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint32& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(uint64& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(fpSingle& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+	inline bool deserialize(fpDouble& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(PValue::bool_t& dst, const MsgPackView& src) { return internal::methodDeserialize(dst, src); }
+
+	inline bool deserialize(akfs::Path& dst, const MsgPackView& src) {
+		if (!src.isStr()) return false;
+		dst = akfs::Path(std::string(src.getStr()));
+		return true;
+	}
+
+	template<typename type_t> std::optional<type_t> tryDeserialize(const MsgPackView& root) {
+		type_t result;
+		return deserialize(result, root) ?  std::optional<type_t>{result} :  std::optional<type_t>{};
+	}
+
+	template<typename type_t> type_t deserialize(const MsgPackView& root) {
+		auto result = tryDeserialize<type_t>(root);
+		if (result) return *result;
+		else throw std::logic_error("Failed to deserialize value.");
+	}
+}
+
 #endif /* AK_ENGINE_DATA_SERIALIZE_HPP_ */
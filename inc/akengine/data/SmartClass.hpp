@@ -19,7 +19,9 @@
 #include <akcommon/Macro.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/Serialize.hpp>
+#include <akengine/data/Stream.hpp>
 #include <akengine/debug/Log.hpp>
+#include <type_traits>
 
 #define AK_SMART_CLASS_SERIALIZE_FIELD(fieldName) serialize(dst[#fieldName], src.fieldName);
 
@@ -852,6 +854,34 @@
 			AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_DESERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(qualifiedClass, __VA_ARGS__) \
 			return true; \
 		} \
+		inline bool deserialize(qualifiedClass& dst, const akd::PValueView& src) { \
+			AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_DESERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(qualifiedClass, __VA_ARGS__) \
+			return true; \
+		} \
+		inline bool deserialize(qualifiedClass& dst, const akd::MsgPackView& src) { \
+			AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_DESERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(qualifiedClass, __VA_ARGS__) \
+			return true; \
+		} \
+		inline void write(akd::Writer& writer, const qualifiedClass& src) { \
+			akd::internal::FieldCounter counter{0}; \
+			{ auto& dst = counter; AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_SERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(__VA_ARGS__) } \
+			akd::internal::FieldWriter fields{writer}; \
+			writer.startObject(counter.count); \
+			{ auto& dst = fields; AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_SERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(__VA_ARGS__) } \
+			writer.endObject(); \
+		} \
+		inline bool read(akd::Reader& reader, qualifiedClass& dst) { \
+			if (reader.peek() != akd::PType::Object) return akd::internal::readViaPValue(reader, dst); \
+			return akd::internal::readFields(reader, [&dst](akd::internal::FieldReader& src) -> bool { \
+				AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_DESERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(qualifiedClass, __VA_ARGS__) \
+				return true; \
+			}); \
+		} \
+		namespace internal { \
+			template<typename layout_t> void describeLayout(layout_t& dst, const qualifiedClass& src) { \
+				AK_CONCATENATE(AK_CONCATENATE(AK_SMART_CLASS_SERIALIZE_, nextOp), AK_NARGS(__VA_ARGS__))(__VA_ARGS__) \
+			} \
+		} \
 		template<> constexpr akd::PType serializesTo<qualifiedClass>() { return PType::Object; } \
 	}
 
@@ -875,7 +905,69 @@
 			dst = result; \
 			return true; \
 		} \
+		inline bool deserialize(qualifiedClass& dst, const akd::PValueView& src) { \
+			if (!src.isArr()) return false; \
+			qualifiedClass result; \
+			for(decltype(size) i = 0; i < size; i++) { \
+				if (!deserialize(result[i], src[static_cast<akSize>(i)])) { \
+					akl::Logger(#qualifiedClass).error("Failed to deserialize entry: ", i); \
+					return false; \
+				} \
+			} \
+			dst = result; \
+			return true; \
+		} \
+		inline bool deserialize(qualifiedClass& dst, const akd::MsgPackView& src) { \
+			if (!src.isArr()) return false; \
+			qualifiedClass result; \
+			for(decltype(size) i = 0; i < size; i++) { \
+				if (!deserialize(result[i], src[static_cast<akSize>(i)])) { \
+					akl::Logger(#qualifiedClass).error("Failed to deserialize entry: ", i); \
+					return false; \
+				} \
+			} \
+			dst = result; \
+			return true; \
+		} \
+		inline void write(akd::Writer& writer, const qualifiedClass& src) { \
+			writer.startArray(static_cast<akSize>(size)); \
+			for(decltype(size) i = 0; i < size; i++) write(writer, src[i]); \
+			writer.endArray(); \
+		} \
+		inline bool read(akd::Reader& reader, qualifiedClass& dst) { \
+			if (reader.peek() != akd::PType::Array) return akd::internal::readViaPValue(reader, dst); \
+			qualifiedClass result; \
+			reader.startArray(); \
+			for(decltype(size) i = 0; i < size; i++) { \
+				if (!reader.nextElement()) { \
+					akl::Logger(#qualifiedClass).error("Missing entry: ", i); \
+					return false; \
+				} \
+				if (!read(reader, result[i])) { \
+					akl::Logger(#qualifiedClass).error("Failed to deserialize entry: ", i); \
+					akd::internal::drainArray(reader); \
+					return false; \
+				} \
+			} \
+			akd::internal::drainArray(reader); \
+			dst = result; \
+			return true; \
+		} \
+		namespace internal { \
+			template<typename layout_t> void describeLayout(layout_t& dst, const qualifiedClass& src) { \
+				for(decltype(size) i = 0; i < size; i++) serialize(dst, src[i]); \
+			} \
+		} \
 		template<> constexpr akd::PType serializesTo<qualifiedClass>() { return PType::Array; } \
 	}
 
+// Vectors of the class are stored as one binary blob of its in-memory layout, single values are unaffected
+// The class must be declared with AK_SMART_CLASS(_ARRAY) first, its field list decides which bytes are written and padding is zeroed
+#define AK_SMART_CLASS_POD(qualifiedClass) \
+	static_assert(std::is_trivially_copyable<qualifiedClass>::value, #qualifiedClass " must be trivially copyable to be stored as a blob."); \
+	static_assert(std::is_default_constructible<qualifiedClass>::value, #qualifiedClass " must be default constructible to be stored as a blob."); \
+	namespace akd { \
+		template<> struct isPODBlob<qualifiedClass> : std::true_type {}; \
+	}
+
 #endif /* AK_ENGINE_DATA_SMARTCLASS_HPP_ */
@@ -20,6 +20,7 @@
 #include <akcommon/Macro.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/Serialize.hpp>
+#include <akengine/data/Stream.hpp>
 
 #define AK_INTERNAL_ENUM_KV_2( x, y) x = y,
 #define AK_INTERNAL_ENUM_KV_4( x, y, ...) x = y, AK_INTERNAL_ENUM_KV_2( __VA_ARGS__)
@@ -461,6 +462,23 @@
 			catch(const ::std::logic_error&) { return false; } \
 			return true; \
 		} \
+		inline bool deserialize(::qualification::enumName& dst, const akd::PValueView& val) { \
+			try { dst = ::qualification::se_internal::convert##StringTo##enumName(val.getStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
+		inline bool deserialize(::qualification::enumName& dst, const akd::MsgPackView& val) { \
+			try { dst = ::qualification::se_internal::convert##StringTo##enumName(val.getStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
+		inline void write(akd::Writer& writer, const ::qualification::enumName& val) { writer.writeStr(::qualification::se_internal::convert##enumName##ToStringView(val)); } \
+		inline bool read(akd::Reader& reader, ::qualification::enumName& dst) { \
+			if (reader.peek() != akd::PType::String) { reader.skip(); return false; } \
+			try { dst = ::qualification::se_internal::convert##StringTo##enumName(reader.readStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
 		template<> constexpr akd::PType serializesTo<::qualification::enumName>() { return PType::String; } \
 	}
 
@@ -473,6 +491,23 @@
 			catch(const ::std::logic_error&) { return false; } \
 			return true; \
 		} \
+		inline bool deserialize(::enumName& dst, const akd::PValueView& val) { \
+			try { dst = ::se_internal::convert##StringTo##enumName(val.getStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
+		inline bool deserialize(::enumName& dst, const akd::MsgPackView& val) { \
+			try { dst = ::se_internal::convert##StringTo##enumName(val.getStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
+		inline void write(akd::Writer& writer, const ::enumName& val) { writer.writeStr(::se_internal::convert##enumName##ToStringView(val)); } \
+		inline bool read(akd::Reader& reader, ::enumName& dst) { \
+			if (reader.peek() != akd::PType::String) { reader.skip(); return false; } \
+			try { dst = ::se_internal::convert##StringTo##enumName(reader.readStr()); } \
+			catch(const ::std::logic_error&) { return false; } \
+			return true; \
+		} \
 		template<> constexpr akd::PType serializesTo<::qualification::enumName>() { return PType::String; } \
 	}
 
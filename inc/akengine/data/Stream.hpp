@@ -0,0 +1,368 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_ENGINE_DATA_STREAM_HPP_
+#define AK_ENGINE_DATA_STREAM_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akcommon/Span.hpp>
+#include <akengine/data/PValue.hpp>
+#include <akengine/data/Serialize.hpp>
+#include <stddef.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ///////////////// //
+// // Interfaces // //
+// ///////////////// //
+namespace akd {
+	/**
+	 * SAX-style output, values are written in order without building a PValue tree.
+	 * Containers are sized up front as MsgPack needs the count before the entries.
+	 */
+	class Writer {
+		public:
+			virtual ~Writer() = default;
+
+			virtual void writeNull() = 0;
+			virtual void writeBool(bool val) = 0;
+			virtual void writeSInt(int64 val) = 0;
+			virtual void writeUInt(uint64 val) = 0;
+			virtual void writeDec(fpDouble val) = 0;
+			virtual void writeStr(std::string_view val) = 0;
+			virtual void writeBin(const uint8* data, akSize size) = 0;
+
+			virtual void startArray(akSize size) = 0;
+			virtual void endArray() = 0;
+
+			/// Each entry is a writeKey followed by one value
+			virtual void startObject(akSize size) = 0;
+			virtual void writeKey(std::string_view key) = 0;
+			virtual void endObject() = 0;
+	};
+
+	/**
+	 * Pull-style input, consumed one value at a time.
+	 * Malformed input throws std::runtime_error, reading a value as the wrong type throws std::logic_error.
+	 */
+	class Reader {
+		public:
+			virtual ~Reader() = default;
+
+			/// The type of the next value, without consuming it
+			virtual PType peek() = 0;
+
+			virtual void readNull() = 0;
+			virtual bool readBool() = 0;
+			virtual int64 readSInt() = 0;
+			virtual uint64 readUInt() = 0;
+			virtual fpDouble readDec() = 0;
+			virtual std::string_view readStr() = 0;          /// Valid until the next call
+			virtual akc::Span<const uint8> readBin() = 0;   /// Valid until the next call
+
+			/// @return The entry count if the format stores it up front, otherwise 0
+			virtual akSize startArray() = 0;
+			/// @return False once the array is exhausted, consuming its end
+			virtual bool nextElement() = 0;
+
+			virtual akSize startObject() = 0;
+			/// @param key Set to the next member's key, valid until the next call
+			/// @return False once the object is exhausted, consuming its end
+			virtual bool nextKey(std::string_view& key) = 0;
+
+			/// Consumes the next value, including everything nested in it
+			void skip();
+	};
+
+	/**
+	 * The read overloads always consume exactly one value, even when they fail.
+	 * That keeps the reader in step so the caller can fall back to a default and carry on.
+	 */
+	void write(Writer& writer, const PValue& src);
+	bool read(Reader& reader, PValue& dst);
+}
+
+// ////////////// //
+// // Internal // //
+// ////////////// //
+namespace akd {
+	namespace internal {
+		template<typename type_t> bool readViaPValue(Reader& reader, type_t& dst) {
+			PValue tmp;
+			read(reader, tmp);
+			return deserialize(dst, std::as_const(tmp));
+		}
+
+		/// Stored counts come from the input, so only trust them up to a point and let larger containers grow as they're read
+		inline akSize reserveHint(akSize count) { return std::min<akSize>(count, 4096); }
+
+		inline void drainArray(Reader& reader) { while(reader.nextElement()) reader.skip(); }
+		inline void drainObject(Reader& reader) { std::string_view key; while(reader.nextKey(key)) reader.skip(); }
+
+		/// Stands in for the destination PValue in the SmartClass serialize macros, to count the fields
+		struct FieldCounter final {
+			akSize count;
+			FieldCounter& operator[](const char*) { return *this; }
+		};
+
+		/// Stands in for the destination PValue in the SmartClass serialize macros, to write each field in turn
+		struct FieldWriter final {
+			Writer& writer;
+			FieldWriter& operator[](const char* key) { writer.writeKey(key); return *this; }
+		};
+
+		/**
+		 * Stands in for the source PValue in the SmartClass deserialize macros.
+		 * The macros are run once per key read, matching at most one field, then once more for the fields that never appeared.
+		 */
+		struct FieldReader final {
+			struct Entry final {
+				FieldReader* fields;
+				const char* name;
+			};
+
+			Reader& reader;
+			std::string_view key;
+			bool matched;
+			bool missingPass;
+			std::vector<const char*> seen;
+
+			explicit FieldReader(Reader& fieldReader) : reader(fieldReader), key(), matched(false), missingPass(false), seen() {}
+
+			Entry atOrDef(const char* name) { return Entry{this, name}; }
+
+			bool wasSeen(const char* name) const {
+				for(auto seenName : seen) if (std::strcmp(seenName, name) == 0) return true;
+				return false;
+			}
+		};
+
+		template<typename func_t> bool readFields(Reader& reader, const func_t& func) {
+			FieldReader fields(reader);
+			reader.startObject();
+			while(reader.nextKey(fields.key)) {
+				fields.matched = false;
+				if (!func(fields)) {
+					drainObject(reader);
+					return false;
+				}
+				if (!fields.matched) reader.skip();
+			}
+			fields.missingPass = true;
+			return func(fields);
+		}
+	}
+
+	template<typename type_t> void serialize(internal::FieldCounter& fields, const type_t&) {
+		fields.count++;
+	}
+
+	template<typename type_t> void serialize(internal::FieldWriter& fields, const type_t& src) {
+		write(fields.writer, src);
+	}
+
+	template<typename type_t> bool deserialize(type_t& dst, internal::FieldReader::Entry field) {
+		auto& fields = *field.fields;
+		if (fields.missingPass) return fields.wasSeen(field.name) || deserialize(dst, akd::PValue()); // Absent fields read as null, like PValue::atOrDef
+		if (fields.matched || (fields.key != field.name)) return true;
+		fields.matched = true;
+		fields.seen.push_back(field.name);
+		return read(fields.reader, dst);
+	}
+}
+
+// //////////////// //
+// // Primitives // //
+// //////////////// //
+namespace akd {
+	namespace internal {
+		template<typename type_t> void methodWrite(Writer& writer, const type_t& src) {
+			if constexpr (std::is_same<type_t, bool>::value) writer.writeBool(src);
+			else if constexpr (std::is_floating_point<type_t>::value) writer.writeDec(src);
+			else if constexpr (std::is_signed<type_t>::value) writer.writeSInt(src);
+			else writer.writeUInt(src);
+		}
+
+		/// Same conversions as PValue::tryAs
+		template<typename type_t> bool methodRead(Reader& reader, type_t& dst) {
+			auto type = reader.peek();
+			if constexpr (std::is_same<type_t, bool>::value) {
+				if (type == PType::Boolean) { dst = reader.readBool(); return true; }
+			} else {
+				switch(type) {
+					case PType::Signed:   dst = static_cast<type_t>(reader.readSInt()); return true;
+					case PType::Unsigned: dst = static_cast<type_t>(reader.readUInt()); return true;
+					case PType::Decimal:  dst = static_cast<type_t>(reader.readDec());  return true;
+					default: break;
+				}
+			}
+			reader.skip();
+			return false;
+		}
+	}
+
+	inline void write(Writer& writer, const PValue::str_t& src) { writer.writeStr(src); }
+	inline bool read(Reader& reader, PValue::str_t& dst) {
+		if (reader.peek() == PType::String) { dst = reader.readStr(); return true; }
+		reader.skip();
+		return false;
+	}
+
+	inline void write(Writer& writer, const PValue::bin_t& src) { writer.writeBin(src.data(), static_cast<akSize>(src.size())); }
+	inline bool read(Reader& reader, PValue::bin_t& dst) {
+		if (reader.peek() == PType::Binary) { auto data = reader.readBin(); dst.assign(data.begin(), data.end()); return true; }
+		reader.skip();
+		return false;
+	}
+
+	inline void write(Writer& writer, const int8&  src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, int8&  dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const int16& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, int16& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const int32& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, int32& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const int64& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, int64& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const uint8&  src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, uint8&  dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const uint16& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, uint16& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const uint32& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, uint32& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const uint64& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, uint64& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const fpSingle& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, fpSingle& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const fpDouble& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, fpDouble& dst) { return internal::methodRead(reader, dst); }
+
+	inline void write(Writer& writer, const PValue::bool_t& src) { internal::methodWrite(writer, src); }
+	inline bool read(Reader& reader, PValue::bool_t& dst) { return internal::methodRead(reader, dst); }
+}
+
+// ///////// //
+// // STL // //
+// ///////// //
+namespace akd {
+	// Vector
+	template<typename type_t, typename alloc_t> void write(Writer& writer, const std::vector<type_t, alloc_t>& src) {
+		if constexpr (isPODBlob<type_t>::value) {
+			PValue::bin_t blob;
+			internal::serializePODBlob(blob, src.data(), src.size());
+			writer.writeBin(blob.data(), static_cast<akSize>(blob.size()));
+			return;
+		}
+
+		writer.startArray(static_cast<akSize>(src.size()));
+		for(const auto& entry : src) write(writer, entry);
+		writer.endArray();
+	}
+
+	template<typename type_t, typename alloc_t> bool read(Reader& reader, std::vector<type_t, alloc_t>& dst) {
+		if constexpr (isPODBlob<type_t>::value) {
+			if (reader.peek() == PType::Binary) {
+				auto blob = reader.readBin();
+				return internal::deserializePODBlob(dst, blob.data(), blob.size());
+			}
+		}
+
+		if (reader.peek() != PType::Array) { reader.skip(); return false; }
+		std::vector<type_t, alloc_t> result;
+		result.reserve(internal::reserveHint(reader.startArray()));
+		while(reader.nextElement()) {
+			result.emplace_back();
+			if (!read(reader, result.back())) {
+				internal::logError("Vector", "Failed to deserialize entry: ", result.size() - 1);
+				internal::drainArray(reader);
+				return false;
+			}
+		}
+		dst = std::move(result);
+		return true;
+	}
+
+	// Array
+	template<typename type_t, size_t l> void write(Writer& writer, const std::array<type_t, l>& src) {
+		writer.startArray(static_cast<akSize>(l));
+		for(const auto& entry : src) write(writer, entry);
+		writer.endArray();
+	}
+
+	template<typename type_t, size_t l> bool read(Reader& reader, std::array<type_t, l>& dst) {
+		if (reader.peek() != PType::Array) { reader.skip(); return false; }
+		std::array<type_t, l> result;
+		reader.startArray();
+		for(size_t i = 0; i < l; i++) {
+			if (!reader.nextElement()) {
+				internal::logError("Array", "Missing entry: ", i);
+				return false;
+			}
+			if (!read(reader, result[i])) {
+				internal::logError("Array", "Failed to deserialize entry: ", i);
+				internal::drainArray(reader);
+				return false;
+			}
+		}
+		internal::drainArray(reader);
+		dst = std::move(result);
+		return true;
+	}
+
+	// Optional
+	template<typename type_t> void write(Writer& writer, const std::optional<type_t>& src) {
+		if (!src) writer.writeNull();
+		else write(writer, *src);
+	}
+
+	template<typename type_t> bool read(Reader& reader, std::optional<type_t>& dst) {
+		if (reader.peek() == PType::Null) {
+			reader.readNull();
+			dst = {};
+			return true;
+		}
+		type_t tmpVal;
+		if (!read(reader, tmpVal)) return false;
+		dst = std::move(tmpVal);
+		return true;
+	}
+}
+
+// ////////////// //
+// // Fallback // //
+// ////////////// //
+namespace akd {
+	// Types without a streaming overload go through their PValue serialization, building only their own subtree
+	template<typename type_t> void write(Writer& writer, const type_t& src) { write(writer, serialize(src)); }
+	template<typename type_t> bool read(Reader& reader, type_t& dst) { return internal::readViaPValue(reader, dst); }
+}
+
+#endif
@@ -23,12 +23,25 @@
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/SmartEnum.hpp>
 #include <akengine/thread/CurrentThread.hpp>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <cwchar>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Least severe level that is compiled in, as the numeric akl::Level value. Calls for less severe levels compile to nothing.
+#ifndef AK_LOG_MIN_LEVEL
+#define AK_LOG_MIN_LEVEL 6
+#endif
 
 namespace akl {
 	AK_SMART_TENUM_CLASS_KV(Level, uint8,
@@ -41,6 +54,34 @@ namespace akl {
 		Debug, 6
 	)
 
+	constexpr bool isLevelCompiled(Level logLevel) { return static_cast<uint8>(logLevel) <= AK_LOG_MIN_LEVEL; }
+
+	namespace internal {
+		/// Least severe level enabled for any output, kept in sync by setConsoleLevel and setFileLevel
+		inline std::atomic<uint8> enabledLevel = static_cast<uint8>(Level::Debug);
+	}
+
+	/**
+	 * Wraps a callable so it's only invoked if the message is actually formatted, e.g. log.debug("Stats: ", akl::lazy([&]{ return expensive(); }))
+	 */
+	template<typename func_t> struct Lazy {
+		func_t func;
+	};
+
+	template<typename func_t> Lazy<func_t> lazy(func_t func) { return Lazy<func_t>{std::move(func)}; }
+
+	template<typename func_t> std::ostream& operator<<(std::ostream& stream, const Lazy<func_t>& value) { return stream << value.func(); }
+
+	/**
+	 * A named value attached to a message, written as a separate field by structured outputs, e.g. log.info("Loaded", akl::field("ms", elapsed))
+	 */
+	template<typename type_t> struct Field {
+		std::string_view key;
+		const type_t& value;
+	};
+
+	template<typename type_t> Field<type_t> field(const std::string_view& key, const type_t& value) { return Field<type_t>{key, value}; }
+
 	class Logger final {
 		private:
 			std::string_view m_name;
@@ -80,9 +121,21 @@ namespace akl {
 
 	void processMessageQueue();
 
+	/**
+	 * Processes every queued message and writes buffered file output to disk, for shutdown and fatal paths.
+	 */
+	void flush();
+
 	bool enableFileOutput();
 	void disableFileOutput();
 
+	/**
+	 * Writes every record as a line of JSON to data/logs/log_<time>.jsonl, filtered by the file level.
+	 * Keys: level, time, wallNS, monoNS, threadID, thread, logger, message and, if any were given, fields.
+	 */
+	bool enableJsonOutput();
+	void disableJsonOutput();
+
 	void setConsoleLevel(Level logLevel);
 	bool isConsoleFilterLevelEnabled(Level logLevel);
 	Level getConsoleFilterLevel();
@@ -91,7 +144,16 @@ namespace akl {
 	bool isFileFilterLevelEnabled(Level logLevel);
 	Level getFileFilterLevel();
 
-	bool isFilterLevelEnabled(Level logLevel);
+	inline bool isFilterLevelEnabled(Level logLevel) {
+		return isLevelCompiled(logLevel) && (static_cast<uint8>(logLevel) <= internal::enabledLevel.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * When enabled, messages are queued as raw arguments in a per-thread ring and formatted on the log thread.
+	 * Fatal messages, and messages that don't fit in the ring, are always formatted immediately.
+	 */
+	void setDeferredFormatting(bool enabled);
+	bool isDeferredFormatting();
 
 	void captureStandardStreams();
 	void restoreStandardStreams();
@@ -104,24 +166,202 @@ AK_SMART_ENUM_SERIALIZE(akl, Level)
  * ****************** */
 namespace akl {
 	namespace internal {
+		struct RecordField {
+			std::string key;
+			std::string value;
+			bool literal; /// The value is a JSON number or boolean rather than a string
+		};
+
+		/// A message and its context, formatted for each output on the log thread
+		struct Record {
+			Level level;
+			int64 wallTime;      /// System clock nanoseconds
+			int64 monotonicTime; /// Steady clock nanoseconds
+			uint64 sequence;     /// Per thread, orders a thread's records logged within the same clock tick
+			uint64 threadID;
+			std::string threadName;
+			std::string logName;
+			std::string message;
+			std::vector<RecordField> fields;
+		};
+
+		struct MessageBuilder {
+			std::stringstream message;
+			std::vector<RecordField> fields;
+		};
+
 		void printMessage(Level logLevel, const std::string& str);
+		void printRecord(Record&& record);
+
+		inline int64 wallTimeNS() { return static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()); }
+		inline int64 monotonicTimeNS() { return static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()); }
+		inline uint64 nextSequence() { thread_local uint64 sequence = 0; return sequence++; }
+
+		template<typename type_t> RecordField makeField(const std::string_view& key, const type_t& value) {
+			if constexpr (std::is_same_v<type_t, bool>) {
+				return RecordField{std::string(key), value ? "true" : "false", true};
+			} else if constexpr (std::is_arithmetic_v<type_t> && !std::is_same_v<type_t, char>) {
+				bool finite = true;
+				if constexpr (std::is_floating_point_v<type_t>) finite = (value >= std::numeric_limits<type_t>::lowest()) && (value <= std::numeric_limits<type_t>::max());
+				std::stringstream sstream;
+				sstream << +value;
+				return RecordField{std::string(key), sstream.str(), finite};
+			} else {
+				return RecordField{std::string(key), akc::buildString(value), false};
+			}
+		}
+
+		template<typename type_t> void appendArg(MessageBuilder& builder, const type_t& value) { akc::buildString(builder.message, value); }
+		template<typename type_t> void appendArg(MessageBuilder& builder, const Field<type_t>& field) { builder.fields.push_back(makeField(field.key, field.value)); }
 
 		template<typename... vargs_t> void build(Level level, const std::string_view& logName, const vargs_t&... vargs) {
-			auto utc = akc::utcTimestamp();
+			MessageBuilder builder;
+			(appendArg(builder, vargs), ...);
 
-			std::stringstream sstream;
-			sstream << "[" << std::put_time(&utc.ctime, "%H:%M:%S");
-			sstream << "." << std::setfill('0') << std::setw(3) << utc.milliseconds;
-			sstream  << "][" << akt::current().name() << "][" << logName << "][" << Logger::LevelTags[static_cast<uint8>(level)] << "]";
+			auto& thread = akt::current();
+			printRecord(Record{level, wallTimeNS(), monotonicTimeNS(), nextSequence(), thread.id(), thread.name(), std::string(logName), builder.message.str(), std::move(builder.fields)});
+		}
 
-			std::stringstream vargStream;
-			akc::buildString(vargStream, vargs...);
+		// //////////////////////// //
+		// // Deferred Formatting // //
+		// //////////////////////// //
 
-			if (vargStream.str().front() != '[') sstream << " ";
+		using deferred_format_f = void(*)(MessageBuilder& builder, const uint8* data);
 
-			sstream << vargStream.str() << std::endl;
+		/// Precedes the logger name and encoded arguments of every deferred record
+		struct DeferredHeader {
+			deferred_format_f format;
+			int64 timestamp; /// Steady clock nanoseconds
+			uint64 sequence;
+			Level level;
+			uint8 nameLength;
+		};
 
-			printMessage(level, sstream.str());
+		/// Reserves space in the calling thread's ring, nullptr if full
+		uint8* reserveDeferred(akSize size);
+		void commitDeferred();
+
+		/// Arguments that can be copied raw and formatted later, everything else is formatted at the call site.
+		template<typename type_t, typename = void> struct DeferredArg {
+			static constexpr bool enabled = false;
+		};
+
+		template<typename type_t> struct DeferredArg<type_t, std::enable_if_t<std::is_arithmetic_v<type_t> || std::is_enum_v<type_t> || (std::is_pointer_v<type_t> && !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<type_t>>, char>)>> {
+			static constexpr bool enabled = true;
+			static akSize size(const type_t&) { return static_cast<akSize>(sizeof(type_t)); }
+			static uint8* encode(uint8* dst, const type_t& value) { std::memcpy(dst, &value, sizeof(type_t)); return dst + sizeof(type_t); }
+			static const uint8* decode(MessageBuilder& builder, const uint8* src) {
+				type_t value; std::memcpy(&value, src, sizeof(type_t));
+				akc::buildString(builder.message, value);
+				return src + sizeof(type_t);
+			}
+		};
+
+		struct DeferredStringArg {
+			static constexpr bool enabled = true;
+			static akSize size(const std::string_view& value) { return static_cast<akSize>(sizeof(uint32) + value.size()); }
+			static uint8* encode(uint8* dst, const std::string_view& value) {
+				auto length = static_cast<uint32>(value.size());
+				std::memcpy(dst, &length, sizeof(uint32));
+				std::memcpy(dst + sizeof(uint32), value.data(), length);
+				return dst + sizeof(uint32) + length;
+			}
+			static const uint8* read(const uint8* src, std::string_view& value) {
+				uint32 length; std::memcpy(&length, src, sizeof(uint32));
+				value = std::string_view(reinterpret_cast<const char*>(src + sizeof(uint32)), length);
+				return src + sizeof(uint32) + length;
+			}
+			static const uint8* decode(MessageBuilder& builder, const uint8* src) {
+				std::string_view value;
+				src = read(src, value);
+				builder.message << value;
+				return src;
+			}
+		};
+
+		template<> struct DeferredArg<std::string>      : DeferredStringArg {};
+		template<> struct DeferredArg<std::string_view> : DeferredStringArg {};
+		template<> struct DeferredArg<const char*> : DeferredStringArg {
+			static std::string_view view(const char* value) { return value ? std::string_view(value) : std::string_view(); }
+			static akSize size(const char* value) { return DeferredStringArg::size(view(value)); }
+			static uint8* encode(uint8* dst, const char* value) { return DeferredStringArg::encode(dst, view(value)); }
+		};
+		template<> struct DeferredArg<char*> : DeferredArg<const char*> {};
+		template<akSize length_v> struct DeferredArg<char[length_v]> : DeferredStringArg {
+			static std::string_view view(const char (&value)[length_v]) { return std::string_view(value, static_cast<akSize>(std::find(value, value + length_v, '\0') - value)); }
+			static akSize size(const char (&value)[length_v]) { return DeferredStringArg::size(view(value)); }
+			static uint8* encode(uint8* dst, const char (&value)[length_v]) { return DeferredStringArg::encode(dst, view(value)); }
+		};
+
+		/// A field whose value was formatted at the call site
+		struct FormattedField {
+			std::string_view key;
+			std::string value;
+		};
+
+		template<> struct DeferredArg<FormattedField> {
+			static constexpr bool enabled = true;
+			static akSize size(const FormattedField& field) { return DeferredStringArg::size(field.key) + DeferredStringArg::size(field.value); }
+			static uint8* encode(uint8* dst, const FormattedField& field) { return DeferredStringArg::encode(DeferredStringArg::encode(dst, field.key), field.value); }
+			static const uint8* decode(MessageBuilder& builder, const uint8* src) {
+				std::string_view key, value;
+				src = DeferredStringArg::read(DeferredStringArg::read(src, key), value);
+				builder.fields.push_back(RecordField{std::string(key), std::string(value), false});
+				return src;
+			}
+		};
+
+		template<typename type_t> struct DeferredArg<Field<type_t>, std::enable_if_t<std::is_arithmetic_v<type_t>>> {
+			static constexpr bool enabled = true;
+			static akSize size(const Field<type_t>& field) { return DeferredStringArg::size(field.key) + static_cast<akSize>(sizeof(type_t)); }
+			static uint8* encode(uint8* dst, const Field<type_t>& field) {
+				dst = DeferredStringArg::encode(dst, field.key);
+				std::memcpy(dst, &field.value, sizeof(type_t));
+				return dst + sizeof(type_t);
+			}
+			static const uint8* decode(MessageBuilder& builder, const uint8* src) {
+				std::string_view key;
+				src = DeferredStringArg::read(src, key);
+				type_t value; std::memcpy(&value, src, sizeof(type_t));
+				builder.fields.push_back(makeField(key, value));
+				return src + sizeof(type_t);
+			}
+		};
+
+		template<typename type_t> decltype(auto) prepareDeferred(const type_t& value) {
+			if constexpr (DeferredArg<type_t>::enabled) return (value);
+			else return akc::buildString(value);
+		}
+
+		template<typename type_t> decltype(auto) prepareDeferred(const Field<type_t>& field) {
+			if constexpr (DeferredArg<Field<type_t>>::enabled) return (field);
+			else return FormattedField{field.key, akc::buildString(field.value)};
+		}
+
+		template<typename... args_t> void formatDeferred(MessageBuilder& builder, const uint8* data) {
+			((data = DeferredArg<args_t>::decode(builder, data)), ...);
+		}
+
+		template<typename... args_t> bool defer(Level level, const std::string_view& logName, const args_t&... args) {
+			auto nameLength = static_cast<akSize>(std::min<std::size_t>(logName.size(), 255));
+			auto size = static_cast<akSize>(sizeof(DeferredHeader)) + nameLength + (akSize(0) + ... + DeferredArg<args_t>::size(args));
+
+			auto data = reserveDeferred(size);
+			if (!data) return false;
+
+			DeferredHeader header{&formatDeferred<args_t...>, monotonicTimeNS(), nextSequence(), level, static_cast<uint8>(nameLength)};
+			std::memcpy(data, &header, sizeof(DeferredHeader));
+			std::memcpy(data + sizeof(DeferredHeader), logName.data(), nameLength);
+			data += sizeof(DeferredHeader) + nameLength;
+			((data = DeferredArg<args_t>::encode(data, args)), ...);
+
+			commitDeferred();
+			return true;
+		}
+
+		template<typename... vargs_t> void submit(Level level, const std::string_view& logName, const vargs_t&... vargs) {
+			if (isDeferredFormatting() && defer(level, logName, prepareDeferred(vargs)...)) return;
+			build(level, logName, vargs...);
 		}
 	}
 
@@ -134,13 +374,40 @@ namespace akl {
 	template<typename... vargs_t> bool Logger::test_debug(bool cond, const vargs_t&... vargs) const { if (!cond) debug(vargs...); return cond; }
 	template<typename... vargs_t> bool Logger::test_raw(  bool cond, const vargs_t&... vargs) const { if (!cond)   raw(vargs...); return cond; }
 
-	template<typename... vargs_t> void Logger::fatal(const vargs_t&... vargs) const { if (isFilterLevelEnabled(Level::Fatal)) internal::build(Level::Fatal, m_name, vargs...); }
-	template<typename... vargs_t> void Logger::error(const vargs_t&... vargs) const { if (isFilterLevelEnabled(Level::Error)) internal::build(Level::Error, m_name, vargs...); }
-	template<typename... vargs_t> void Logger::warn( const vargs_t&... vargs) const { if (isFilterLevelEnabled(Level::Warn))  internal::build(Level::Warn,  m_name, vargs...); }
-	template<typename... vargs_t> void Logger::info( const vargs_t&... vargs) const { if (isFilterLevelEnabled(Level::Info))  internal::build(Level::Info,  m_name, vargs...); }
-	template<typename... vargs_t> void Logger::debug(const vargs_t&... vargs) const { if (isFilterLevelEnabled(Level::Debug)) internal::build(Level::Debug, m_name, vargs...); }
+	template<typename... vargs_t> void Logger::fatal(const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Fatal)) { if (isFilterLevelEnabled(Level::Fatal)) internal::build(Level::Fatal, m_name, vargs...); } }
+	template<typename... vargs_t> void Logger::error(const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Error)) { if (isFilterLevelEnabled(Level::Error)) internal::submit(Level::Error, m_name, vargs...); } }
+	template<typename... vargs_t> void Logger::warn( const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Warn))  { if (isFilterLevelEnabled(Level::Warn))  internal::submit(Level::Warn,  m_name, vargs...); } }
+	template<typename... vargs_t> void Logger::info( const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Info))  { if (isFilterLevelEnabled(Level::Info))  internal::submit(Level::Info,  m_name, vargs...); } }
+	template<typename... vargs_t> void Logger::debug(const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Debug)) { if (isFilterLevelEnabled(Level::Debug)) internal::submit(Level::Debug, m_name, vargs...); } }
 
-	template<typename... vargs_t> void Logger::raw(const vargs_t&... vargs) const { if (!isFilterLevelEnabled(Level::Raw)) return; internal::printMessage(Level::Raw, akc::buildString(vargs...)); }
+	template<typename... vargs_t> void Logger::raw(const vargs_t&... vargs) const { if constexpr (isLevelCompiled(Level::Raw)) { if (isFilterLevelEnabled(Level::Raw)) internal::printMessage(Level::Raw, akc::buildString(vargs...)); } }
 }
 
+/**
+ * Logs through the given logger only if the level is compiled in and enabled, otherwise the arguments are never evaluated.
+ * e.g. AK_LOG_DEBUG(log, "Visible: ", countVisible());
+ */
+#define AK_LOG_FATAL(logger, ...) AK_INTERNAL_LOG(logger, fatal, Fatal, __VA_ARGS__)
+#define AK_LOG_ERROR(logger, ...) AK_INTERNAL_LOG(logger, error, Error, __VA_ARGS__)
+#define AK_LOG_WARN( logger, ...) AK_INTERNAL_LOG(logger, warn,  Warn,  __VA_ARGS__)
+#define AK_LOG_INFO( logger, ...) AK_INTERNAL_LOG(logger, info,  Info,  __VA_ARGS__)
+#define AK_LOG_DEBUG(logger, ...) AK_INTERNAL_LOG(logger, debug, Debug, __VA_ARGS__)
+
+/**
+ * Logs the result of func, which is only called if the level is compiled in and enabled.
+ * e.g. AK_LOG_DEBUG_LAZY(log, [&]{ return akc::buildString("Tree: ", dumpTree()); });
+ */
+#define AK_LOG_FATAL_LAZY(logger, func) AK_LOG_FATAL(logger, (func)())
+#define AK_LOG_ERROR_LAZY(logger, func) AK_LOG_ERROR(logger, (func)())
+#define AK_LOG_WARN_LAZY( logger, func) AK_LOG_WARN( logger, (func)())
+#define AK_LOG_INFO_LAZY( logger, func) AK_LOG_INFO( logger, (func)())
+#define AK_LOG_DEBUG_LAZY(logger, func) AK_LOG_DEBUG(logger, (func)())
+
+#define AK_INTERNAL_LOG(logger, method, level, ...) \
+	do { \
+		if constexpr (::akl::isLevelCompiled(::akl::Level::level)) { \
+			if (::akl::isFilterLevelEnabled(::akl::Level::level)) (logger).method(__VA_ARGS__); \
+		} \
+	} while(false)
+
 #endif
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_LOG_LOGSINK_HPP_
+#define AK_LOG_LOGSINK_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/filesystem/CFile.hpp>
+#include <akengine/filesystem/Path.hpp>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+namespace akl {
+
+	struct FileSinkConfig {
+		akSize bufferSize = 256*1024;  /// Buffered bytes that trigger a write
+		uint64 flushIntervalMS = 1000; /// Maximum age of buffered data before it's written
+		uint64 rotateSize = 64*1024*1024; /// File size that starts a new file, 0 to disable
+		uint64 rotateMinutes = 0;         /// File age that starts a new file, 0 to disable
+		bool compressRotated = true;      /// Brotli compress finished files in the background
+	};
+
+	/**
+	 * Buffered, rotating log file output.
+	 * Files are named <prefix>YYYYmmdd_HHMMSS<extension>, rotated files are replaced with a .br copy when compression is enabled.
+	 * Not thread safe, used from the log thread and from fatal paths through akl::flush().
+	 */
+	class FileSink final {
+		FileSink(const FileSink&) = delete;
+		FileSink& operator=(const FileSink&) = delete;
+		private:
+			std::string m_prefix;
+			std::string m_extension;
+			FileSinkConfig m_config;
+
+			akfs::CFile m_file;
+			akfs::Path m_path;
+			std::string m_buffer;
+			uint64 m_fileSize;
+
+			std::chrono::steady_clock::time_point m_lastFlush;
+			std::chrono::steady_clock::time_point m_openTime;
+
+			/// Opens a new file, the current one is only replaced if that succeeds
+			bool openNext();
+			bool rotate();
+
+		public:
+			FileSink(const std::string& prefix, const std::string& extension);
+			~FileSink();
+
+			bool open();
+			void close();
+			bool isOpen() const { return static_cast<bool>(m_file); }
+
+			/**
+			 * Appends to the write buffer, writing it out if it's full or the flush interval has passed.
+			 */
+			void write(const std::string_view& data);
+
+			/**
+			 * Flushes on time and rotates on age, call periodically.
+			 */
+			void update();
+
+			/**
+			 * Writes any buffered data and flushes the file.
+			 */
+			bool flush();
+
+			void setConfig(const FileSinkConfig& config);
+			const FileSinkConfig& config() const { return m_config; }
+	};
+
+	/**
+	 * Finishes any pending background compression of rotated files.
+	 */
+	void stopSinkCompression();
+}
+
+#endif
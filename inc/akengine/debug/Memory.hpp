@@ -0,0 +1,100 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_DEBUG_MEMORY_HPP_
+#define AK_DEBUG_MEMORY_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <string>
+#include <vector>
+
+namespace akmem {
+
+	using TagID = uint8;
+
+	static constexpr akSize MAX_TAGS = 64;
+	static constexpr TagID UNTAGGED = 0;
+
+	namespace internal {
+		/// Sets the calling thread's tag, returning the previous one
+		TagID swapTag(TagID tag);
+	}
+
+	/**
+	 * @return The ID for name, UNTAGGED once MAX_TAGS names are registered
+	 * @remark name must outlive the program, e.g. a string literal
+	 */
+	TagID registerTag(const char* name);
+
+	/**
+	 * Attributes allocations on this thread to a tag until the end of the scope, restoring the outer tag afterwards.
+	 */
+	class TagScope final {
+		TagScope(const TagScope&) = delete;
+		TagScope& operator=(const TagScope&) = delete;
+		private:
+			TagID m_previous;
+
+		public:
+			explicit TagScope(TagID tag) : m_previous(internal::swapTag(tag)) {}
+			~TagScope() { internal::swapTag(m_previous); }
+	};
+
+	struct TagStats {
+		std::string name;
+		int64 liveBytes;
+		int64 peakBytes;
+		uint64 allocations;
+		uint64 frees;
+		uint64 allocatedBytes;
+		uint64 frameAllocations;    /// Allocations during the last frame
+		uint64 frameAllocatedBytes; /// Bytes allocated during the last frame
+	};
+
+	/**
+	 * @return If the global allocation hooks are compiled in (AK_MEMORY_TRACKING)
+	 */
+	bool isTracking();
+
+	/**
+	 * Counters are batched per thread, so each tag may lag its true value by up to 64KB and 1024 operations per thread.
+	 * @return Statistics for every registered tag, empty if not tracking
+	 */
+	std::vector<TagStats> tagStats();
+
+	/**
+	 * Closes the per-frame allocation counters, called from akprof::endFrame.
+	 */
+	void endFrame();
+
+	/**
+	 * Logs every tag's statistics, largest live size first.
+	 */
+	void logReport();
+}
+
+#ifdef AK_MEMORY_TRACKING
+#	define AK_INTERNAL_MEMORY_CONCAT_(a, b) a##b
+#	define AK_INTERNAL_MEMORY_CONCAT(a, b) AK_INTERNAL_MEMORY_CONCAT_(a, b)
+/// Attributes allocations in the rest of the enclosing scope to the named tag, name must be a string literal
+#	define AK_MEMORY_TAG(name) \
+		static const ::akmem::TagID AK_INTERNAL_MEMORY_CONCAT(akMemoryTagID, __LINE__) = ::akmem::registerTag("" name); \
+		::akmem::TagScope AK_INTERNAL_MEMORY_CONCAT(akMemoryTag, __LINE__)(AK_INTERNAL_MEMORY_CONCAT(akMemoryTagID, __LINE__))
+#else
+#	define AK_MEMORY_TAG(name) do {} while(false)
+#endif
+
+#endif
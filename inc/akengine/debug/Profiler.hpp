@@ -0,0 +1,192 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_DEBUG_PROFILER_HPP_
+#define AK_DEBUG_PROFILER_HPP_
+
+#include <akcommon/FrameStats.hpp>
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/filesystem/Path.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace akprof {
+
+	namespace internal {
+		inline std::atomic<bool> enabled = false;
+
+		inline int64 now() { return static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()); }
+
+		uint32 enterZone();
+		void leaveZone(const char* name, int64 begin, int64 end, uint32 depth);
+
+		struct ZoneRing;
+	}
+
+	/**
+	 * A thread's zone buffer is normally made by its first zone, which allocates it.
+	 * Threads that must not allocate, such as the audio callback, are given one made ahead of time instead.
+	 */
+	using ZoneBuffer = std::shared_ptr<internal::ZoneRing>;
+
+	/**
+	 * Makes and registers a zone buffer for a thread that hasn't started yet.
+	 */
+	ZoneBuffer makeZoneBuffer(const std::string& threadName);
+
+	/**
+	 * Gives the calling thread the buffer if it doesn't have one yet, without allocating.
+	 * @return If the thread now has a buffer, false for a null buffer or one another thread adopted
+	 */
+	bool adoptZoneBuffer(const ZoneBuffer& buffer);
+
+	/**
+	 * Times the enclosing scope, use through AK_PROFILE_SCOPE.
+	 * Costs a relaxed load when profiling is disabled, otherwise two clock reads and a write to the thread's own ring.
+	 * A null name records nothing.
+	 */
+	class Zone final {
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+		private:
+			const char* m_name;
+			int64 m_begin;
+			uint32 m_depth;
+
+		public:
+			explicit Zone(const char* name) : m_name(internal::enabled.load(std::memory_order_relaxed) ? name : nullptr), m_begin(0), m_depth(0) {
+				if (!m_name) return;
+				m_depth = internal::enterZone();
+				m_begin = internal::now();
+			}
+
+			~Zone() {
+				if (m_name) internal::leaveZone(m_name, m_begin, internal::now(), m_depth);
+			}
+	};
+
+	/// Zones with the same name and parent in a frame, merged
+	struct ProfileNode {
+		const char* name;
+		uint32 parent; /// Index in ThreadProfile::nodes, NO_PARENT for top level zones
+		uint32 depth;
+		uint32 calls;
+		int64 totalNS;
+		int64 selfNS;
+
+		static constexpr uint32 NO_PARENT = 0xFFFFFFFF;
+	};
+
+	struct ThreadProfile {
+		uint64 threadID;
+		std::string threadName;
+		std::vector<ProfileNode> nodes; /// Parents always precede their children
+	};
+
+	struct FrameProfile {
+		uint64 frame = 0;
+		int64 beginNS = 0;
+		int64 endNS = 0;
+		uint64 droppedZones = 0; /// Zones lost to full thread buffers
+		std::vector<ThreadProfile> threads;
+	};
+
+	void setEnabled(bool enabled);
+	inline bool isEnabled() { return internal::enabled.load(std::memory_order_relaxed); }
+
+	/**
+	 * Records the frame time statistic and, when profiling, collects every zone completed since the last frame into the frame tree. Call once per frame.
+	 * Zones still open when the frame ends are counted in the frame they close in, their children appear as top level zones.
+	 */
+	void endFrame();
+
+	/**
+	 * @return The aggregated zones of the last completed frame
+	 */
+	FrameProfile lastFrame();
+
+	/**
+	 * Indented tree of a frame, one zone per line: calls, total and self time.
+	 */
+	std::string formatFrame(const FrameProfile& frame);
+
+	/**
+	 * Keeps every zone from now on, written as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev) by stopCapture.
+	 * Enables profiling if it isn't already.
+	 */
+	bool startCapture(const akfs::Path& path);
+	bool stopCapture();
+	bool isCapturing();
+
+	// ////////////////////// //
+	// // Frame Statistics // //
+	// ////////////////////// //
+
+	/// Names of the statistics the engine records
+	namespace stats {
+		constexpr std::string_view Frame  = "Frame";  /// Time between endFrame calls
+		constexpr std::string_view Update = "Update";
+		constexpr std::string_view Render = "Render";
+		constexpr std::string_view Audio  = "Audio";  /// Time spent in the audio callback
+	}
+
+	/**
+	 * Duration percentiles for the given name, created on first use and kept for the life of the program.
+	 * Each statistic expects a single recording thread, cache the reference to skip the lookup.
+	 */
+	akc::FrameStats& frameStats(const std::string_view& name);
+
+	/**
+	 * @return Every statistic's name and its rolling window summary
+	 */
+	std::vector<std::pair<std::string, akc::FrameStatsSummary>> frameStatsWindow();
+
+	/**
+	 * Logs the window and whole run percentiles of every statistic.
+	 */
+	void logFrameStats();
+
+	/**
+	 * Records the lifetime of the scope into a statistic.
+	 */
+	class StatScope final {
+		StatScope(const StatScope&) = delete;
+		StatScope& operator=(const StatScope&) = delete;
+		private:
+			akc::FrameStats& m_stats;
+			std::chrono::steady_clock::time_point m_start;
+
+		public:
+			explicit StatScope(akc::FrameStats& stats) : m_stats(stats), m_start(std::chrono::steady_clock::now()) {}
+			~StatScope() { m_stats.record(std::chrono::steady_clock::now() - m_start); }
+	};
+}
+
+#ifdef AK_PROFILER
+#	define AK_INTERNAL_PROFILE_CONCAT_(a, b) a##b
+#	define AK_INTERNAL_PROFILE_CONCAT(a, b) AK_INTERNAL_PROFILE_CONCAT_(a, b)
+/// Times the rest of the enclosing scope, name must be a string literal
+#	define AK_PROFILE_SCOPE(name) ::akprof::Zone AK_INTERNAL_PROFILE_CONCAT(akProfileZone, __LINE__)("" name)
+#else
+#	define AK_PROFILE_SCOPE(name) do {} while(false)
+#endif
+
+#endif
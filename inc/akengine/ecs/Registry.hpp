@@ -23,12 +23,15 @@
 #include <akcommon/SlotMap.hpp>
 #include <akcommon/Traits.hpp>
 #include <akengine/debug/Log.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
 #include <akengine/ecs/BaseRegistry.hpp>
 #include <akengine/ecs/Component.hpp>
 #include <akengine/ecs/Entity.hpp>
 #include <akengine/ecs/Types.hpp>
-#include <crtdefs.h>
+#include <akengine/metrics/Metrics.hpp>
 #include <array>
+#include <cstddef>
 #include <initializer_list>
 #include <type_traits>
 #include <unordered_map>
@@ -36,6 +39,14 @@
 
 namespace akecs {
 
+	namespace internal {
+		/// Live entities across every registry
+		inline akmet::ShardedGauge& entityMetric() {
+			static akmet::ShardedGauge& result = akmet::shardedGauge("ecs.entities");
+			return result;
+		}
+	}
+
 	template<typename... components_t> class Registry final : public BaseRegistry {
 		static_assert(akc::traits::IsUniqueList<ComponentTypeUID, components_t::COMPONENT_UID...>::value, "Component types do not have a unique IDs.");
 		private:
@@ -141,6 +152,8 @@ namespace akecs {
 	 }
 
 	template<typename... components_t> Registry<components_t...>::~Registry() {
+		AK_PROFILE_SCOPE("Registry::destroyAll");
+		internal::entityMetric().sub(static_cast<int64>(m_entities.size()));
 		// Placement delete component type managers, initializer list facilitates for-each
 		(void) std::initializer_list<int>{((reinterpret_cast<ComponentType<components_t>&>(m_componentTypes[componentTypeID<components_t>()]).~ComponentType()), 0)...};
 	}
@@ -149,9 +162,11 @@ namespace akecs {
 namespace akecs {
 
 	template<typename... components_t> EntityRef Registry<components_t...>::create() {
+		AK_MEMORY_TAG("ECS");
 		auto entityID = m_entities.insert(Entity(*this, EntityID()));
 		auto& entity = m_entities[entityID];
 		entity.m_ref.m_id = entityID;
+		internal::entityMetric().add(1);
 		return entity.ref();
 	}
 
@@ -159,6 +174,7 @@ namespace akecs {
 		if (entity.get() == nullptr) return;
 		for(auto& componentEntry : entity->m_components) detachByID(entity, componentEntry.first);
 		m_entities.erase(entity.m_id);
+		internal::entityMetric().sub(1);
 	}
 
 }
@@ -186,6 +202,8 @@ namespace akecs {
 	}
 
 	template<typename... components_t> void Registry<components_t...>::reserveEntities(akSize count) {
+		AK_PROFILE_SCOPE("Registry::reserveEntities");
+		AK_MEMORY_TAG("ECS");
 		m_entities.reserve(count);
 	}
 }
@@ -17,19 +17,55 @@
 #ifndef AK_EVENT_DISPATCHER_HPP_
 #define AK_EVENT_DISPATCHER_HPP_
 
+#include <akcommon/Delegate.hpp>
 #include <akcommon/PrimitiveTypes.hpp>
-#include <akcommon/SlotMap.hpp>
+#include <akcommon/Span.hpp>
+#include <akengine/event/EventQueue.hpp>
+#include <akengine/event/Recorder.hpp>
+#include <akengine/event/SnapshotEpoch.hpp>
 #include <akengine/event/Util.hpp>
+#include <akengine/metrics/Metrics.hpp>
 #include <akengine/thread/CurrentThread.hpp>
 #include <algorithm>
 #include <atomic>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace akev {
-	using SubscriberID = akc::SlotID;
+	/// Unique per dispatcher, 0 is never issued
+	using SubscriberID = uint64;
+
+	/**
+	 * Key extractor used by Dispatcher::subscribeKeyed. Specialise for an event type with:
+	 *   enabled = true, a hashable key_type, and static key_type extract(const event_t&)
+	 */
+	template<typename event_t> struct EventKey {
+		static constexpr bool enabled = false;
+		using key_type = uint8;
+		static key_type extract(const event_t& /*event*/) { return 0; }
+	};
+
+	namespace internal {
+		/// Events are recordable when they carry trivially copyable data
+		template<typename event_t, typename = void> struct EventData {
+			static constexpr bool recordable = false;
+			using type = void;
+		};
+
+		template<typename event_t> struct EventData<event_t, std::void_t<decltype(std::declval<const event_t&>().data())>> {
+			using type = std::decay_t<decltype(std::declval<const event_t&>().data())>;
+			static constexpr bool recordable = std::is_trivially_copyable_v<type>;
+		};
+
+		/// Mediated events get their own channel, so they don't collide with what the event's producer records itself
+		inline constexpr RecordChannel mediatedChannel(EventID id) { return id ^ calculateEventID("Mediated"); }
+	}
 
 	template<typename event_t> class Dispatcher final {
 		Dispatcher(const Dispatcher&) = delete;
@@ -37,39 +73,209 @@ namespace akev {
 		public:
 			using event_type = event_t;
 			using callback_s = void(event_type&);
-			using callback_t = std::function<void(event_type&)>;
+			using callback_t = akc::Delegate<void(event_type&)>;
 
 		private:
-			akc::SlotMap<callback_t> m_callbacks;
+			struct Subscriber final {
+				SubscriberID id;
+				callback_t callback;
+			};
+			using key_type = typename EventKey<event_type>::key_type;
+
+			/**
+			 * Mediated events with trivially copyable data are recorded, and mediated again when a replay reaches them.
+			 * Replays go to the most recently created dispatcher of the type. Pointers in the data are recorded as they are.
+			 */
+			static constexpr bool RECORD_MEDIATED = internal::EventData<event_type>::recordable;
+			using data_type = typename internal::EventData<event_type>::type;
+			static inline std::atomic<Dispatcher*> s_replayTarget{nullptr};
+
+			struct Snapshot final {
+				std::vector<Subscriber> subscribers;
+				std::unordered_map<key_type, std::vector<Subscriber>> keyed; /// Called after subscribers, only for their key
+			};
+			using snapshot_type = Snapshot;
+
+			/**
+			 * Immutable once published. Senders read it under an internal::EpochGuard without taking a lock,
+			 * replaced snapshots are freed by the next write (or the destructor) once no send that could see them is running.
+			 */
+			std::atomic<const snapshot_type*> m_subscribers;
+			std::vector<std::pair<const snapshot_type*, uint64>> m_retired; /// Replaced snapshots and the epoch they were retired in
+			std::mutex m_subscriberWriteLock;
+			SubscriberID m_nextSubscriberID;
+
 			akt::CurrentThread& m_mediator;
 
-			std::atomic<int> m_sendCounter;
-			std::vector<SubscriberID> m_freelist;
+			EventQueue<event_type> m_queue;
+			std::atomic<bool> m_drainScheduled;
+
+			/// Registered for the event type on first use rather than at construction, null when out of sharded slots
+			static akmet::ShardedCounter* sentMetric() {
+				static akmet::ShardedCounter* metric = akmet::tryShardedCounter("events.sent", {{"event", std::string(event_type::EVENT_NAME)}});
+				return metric;
+			}
+
+			static akmet::ShardedCounter* mediatedMetric() {
+				static akmet::ShardedCounter* metric = akmet::tryShardedCounter("events.mediated", {{"event", std::string(event_type::EVENT_NAME)}});
+				return metric;
+			}
+
+			/// Only valid while an internal::EpochGuard is held
+			const snapshot_type& snapshot() const {
+				return *m_subscribers.load();
+			}
+
+			/// Must hold the write lock
+			void reclaim() {
+				auto oldest = internal::oldestReadEpoch();
+				m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), [&](const auto& entry){
+					if (entry.second > oldest) return false;
+					delete entry.first;
+					return true;
+				}), m_retired.end());
+			}
+
+			template<typename... vargs_t> void enqueue(vargs_t&&... vargs) {
+				m_queue.emplace(std::forward<vargs_t>(vargs)...);
+				if (auto metric = mediatedMetric()) metric->add();
+				if (!m_drainScheduled.exchange(true)) m_mediator.schedule([this]{ sendQueued(); });
+			}
+
+			template<typename func_t> SubscriberID modifySubscribers(const func_t& modify) {
+				std::lock_guard<std::mutex> lock(m_subscriberWriteLock);
+				auto subscribers = std::make_unique<snapshot_type>(*m_subscribers.load(std::memory_order_relaxed));
+				auto id = modify(*subscribers);
+				if (id != 0) {
+					m_retired.reserve(m_retired.size() + 1);
+					auto previous = m_subscribers.exchange(subscribers.release());
+					m_retired.emplace_back(previous, internal::advanceEpoch());
+					reclaim();
+				}
+				return id;
+			}
+
+			SubscriberID insert(callback_t&& callback) {
+				return modifySubscribers([&](snapshot_type& subscribers){
+					auto id = ++m_nextSubscriberID;
+					subscribers.subscribers.push_back(Subscriber{id, std::move(callback)});
+					return id;
+				});
+			}
+
+			SubscriberID insertKeyed(const key_type& key, callback_t&& callback) {
+				static_assert(EventKey<event_type>::enabled, "Dispatcher: Event type has no EventKey specialisation.");
+				return modifySubscribers([&](snapshot_type& subscribers){
+					auto id = ++m_nextSubscriberID;
+					subscribers.keyed[key].push_back(Subscriber{id, std::move(callback)});
+					return id;
+				});
+			}
+
+			static bool eraseFrom(std::vector<Subscriber>& subscribers, SubscriberID id) {
+				auto iter = std::find_if(subscribers.begin(), subscribers.end(), [&](const auto& entry){ return entry.id == id; });
+				if (iter == subscribers.end()) return false;
+				subscribers.erase(iter);
+				return true;
+			}
+
+			void sendKeyed(const snapshot_type& subscribers, event_type& event) {
+				if constexpr (EventKey<event_type>::enabled) {
+					if (subscribers.keyed.empty() || event.isCanceled()) return;
+					auto iter = subscribers.keyed.find(EventKey<event_type>::extract(event));
+					if (iter == subscribers.keyed.end()) return;
+					for(const auto& subscriber : iter->second) {
+						subscriber.callback(event);
+						if (event.isCanceled()) return;
+					}
+				}
+			}
+
+			/// Sends a drained span of mediated events, subscribers are visited in order and given every event that hasn't been canceled
+			void sendAll(akc::Span<event_type> events) {
+				if (auto metric = sentMetric()) metric->add(events.size());
+				internal::EpochGuard guard;
+				const auto& subscribers = snapshot();
+				for(auto& event : events) event.m_canceled = false;
+				for(const auto& subscriber : subscribers.subscribers) {
+					for(auto& event : events) if (!event.isCanceled()) subscriber.callback(event);
+				}
+				for(auto& event : events) sendKeyed(subscribers, event);
+			}
 
 		public:
-			Dispatcher() : m_mediator(akt::current()) {}
+			Dispatcher() : m_subscribers(new snapshot_type()), m_retired(), m_subscriberWriteLock(), m_nextSubscriberID(0), m_mediator(akt::current()), m_drainScheduled(false) {
+				if constexpr (RECORD_MEDIATED) {
+					s_replayTarget.store(this);
+					setReplayHandler<data_type>(internal::mediatedChannel(event_type::EVENT_ID), [](const data_type& data){
+						if (auto target = s_replayTarget.load()) target->mediate(data);
+					});
+				}
+			}
 			Dispatcher(Dispatcher&&) = default;
 			Dispatcher& operator=(Dispatcher&&) = default;
 
-			~Dispatcher() {}
+			/// No sends may be in progress
+			~Dispatcher() {
+				for(auto& entry : m_retired) delete entry.first;
+				delete m_subscribers.load();
+				if constexpr (RECORD_MEDIATED) {
+					auto self = this;
+					if (s_replayTarget.compare_exchange_strong(self, nullptr)) clearReplayHandler(internal::mediatedChannel(event_type::EVENT_ID));
+				}
+			}
 
 			template<typename func_t> SubscriberID subscribe(const func_t& func) {
-				return m_callbacks.insert(callback_t(func));
+				return insert(callback_t(func));
+			}
+
+			/**
+			 * Subscribes a member function, called directly on obj. obj must outlive the subscription.
+			 */
+			template<auto method_v, typename class_t> SubscriberID subscribe(class_t& obj) {
+				return insert(callback_t::template bind<method_v>(obj));
+			}
+
+			/**
+			 * Subscribes to events whose EventKey matches key, skipping the call for every other event.
+			 */
+			template<typename func_t> SubscriberID subscribeKeyed(const key_type& key, const func_t& func) {
+				return insertKeyed(key, callback_t(func));
+			}
+
+			template<auto method_v, typename class_t> SubscriberID subscribeKeyed(const key_type& key, class_t& obj) {
+				return insertKeyed(key, callback_t::template bind<method_v>(obj));
 			}
 
-			void unsubscribe(SubscriberID subscriber) {
-				if (m_sendCounter) m_freelist.push_back(subscriber);
-				else m_callbacks.erase(subscriber);
+			/**
+			 * Removes a subscriber. Sends already in progress on other threads may still call it once.
+			 * @return If the subscriber existed
+			 */
+			bool unsubscribe(SubscriberID subscriber) {
+				return modifySubscribers([&](snapshot_type& subscribers) -> SubscriberID {
+					if (eraseFrom(subscribers.subscribers, subscriber)) return subscriber;
+					for(auto iter = subscribers.keyed.begin(); iter != subscribers.keyed.end(); iter++) {
+						if (!eraseFrom(iter->second, subscriber)) continue;
+						if (iter->second.empty()) subscribers.keyed.erase(iter);
+						return subscriber;
+					}
+					return 0;
+				}) != 0;
 			}
 
+			/**
+			 * Sends an event to the current subscribers. Safe to call from multiple threads, and to (un)subscribe from within callbacks.
+			 */
 			void send(event_t& event) {
-				++m_sendCounter;
+				if (auto metric = sentMetric()) metric->add();
+				internal::EpochGuard guard;
+				const auto& subscribers = snapshot();
 				event.m_canceled = false;
-				for(const auto& callback : m_callbacks) { callback(event); if (event.isCanceled()) return; }
-				if (--m_sendCounter == 0) {
-					auto localCopy = std::move(m_freelist); // @todo Might be a race condition here... It'd be hard as hell to hit... Probably...
-					for(auto id : localCopy) unsubscribe(id);
+				for(const auto& subscriber : subscribers.subscribers) {
+					subscriber.callback(event);
+					if (event.isCanceled()) return;
 				}
+				sendKeyed(subscribers, event);
 			}
 
 			template<typename... vargs_t> void sendEmplace(vargs_t... vargs) {
@@ -77,10 +283,38 @@ namespace akev {
 				send(event);
 			}
 
-			void mediate(const std::shared_ptr<event_type>& event) { m_mediator.schedule([this, event](){send(*event);}); }
-			template<typename... vargs_t> void mediate(vargs_t... vargs) { mediate(std::make_shared<event_type>(std::forward(vargs)...)); }
+			/**
+			 * Queues an event to be sent on the thread that created this dispatcher, during the mediator's next update.
+			 * Events are sent in the order they were mediated, from any thread.
+			 */
+			template<typename... vargs_t> void mediate(vargs_t&&... vargs) {
+				if constexpr (RECORD_MEDIATED) {
+					if (isRecording()) {
+						event_type event(std::forward<vargs_t>(vargs)...);
+						record(internal::mediatedChannel(event_type::EVENT_ID), event.data());
+						enqueue(std::move(event));
+						return;
+					}
+				}
+				enqueue(std::forward<vargs_t>(vargs)...);
+			}
+
+			/**
+			 * Sends every mediated event now. Must be called from the mediator thread.
+			 * @return The number of events sent
+			 */
+			akSize sendQueued() {
+				m_drainScheduled = false;
+				return m_queue.drain([this](akc::Span<event_type> events){ sendAll(events); });
+			}
 
-			akSize subscriberCount() const { return m_callbacks.size(); }
+			akSize subscriberCount() const {
+				internal::EpochGuard guard;
+				const auto& subscribers = snapshot();
+				akSize result = static_cast<akSize>(subscribers.subscribers.size());
+				for(const auto& entry : subscribers.keyed) result += static_cast<akSize>(entry.second.size());
+				return result;
+			}
 
 			EventID id() { return event_t::EVENT_ID; }
 			std::string_view name() { return event_t::EVENT_NAME; }
@@ -100,7 +334,10 @@ namespace akev {
 			~DispatcherProxy() = default;
 
 			template<typename func_t> SubscriberID subscribe(const func_t& func) const { return m_dispatcher.subscribe(func); }
-			void unsubscribe(SubscriberID subscriber) const { return m_dispatcher.unsubscribe(subscriber); }
+			template<auto method_v, typename class_t> SubscriberID subscribe(class_t& obj) const { return m_dispatcher.template subscribe<method_v>(obj); }
+			template<typename key_t, typename func_t> SubscriberID subscribeKeyed(const key_t& key, const func_t& func) const { return m_dispatcher.subscribeKeyed(key, func); }
+			template<auto method_v, typename key_t, typename class_t> SubscriberID subscribeKeyed(const key_t& key, class_t& obj) const { return m_dispatcher.template subscribeKeyed<method_v>(key, obj); }
+			bool unsubscribe(SubscriberID subscriber) const { return m_dispatcher.unsubscribe(subscriber); }
 
 			EventID id() const { return m_dispatcher.id(); }
 			std::string_view name() const { return m_dispatcher.name(); }
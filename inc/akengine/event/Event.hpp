@@ -36,6 +36,9 @@ namespace akev {
 		class IEvent {
 			IEvent(const IEvent&) = delete;
 			IEvent& operator=(const IEvent&) = delete;
+			protected:
+				IEvent(IEvent&&) = default;
+
 			public:
 				IEvent() = default;
 				virtual ~IEvent() = default;
@@ -63,6 +66,7 @@ namespace akev {
 
 		public:
 			Event(const data_t& eventData) : m_data(eventData), m_canceled(false) {}
+			Event(Event&&) = default;
 			virtual ~Event() = default;
 
 			data_t& data() { return m_data; }
@@ -88,6 +92,7 @@ namespace akev {
 
 		public:
 			Event() : m_canceled(false) {}
+			Event(Event&&) = default;
 			virtual ~Event() = default;
 
 			virtual bool cancel() { m_canceled = true; return isCancelable(); }
@@ -0,0 +1,70 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_EVENT_EVENTQUEUE_HPP_
+#define AK_EVENT_EVENTQUEUE_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akcommon/Span.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <utility>
+#include <vector>
+
+namespace akev {
+
+	/**
+	 * Multi-producer, single-consumer queue of events, kept in the order they were queued.
+	 * Producers only hold the lock to append, the consumer swaps the pending events out and drains them as one contiguous span.
+	 * Storage is reused between drains so steady state queuing doesn't allocate.
+	 */
+	template<typename event_t> class EventQueue final {
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+		private:
+			akt::Spinlock m_lock;
+			std::vector<event_t> m_pending;
+			std::vector<event_t> m_draining;
+
+		public:
+			EventQueue() : m_lock("EventQueue"), m_pending(), m_draining() {}
+
+			template<typename... vargs_t> void emplace(vargs_t&&... vargs) {
+				auto lock = m_lock.lock();
+				m_pending.emplace_back(std::forward<vargs_t>(vargs)...);
+			}
+
+			/**
+			 * Passes every queued event to func as a single span. Only one thread may drain at a time.
+			 * @param func Callable taking akc::Span<event_t>
+			 * @return The number of events drained
+			 */
+			template<typename func_t> akSize drain(const func_t& func) {
+				/* Swap */ {
+					auto lock = m_lock.lock();
+					std::swap(m_pending, m_draining);
+				}
+				if (m_draining.empty()) return 0;
+
+				func(akc::Span<event_t>(m_draining));
+				auto total = static_cast<akSize>(m_draining.size());
+				m_draining.clear();
+				return total;
+			}
+	};
+
+}
+
+#endif
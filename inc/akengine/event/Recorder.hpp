@@ -0,0 +1,124 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_EVENT_RECORDER_HPP_
+#define AK_EVENT_RECORDER_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/event/Util.hpp>
+#include <akengine/filesystem/Path.hpp>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace akev {
+
+	/// Identifies the source of a recorded event, usually the EventID of the event it produces
+	using RecordChannel = EventID;
+
+	// /////////////// //
+	// // Recording // //
+	// /////////////// //
+
+	/**
+	 * Starts recording to the given file, replacing any recording in progress.
+	 * Records are buffered and written as: varint time delta (ns), varint frame delta, channel, varint size, payload.
+	 */
+	bool startRecording(const akfs::Path& path);
+	void stopRecording();
+	bool isRecording();
+
+	/**
+	 * Marks the end of a frame. Events recorded afterwards belong to the next frame.
+	 */
+	void recordFrame();
+
+	void record(RecordChannel channel, const void* data, akSize size);
+
+	template<typename type_t> void record(RecordChannel channel, const type_t& value) {
+		static_assert(std::is_trivially_copyable_v<type_t>, "record: Type must be trivially copyable, serialize it first.");
+		if (isRecording()) record(channel, &value, sizeof(type_t));
+	}
+
+	// //////////// //
+	// // Replay // //
+	// //////////// //
+
+	using replay_handler_f = void(const uint8* data, akSize size);
+
+	/**
+	 * Sets the function that recreates events from a channel's payloads during replay.
+	 */
+	void setReplayHandler(RecordChannel channel, const std::function<replay_handler_f>& handler);
+	void clearReplayHandler(RecordChannel channel);
+
+	template<typename type_t, typename func_t> void setReplayHandler(RecordChannel channel, const func_t& func) {
+		static_assert(std::is_trivially_copyable_v<type_t>, "setReplayHandler: Type must be trivially copyable.");
+		setReplayHandler(channel, std::function<replay_handler_f>([func](const uint8* data, akSize size){
+			if (size != sizeof(type_t)) return;
+			type_t value; std::memcpy(&value, data, sizeof(type_t));
+			func(value);
+		}));
+	}
+
+	enum class ReplaySpeed : uint8 {
+		Original, /// Waits until each event's original offset from the start
+		Maximum   /// Feeds events as fast as they're requested
+	};
+
+	/**
+	 * Feeds a recording back through the replay handlers, a frame at a time.
+	 */
+	class Replay final {
+		private:
+			std::vector<uint8> m_data;
+			akSize m_offset;
+			ReplaySpeed m_speed;
+
+			std::chrono::steady_clock::time_point m_startTime;
+			bool m_started;
+			uint64 m_time;        /// Recorded time (ns) of the last replayed record
+			uint64 m_recordFrame; /// Recorded frame of the last replayed record
+			uint64 m_frame;       /// Frame being replayed
+			uint64 m_eventCount;
+
+		public:
+			Replay();
+
+			bool open(const akfs::Path& path, ReplaySpeed speed = ReplaySpeed::Original);
+
+			/**
+			 * Replays the events of the next recorded frame.
+			 * @return If there are any events left
+			 */
+			bool replayFrame();
+
+			/**
+			 * Replays every remaining event
+			 * @return The number of events replayed
+			 */
+			uint64 replayAll();
+
+			bool isFinished() const { return m_offset >= m_data.size(); }
+			uint64 frame() const { return m_frame; }
+			uint64 eventCount() const { return m_eventCount; }
+	};
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_EVENT_SNAPSHOTEPOCH_HPP_
+#define AK_EVENT_SNAPSHOTEPOCH_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <atomic>
+
+namespace akev {
+	namespace internal {
+		/// One per thread that has read a snapshot, never freed but reused by later threads
+		struct alignas(64) EpochRecord final {
+			std::atomic<uint64> epoch; /// Epoch the thread's outermost read began in, 0 while it isn't reading
+			std::atomic<bool> inUse;
+			EpochRecord* next;
+			uint32 depth;              /// Nested reads, only touched by the owning thread
+		};
+
+		inline std::atomic<uint64> globalEpoch{1};
+		inline thread_local EpochRecord* localEpochRecord = nullptr;
+
+		/// Claims the thread's record, or a record for a single read during thread teardown
+		EpochRecord* acquireEpochRecord(bool& temporary);
+		void releaseEpochRecord(EpochRecord* record);
+
+		/**
+		 * Moves to the next epoch, call after unlinking a snapshot.
+		 * @return The epoch to retire the snapshot with
+		 */
+		inline uint64 advanceEpoch() { return globalEpoch.fetch_add(1) + 1; }
+
+		/**
+		 * A snapshot retired in epoch e can be freed once this is at least e.
+		 * @return The epoch of the oldest read in progress, or the maximum value if nothing is reading
+		 */
+		uint64 oldestReadEpoch();
+
+		/**
+		 * Epoch based reclamation for dispatcher snapshots. Senders hold a guard while they use a snapshot, which costs
+		 * a store to a thread owned cache line rather than a lock or a shared reference count.
+		 */
+		class EpochGuard final {
+			EpochGuard(const EpochGuard&) = delete;
+			EpochGuard& operator=(const EpochGuard&) = delete;
+			private:
+				EpochRecord* m_record;
+				bool m_temporary;
+
+			public:
+				EpochGuard() : m_record(localEpochRecord), m_temporary(false) {
+					if (!m_record) m_record = acquireEpochRecord(m_temporary);
+					// Announced before the snapshot pointer is loaded, writers that unlink it afterwards will see the announcement
+					if (m_record->depth++ == 0) m_record->epoch.store(globalEpoch.load());
+				}
+
+				~EpochGuard() {
+					if (--m_record->depth == 0) m_record->epoch.store(0, std::memory_order_release);
+					if (m_temporary) releaseEpochRecord(m_record);
+				}
+		};
+	}
+}
+
+#endif
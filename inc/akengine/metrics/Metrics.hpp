@@ -0,0 +1,248 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_METRICS_METRICS_HPP_
+#define AK_METRICS_METRICS_HPP_
+
+#include <akcommon/FrameStats.hpp>
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/data/PValue.hpp>
+#include <akengine/data/SmartEnum.hpp>
+#include <akengine/filesystem/Path.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace akmet {
+
+	AK_SMART_TENUM_CLASS(MetricType, uint8,
+		Counter,
+		Gauge,
+		Histogram
+	)
+
+	AK_SMART_TENUM_CLASS(ExportFormat, uint8,
+		JsonLines,
+		Prometheus
+	)
+
+	using Labels = std::vector<std::pair<std::string, std::string>>;
+
+	/**
+	 * Monotonically increasing count, safe to add to from any thread.
+	 */
+	class Counter final {
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+		private:
+			std::atomic<uint64> m_value;
+
+		public:
+			Counter() : m_value(0) {}
+
+			void add(uint64 amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+			uint64 value() const { return m_value.load(std::memory_order_relaxed); }
+	};
+
+	/**
+	 * Current value that may go up and down, safe to modify from any thread.
+	 */
+	class Gauge final {
+		Gauge(const Gauge&) = delete;
+		Gauge& operator=(const Gauge&) = delete;
+		private:
+			std::atomic<int64> m_value;
+
+		public:
+			Gauge() : m_value(0) {}
+
+			void set(int64 value) { m_value.store(value, std::memory_order_relaxed); }
+			void add(int64 amount) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+			void sub(int64 amount) { m_value.fetch_sub(amount, std::memory_order_relaxed); }
+			int64 value() const { return m_value.load(std::memory_order_relaxed); }
+	};
+
+	namespace internal {
+		constexpr akSize MAX_SHARDED_METRICS = 512;
+
+		/// One per thread, each slot is only ever written by the owning thread
+		struct alignas(64) MetricShard final {
+			std::array<std::atomic<int64>, MAX_SHARDED_METRICS> values;
+
+			MetricShard() : values() {
+				for(auto& value : values) value.store(0, std::memory_order_relaxed);
+			}
+		};
+
+		/// Null until the thread first adds to a sharded metric, and again once the thread has exited
+		inline thread_local MetricShard* currentShard = nullptr;
+
+		/// Creates the thread's shard, or adds to the exited thread totals during thread teardown
+		void addToShardSlow(akSize slot, int64 amount);
+		int64 sumShards(akSize slot);
+
+		inline void addToShard(akSize slot, int64 amount) {
+			if (auto shard = currentShard) {
+				auto& value = shard->values[slot];
+				value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+			} else addToShardSlow(slot, amount);
+		}
+	}
+
+	/**
+	 * Counter for hot paths shared between threads. Each thread adds to its own shard without a read-modify-write, the shards are summed when read.
+	 */
+	class ShardedCounter final {
+		ShardedCounter(const ShardedCounter&) = delete;
+		ShardedCounter& operator=(const ShardedCounter&) = delete;
+		private:
+			akSize m_slot;
+
+		public:
+			explicit ShardedCounter(akSize slot) : m_slot(slot) {}
+
+			void add(uint64 amount = 1) { internal::addToShard(m_slot, static_cast<int64>(amount)); }
+			uint64 value() const { return static_cast<uint64>(internal::sumShards(m_slot)); }
+	};
+
+	/**
+	 * Gauge for hot paths shared between threads, see ShardedCounter. It can't be set as the value only exists as a sum.
+	 */
+	class ShardedGauge final {
+		ShardedGauge(const ShardedGauge&) = delete;
+		ShardedGauge& operator=(const ShardedGauge&) = delete;
+		private:
+			akSize m_slot;
+
+		public:
+			explicit ShardedGauge(akSize slot) : m_slot(slot) {}
+
+			void add(int64 amount) { internal::addToShard(m_slot, amount); }
+			void sub(int64 amount) { internal::addToShard(m_slot, -amount); }
+			int64 value() const { return internal::sumShards(m_slot); }
+	};
+
+	struct HistogramSummary {
+		uint64 count = 0;
+		uint64 sum = 0;
+		uint64 p50 = 0;
+		uint64 p95 = 0;
+		uint64 p99 = 0;
+		uint64 max = 0;
+	};
+
+	/**
+	 * Distribution of values since startup, using akc::LogLinearHistogram's buckets.
+	 * Unlike the frame statistics any number of threads may record into it concurrently.
+	 */
+	class Histogram final {
+		Histogram(const Histogram&) = delete;
+		Histogram& operator=(const Histogram&) = delete;
+		private:
+			using layout_t = akc::LogLinearHistogram;
+
+			std::array<std::atomic<uint64>, layout_t::BUCKET_COUNT> m_buckets;
+			std::atomic<uint64> m_count;
+			std::atomic<uint64> m_sum;
+			std::atomic<uint64> m_max;
+
+		public:
+			Histogram() : m_buckets(), m_count(0), m_sum(0), m_max(0) {
+				for(auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+			}
+
+			void record(uint64 value) {
+				m_buckets[layout_t::bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+				m_count.fetch_add(1, std::memory_order_relaxed);
+				m_sum.fetch_add(value, std::memory_order_relaxed);
+				auto max = m_max.load(std::memory_order_relaxed);
+				while((value > max) && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+			}
+
+			/// Records a duration in nanoseconds
+			template<typename rep_t, typename period_t> void record(const std::chrono::duration<rep_t, period_t>& duration) {
+				record(static_cast<uint64>(std::max<int64>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count())));
+			}
+
+			HistogramSummary summary() const;
+	};
+
+	struct MetricSample {
+		std::string name;
+		Labels labels;
+		MetricType type;
+		int64 value;                /// Counters and gauges
+		HistogramSummary histogram; /// Histograms
+	};
+
+	/**
+	 * Finds or creates a metric, kept for the life of the program.
+	 * Lookups take a lock, so cache the reference in a static (or a member for per-instance labels) rather than calling this on hot paths:
+	 *   static akmet::Counter& converted = akmet::counter("assets.converted");
+	 * @param name Dotted lower camel case, e.g. "log.deferredFallbacks"
+	 */
+	Counter&   counter(const std::string_view& name, const Labels& labels = {});
+	Gauge&     gauge(const std::string_view& name, const Labels& labels = {});
+	Histogram& histogram(const std::string_view& name, const Labels& labels = {});
+
+	/**
+	 * Sharded variants are exported as counters and gauges, but can't share a name and labels with an unsharded metric.
+	 * Each takes a slot in every thread's shard, so reserve them for metrics updated on hot paths from many threads.
+	 */
+	ShardedCounter& shardedCounter(const std::string_view& name, const Labels& labels = {});
+	ShardedGauge&   shardedGauge(const std::string_view& name, const Labels& labels = {});
+
+	/**
+	 * As shardedCounter, for metrics that are optional.
+	 * @return Null once every sharded slot is taken, where shardedCounter would throw
+	 */
+	ShardedCounter* tryShardedCounter(const std::string_view& name, const Labels& labels = {});
+
+	/**
+	 * @return The current value of every registered metric, in registration order
+	 */
+	std::vector<MetricSample> snapshot();
+
+	/// One JSON object per snapshot, terminated by a newline
+	std::string formatJsonLine(const std::vector<MetricSample>& samples);
+
+	/// Prometheus text exposition format, histograms are written as summaries
+	std::string formatPrometheus(const std::vector<MetricSample>& samples);
+
+	/**
+	 * Writes a snapshot now. JSON lines are appended, Prometheus files are replaced atomically for textfile collectors.
+	 */
+	bool exportSnapshot(ExportFormat format, const akfs::Path& path);
+
+	/**
+	 * Exports a snapshot every interval from a background thread, restarting the exporter if it is already running.
+	 */
+	bool startExporting(ExportFormat format, const akfs::Path& path, uint32 intervalMS);
+
+	/**
+	 * Stops the background exporter after writing a final snapshot.
+	 */
+	bool stopExporting();
+	bool isExporting();
+}
+
+AK_SMART_ENUM_SERIALIZE(akmet, ExportFormat)
+
+#endif
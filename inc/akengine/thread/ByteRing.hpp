@@ -0,0 +1,136 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_THREAD_BYTERING_HPP_
+#define AK_THREAD_BYTERING_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace akt {
+
+	/**
+	 * Single-producer, single-consumer ring of variable sized records.
+	 * Records are contiguous and 8 byte aligned, a record that would straddle the end of the buffer is moved to the start.
+	 * Neither side locks or allocates after construction.
+	 */
+	class ByteRing final {
+		ByteRing(const ByteRing&) = delete;
+		ByteRing& operator=(const ByteRing&) = delete;
+		private:
+			struct Frame {
+				uint32 frameSize;   /// Bytes to the next frame, including this header
+				uint32 payloadSize; /// PADDING for skipped space at the end of the buffer
+			};
+			static constexpr uint32 PADDING = 0xFFFFFFFF;
+			static constexpr akSize ALIGNMENT = 8;
+			static_assert(sizeof(Frame) == ALIGNMENT, "ByteRing: Frame header must match alignment.");
+
+			std::unique_ptr<uint8[]> m_buffer;
+			akSize m_capacity;
+
+			alignas(64) std::atomic<uint64> m_head; /// Written by the producer
+			uint64 m_reserveHead;
+			akSize m_reserveSize;
+
+			alignas(64) std::atomic<uint64> m_tail; /// Written by the consumer
+
+			static akSize align(akSize size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+		public:
+			/**
+			 * @param capacity Size of the buffer in bytes, must be a power of two
+			 */
+			explicit ByteRing(akSize capacity) : m_buffer(new uint8[capacity]), m_capacity(capacity), m_head(0), m_reserveHead(0), m_reserveSize(0), m_tail(0) {
+				if ((capacity < 64) || ((capacity & (capacity - 1)) != 0)) throw std::invalid_argument("ByteRing: Capacity must be a power of two of at least 64 bytes.");
+			}
+
+			/**
+			 * Reserves space for a record, only valid until the next reserve or commit. Producer only.
+			 * @return Pointer to size writable bytes, or nullptr if the ring is full
+			 */
+			uint8* reserve(akSize size) {
+				auto frameSize = align(static_cast<akSize>(sizeof(Frame)) + size);
+				if (frameSize > m_capacity/2) return nullptr;
+
+				auto head = m_head.load(std::memory_order_relaxed);
+				auto tail = m_tail.load(std::memory_order_acquire);
+				auto offset = static_cast<akSize>(head & (m_capacity - 1));
+				auto contiguous = m_capacity - offset;
+
+				if (frameSize > contiguous) {
+					if ((head - tail) + contiguous + frameSize > m_capacity) return nullptr;
+					Frame padding{static_cast<uint32>(contiguous), PADDING};
+					std::memcpy(m_buffer.get() + offset, &padding, sizeof(Frame));
+					head += contiguous;
+					offset = 0;
+					// Publish the padding now so a failed commit can't strand it
+					m_head.store(head, std::memory_order_release);
+				} else if ((head - tail) + frameSize > m_capacity) {
+					return nullptr;
+				}
+
+				Frame frame{static_cast<uint32>(frameSize), static_cast<uint32>(size)};
+				std::memcpy(m_buffer.get() + offset, &frame, sizeof(Frame));
+
+				m_reserveHead = head;
+				m_reserveSize = frameSize;
+				return m_buffer.get() + offset + sizeof(Frame);
+			}
+
+			/**
+			 * Publishes the last reserved record to the consumer. Producer only.
+			 */
+			void commit() {
+				m_head.store(m_reserveHead + m_reserveSize, std::memory_order_release);
+				m_reserveSize = 0;
+			}
+
+			/**
+			 * Passes every published record to func and releases its space. Consumer only.
+			 * @param func Callable taking (const uint8* data, akSize size)
+			 * @return The number of records drained
+			 */
+			template<typename func_t> akSize drain(const func_t& func) {
+				auto tail = m_tail.load(std::memory_order_relaxed);
+				auto head = m_head.load(std::memory_order_acquire);
+
+				akSize count = 0;
+				while(tail < head) {
+					auto data = m_buffer.get() + (tail & (m_capacity - 1));
+					Frame frame;
+					std::memcpy(&frame, data, sizeof(Frame));
+					if (frame.payloadSize != PADDING) {
+						func(static_cast<const uint8*>(data + sizeof(Frame)), static_cast<akSize>(frame.payloadSize));
+						count++;
+					}
+					tail += frame.frameSize;
+				}
+
+				m_tail.store(tail, std::memory_order_release);
+				return count;
+			}
+
+			bool empty() const { return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire); }
+			akSize capacity() const { return m_capacity; }
+	};
+
+}
+
+#endif
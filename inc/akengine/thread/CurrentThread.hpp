@@ -39,11 +39,15 @@ namespace akt {
 			}
 
 			bool schedule(const std::function<void()>& func);
+			TimerID scheduleAfter(int64 delayMicroseconds, const std::function<void()>& func);
+			TimerID scheduleEvery(int64 intervalMicroseconds, const std::function<void()>& func);
+			bool cancel(TimerID id);
 			bool update();
 			bool setName(const std::string& name);
 
 			bool yield() const;
 			bool sleep(int64 microseconds) const;
+			bool park(int64 maxMicroseconds = -1) const;
 
 			bool isCloseRequested() const;
 
@@ -33,7 +33,7 @@ namespace akt {
 			std::vector<type_t> m_buffers[2];
 
 		public:
-			DoubleBuffer() = default;
+			DoubleBuffer() : m_writeLock("DoubleBuffer::Write"), m_readLock("DoubleBuffer::Read"), m_index(0) {}
 			~DoubleBuffer() = default;
 
 			void swap() {
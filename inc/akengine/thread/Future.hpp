@@ -0,0 +1,334 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_THREAD_FUTURE_HPP_
+#define AK_THREAD_FUTURE_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace akt {
+	template<typename type_t> class Future;
+	template<typename type_t> class Promise;
+
+	namespace internal {
+		struct FutureVoid {};
+		template<typename type_t> using future_value_t = std::conditional_t<std::is_void_v<type_t>, FutureVoid, type_t>;
+
+		template<typename type_t, typename func_t> struct continuation_result { using type = std::invoke_result_t<func_t, const type_t&>; };
+		template<typename func_t> struct continuation_result<void, func_t> { using type = std::invoke_result_t<func_t>; };
+		template<typename type_t, typename func_t> using continuation_result_t = typename continuation_result<type_t, func_t>::type;
+
+		template<typename type_t> class SharedState final {
+			SharedState(const SharedState&) = delete;
+			SharedState& operator=(const SharedState&) = delete;
+			public:
+				using value_type = future_value_t<type_t>;
+
+			private:
+				/// Number of freed states kept per thread for reuse
+				static constexpr akSize POOL_CAPACITY = 64;
+
+				struct Pool final {
+					std::vector<void*> blocks;
+					bool& destroyed;
+					Pool(bool& destroyed) : blocks(), destroyed(destroyed) { blocks.reserve(POOL_CAPACITY); }
+					~Pool() {
+						destroyed = true;
+						for(auto* block : blocks) ::operator delete(block);
+					}
+				};
+
+				/// Null once the thread's pool has been destroyed, states released during thread or static teardown use the heap directly
+				static Pool* pool() {
+					thread_local bool destroyed = false; // Trivially destructible, so still readable after the pool is gone
+					if (destroyed) return nullptr;
+					thread_local Pool instance(destroyed);
+					return &instance;
+				}
+
+				akt::Spinlock m_lock;
+				std::atomic<bool> m_ready;
+				std::atomic<uint32> m_references;
+
+				std::optional<value_type> m_value;
+				std::exception_ptr m_exception;
+				std::vector<std::function<void()>> m_continuations;
+
+				template<typename func_t> bool complete(const func_t& assign) {
+					std::vector<std::function<void()>> continuations;
+					/* Publish */ {
+						auto lock = m_lock.lock();
+						if (m_ready.load(std::memory_order_relaxed)) return false;
+						assign();
+						m_ready.store(true, std::memory_order_release);
+						continuations = std::move(m_continuations);
+					}
+					for(auto& continuation : continuations) continuation();
+					return true;
+				}
+
+			public:
+				static void* operator new(std::size_t size) {
+					auto* instance = pool();
+					if (!instance || instance->blocks.empty()) return ::operator new(size);
+					auto* block = instance->blocks.back(); instance->blocks.pop_back();
+					return block;
+				}
+
+				static void operator delete(void* block) {
+					auto* instance = pool();
+					if (!instance || (instance->blocks.size() >= POOL_CAPACITY)) ::operator delete(block);
+					else instance->blocks.push_back(block);
+				}
+
+				SharedState() : m_lock("Future"), m_ready(false), m_references(1) {}
+
+				void acquire() { m_references.fetch_add(1, std::memory_order_relaxed); }
+				void release() { if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+
+				template<typename... vargs_t> bool setValue(vargs_t&&... vargs) {
+					return complete([&]{ m_value.emplace(std::forward<vargs_t>(vargs)...); });
+				}
+
+				bool setException(const std::exception_ptr& exception) {
+					return complete([&]{ m_exception = exception; });
+				}
+
+				void onReady(std::function<void()> func) {
+					/* Defer */ {
+						auto lock = m_lock.lock();
+						if (!m_ready.load(std::memory_order_relaxed)) { m_continuations.push_back(std::move(func)); return; }
+					}
+					func();
+				}
+
+				bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+				const value_type& value() const { return *m_value; }
+				const std::exception_ptr& exception() const { return m_exception; }
+		};
+
+		template<typename result_t, typename func_t, typename... vargs_t> void invokeInto(const Promise<result_t>& promise, const func_t& func, const vargs_t&... vargs) {
+			try {
+				if constexpr (std::is_void_v<result_t>) { func(vargs...); promise.set(); }
+				else promise.set(func(vargs...));
+			} catch(...) {
+				promise.setException(std::current_exception());
+			}
+		}
+	}
+
+	/**
+	 * Read side of an asynchronous result.
+	 * Copies share the same result, continuations run on the thread that fulfils the promise unless given an executor.
+	 */
+	template<typename type_t> class Future final {
+		template<typename> friend class Promise;
+		public:
+			using value_type = type_t;
+
+		private:
+			internal::SharedState<type_t>* m_state;
+
+			Future(internal::SharedState<type_t>* state) : m_state(state) { if (m_state) m_state->acquire(); }
+
+			template<typename result_t, typename func_t> void forwardTo(const Promise<result_t>& promise, const func_t& func) const {
+				if (m_state->exception()) promise.setException(m_state->exception());
+				else if constexpr (std::is_void_v<type_t>) internal::invokeInto(promise, func);
+				else internal::invokeInto(promise, func, m_state->value());
+			}
+
+		public:
+			Future() : m_state(nullptr) {}
+			Future(const Future& other) : Future(other.m_state) {}
+			Future(Future&& other) : m_state(std::exchange(other.m_state, nullptr)) {}
+			~Future() { if (m_state) m_state->release(); }
+
+			Future& operator=(Future other) { std::swap(m_state, other.m_state); return *this; }
+
+			bool valid() const { return m_state != nullptr; }
+			bool isReady() const { return m_state && m_state->isReady(); }
+			bool isFailed() const { return isReady() && m_state->exception(); }
+
+			/**
+			 * Non-blocking access to the result.
+			 * @return A pointer to the result, or nullptr if not ready. For Future<void>, whether it has completed.
+			 * @throws The exception the producer failed with, if any.
+			 */
+			auto tryGet() const {
+				if constexpr (std::is_void_v<type_t>) {
+					if (!isReady()) return false;
+					if (m_state->exception()) std::rethrow_exception(m_state->exception());
+					return true;
+				} else {
+					if (!isReady()) return static_cast<const type_t*>(nullptr);
+					if (m_state->exception()) std::rethrow_exception(m_state->exception());
+					return &m_state->value();
+				}
+			}
+
+			/**
+			 * Yields the calling thread until the result is ready. Prefer then() or tryGet() on engine threads.
+			 */
+			const Future& wait() const {
+				if (!m_state) throw std::logic_error("Future: Attempted to wait on an empty future.");
+				while(!m_state->isReady()) std::this_thread::yield();
+				return *this;
+			}
+
+			/**
+			 * Calls func once the result is ready, immediately if it already is.
+			 * @param func Callable taking no arguments
+			 */
+			template<typename func_t> void onReady(const func_t& func) const {
+				if (!m_state) throw std::logic_error("Future: Attempted to attach to an empty future.");
+				m_state->onReady(std::function<void()>(func));
+			}
+
+			/**
+			 * Chains func to run on the fulfilling thread with the result.
+			 * @return A future for the result of func. Failures propagate without calling func.
+			 */
+			template<typename func_t> Future<internal::continuation_result_t<type_t, func_t>> then(const func_t& func) const {
+				Promise<internal::continuation_result_t<type_t, func_t>> promise;
+				auto result = promise.future();
+				auto source = *this;
+				onReady([source, promise, func]{ source.forwardTo(promise, func); });
+				return result;
+			}
+
+			/**
+			 * Chains func to run with the result, scheduled through executor (an akt::Thread or akt::CurrentThread).
+			 * @return A future for the result of func. Failures propagate without calling func.
+			 */
+			template<typename executor_t, typename func_t> Future<internal::continuation_result_t<type_t, func_t>> then(executor_t& executor, const func_t& func) const {
+				Promise<internal::continuation_result_t<type_t, func_t>> promise;
+				auto result = promise.future();
+				auto source = *this;
+				onReady([&executor, source, promise, func]{
+					executor.schedule(std::function<void()>([source, promise, func]{ source.forwardTo(promise, func); }));
+				});
+				return result;
+			}
+	};
+
+	/**
+	 * Write side of an asynchronous result. Only the first value or exception set is kept.
+	 */
+	template<typename type_t> class Promise final {
+		private:
+			internal::SharedState<type_t>* m_state;
+
+		public:
+			Promise() : m_state(new internal::SharedState<type_t>()) {}
+			Promise(const Promise& other) : m_state(other.m_state) { m_state->acquire(); }
+			Promise(Promise&& other) : m_state(std::exchange(other.m_state, nullptr)) {}
+			~Promise() { if (m_state) m_state->release(); }
+
+			Promise& operator=(Promise other) { std::swap(m_state, other.m_state); return *this; }
+
+			Future<type_t> future() const { return Future<type_t>(m_state); }
+
+			template<typename... vargs_t> bool set(vargs_t&&... vargs) const { return m_state->setValue(std::forward<vargs_t>(vargs)...); }
+			bool setException(const std::exception_ptr& exception) const { return m_state->setException(exception); }
+
+			/**
+			 * Sets the promise to the result of func, or the exception it throws.
+			 */
+			template<typename func_t> void setWith(const func_t& func) const { internal::invokeInto(*this, func); }
+	};
+
+	/**
+	 * Creates a future that is already fulfilled with the given value.
+	 */
+	template<typename type_t, typename... vargs_t> Future<type_t> makeReadyFuture(vargs_t&&... vargs) {
+		Promise<type_t> promise;
+		promise.set(std::forward<vargs_t>(vargs)...);
+		return promise.future();
+	}
+
+	/**
+	 * Creates a future that is fulfilled once all the given futures are.
+	 * @return The results in order (nothing for void), or the first failure encountered
+	 */
+	template<typename type_t> auto whenAll(const std::vector<Future<type_t>>& futures) {
+		using result_t = std::conditional_t<std::is_void_v<type_t>, void, std::vector<type_t>>;
+
+		struct Join {
+			std::vector<Future<type_t>> futures;
+			std::atomic<akSize> remaining;
+			Promise<result_t> promise;
+		};
+
+		auto join = std::make_shared<Join>();
+		join->futures = futures;
+		join->remaining = static_cast<akSize>(futures.size());
+		auto result = join->promise.future();
+
+		auto finish = [join]{
+			for(const auto& future : join->futures) {
+				if (future.isFailed()) {
+					try { future.tryGet(); } catch(...) { join->promise.setException(std::current_exception()); }
+					return;
+				}
+			}
+
+			if constexpr (std::is_void_v<type_t>) {
+				join->promise.set();
+			} else {
+				std::vector<type_t> values;
+				values.reserve(join->futures.size());
+				for(const auto& future : join->futures) values.push_back(*future.tryGet());
+				join->promise.set(std::move(values));
+			}
+		};
+
+		if (futures.empty()) finish();
+		for(const auto& future : futures) future.onReady([join, finish]{ if (--join->remaining == 0) finish(); });
+
+		return result;
+	}
+
+	/**
+	 * Creates a future that is fulfilled once any of the given futures are.
+	 * @return The index of the first future to complete, whether it succeeded or failed
+	 * @throws std::invalid_argument if no futures are given
+	 */
+	template<typename type_t> Future<akSize> whenAny(const std::vector<Future<type_t>>& futures) {
+		if (futures.empty()) throw std::invalid_argument("whenAny: Attempted to wait on an empty set of futures.");
+
+		Promise<akSize> promise;
+		auto result = promise.future();
+		for(akSize i = 0; i < futures.size(); i++) futures[i].onReady([promise, i]{ promise.set(i); });
+
+		return result;
+	}
+}
+
+#endif
@@ -17,37 +17,101 @@
 #ifndef AK_THREAD_SPINLOCK_HPP_
 #define AK_THREAD_SPINLOCK_HPP_
 
+#include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/ScopeGuard.hpp>
 #include <atomic>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 namespace akt {
 
+	namespace internal {
+		struct SpinlockCounters {
+			std::atomic<uint64> acquisitions{0};
+			std::atomic<uint64> contended{0};
+			std::atomic<uint64> waitNS{0};
+		};
+
+		/**
+		 * Returns the shared counters for the given lock name, creating them on first use.
+		 * @remark Only used when built with AK_SPINLOCK_STATS
+		 */
+		SpinlockCounters* spinlockCountersFor(const std::string_view& name);
+
+		void spinlockPark(std::atomic<uint32>& state, uint32 expected);
+		void spinlockWake(std::atomic<uint32>& state);
+	}
+
+	struct SpinlockStatistics {
+		std::string name;
+		uint64 acquisitions;
+		uint64 contended;
+		uint64 waitNS;
+	};
+
+	/**
+	 * Returns a snapshot of the per-name lock statistics, ordered by total wait time.
+	 * @return The lock statistics, or an empty list if not built with AK_SPINLOCK_STATS
+	 */
+	std::vector<SpinlockStatistics> spinlockStatistics();
+
+	/**
+	 * An adaptive lock. Spins with exponential backoff for a fixed budget and then parks the thread
+	 * (futex on linux, yield elsewhere) until the holder releases it.
+	 */
 	class Spinlock final {
 		private:
-			static constexpr auto LOCK_MEMORY_ORDER = std::memory_order_acq_rel;
+			static constexpr uint32 STATE_UNLOCKED = 0;
+			static constexpr uint32 STATE_LOCKED   = 1;
+			static constexpr uint32 STATE_WAITERS  = 2;
+
+			/// Number of backoff rounds before the lock parks
+			static constexpr uint32 SPIN_BUDGET = 16;
 
-			mutable std::atomic<bool> m_lock;
+			/// Maximum number of pause instructions per backoff round
+			static constexpr uint32 MAX_BACKOFF = 64;
+
+			mutable std::atomic<uint32> m_state;
 			mutable std::thread::id m_lastAcquiredThread;
 
+#			ifdef AK_SPINLOCK_STATS
+			internal::SpinlockCounters* m_stats;
+#			endif
+
+			void lockContended() const;
+
 		protected:
 			void unlock() const {
-				m_lock.exchange(false, LOCK_MEMORY_ORDER);
+				if (m_state.exchange(STATE_UNLOCKED, std::memory_order_release) == STATE_WAITERS) internal::spinlockWake(m_state);
 			}
 
 		public:
-			Spinlock() : m_lock(false), m_lastAcquiredThread(std::this_thread::get_id()) {}
+			Spinlock() : Spinlock(std::string_view("Unnamed", 7)) {}
+
+			explicit Spinlock(const std::string_view& name [[maybe_unused]]) : m_state(STATE_UNLOCKED), m_lastAcquiredThread(std::this_thread::get_id())
+#				ifdef AK_SPINLOCK_STATS
+				, m_stats(internal::spinlockCountersFor(name))
+#				endif
+				{}
 
 			akc::ScopeGuard tryLock() const {
-				if (m_lock.exchange(true, LOCK_MEMORY_ORDER)) return akc::ScopeGuard();
+				uint32 expected = STATE_UNLOCKED;
+				if (!m_state.compare_exchange_strong(expected, STATE_LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) return akc::ScopeGuard();
+#				ifdef AK_SPINLOCK_STATS
+				m_stats->acquisitions.fetch_add(1, std::memory_order_relaxed);
+#				endif
 				m_lastAcquiredThread = std::this_thread::get_id();
 				return [&](){unlock();};
 			}
 
 			akc::ScopeGuard lock() const {
-				akc::ScopeGuard result;
-				while((result = tryLock()).empty()) std::this_thread::yield();
-				return result;
+				akc::ScopeGuard result = tryLock();
+				if (!result.empty()) return result;
+				lockContended();
+				m_lastAcquiredThread = std::this_thread::get_id();
+				return [&](){unlock();};
 			}
 
 			std::thread::id lastAcquiredThread() const {
@@ -20,11 +20,17 @@
 #include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/ScopeGuard.hpp>
 #include <akengine/thread/DoubleBuffer.hpp>
+#include <akengine/thread/Future.hpp>
 #include <akengine/thread/Spinlock.hpp>
+#include <akengine/thread/TimerWheel.hpp>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace akt {
 	class CurrentThread;
@@ -37,6 +43,7 @@ namespace akt {
 			Thread& operator=(const Thread&) = delete;
 
 			std::string m_name;
+			std::string m_role;
 			uint64 m_id;
 			std::thread::id m_threadId;
 			akt::Spinlock m_lock;
@@ -47,17 +54,29 @@ namespace akt {
 			akt::DoubleBuffer<std::function<void()>> m_scheduledCallbacks;
 			akt::Spinlock m_updateLock;
 
+			akt::TimerWheel m_timers;
+			akt::Spinlock m_timerLock;
+			std::vector<TimerWheel::Expired> m_expiredTimers;
+
+			std::mutex m_parkLock;
+			std::condition_variable m_parkSignal;
+			std::atomic<bool> m_parked;
+			std::atomic<bool> m_wakeRequested;
+
+			akc::ScopeGuard prepareThreadCreation();
 			akc::ScopeGuard performThreadStartup();
 
 		public:
 			Thread();
 			Thread(const std::string& name);
+			Thread(const std::string& name, const std::string& role);
 			~Thread();
 
 			template<typename func_t> bool execute(const func_t& callback) {
 				if (m_runLock.exchange(true)) return false;
 
 				m_closeRequested = false;
+				auto creationGuard = prepareThreadCreation();
 				m_thread = std::thread([this, callback]() {
 					auto threadCleanup = performThreadStartup();
 					callback();
@@ -66,14 +85,54 @@ namespace akt {
 				return true;
 			}
 
-			template<typename func_t> void schedule(const func_t& func) {
-				schedule(std::function<void(Thread&)>(func));
+			/**
+			 * Schedules func to be run during this thread's next update.
+			 * @return A future for the result of func
+			 */
+			template<typename func_t> Future<std::invoke_result_t<func_t>> schedule(const func_t& func) {
+				Promise<std::invoke_result_t<func_t>> promise;
+				auto result = promise.future();
+				schedule(std::function<void()>([promise, func]{ promise.setWith(func); }));
+				return result;
 			}
 
 			void schedule(const std::function<void()>& func);
+
+			/**
+			 * Schedules func to be run during the first update after the delay has passed.
+			 * Timers have millisecond resolution.
+			 * @return A handle for cancel()
+			 */
+			TimerID scheduleAfter(int64 delayMicroseconds, const std::function<void()>& func);
+
+			/**
+			 * Schedules func to be run during updates, once every interval. Missed intervals are coalesced into one call.
+			 * @return A handle for cancel()
+			 */
+			TimerID scheduleEvery(int64 intervalMicroseconds, const std::function<void()>& func);
+
+			/**
+			 * Cancels a timer. Timers that already expired during the current update still run.
+			 * @return If the timer was still pending
+			 */
+			bool cancel(TimerID id);
+
+			/**
+			 * Runs scheduled callbacks and expired timers.
+			 * @return If this is the current thread and it isn't already updating
+			 */
 			bool update();
 
+			/**
+			 * Blocks the current thread until the next timer deadline, newly scheduled work, a close request or the maximum wait.
+			 * @param maxMicroseconds The maximum time to wait, negative to wait indefinitely
+			 * @return If this is the current thread
+			 */
+			bool park(int64 maxMicroseconds = -1);
+			void wake();
+
 			void setName(const std::string& name);
+			void setRole(const std::string& role);
 
 			Thread& requestClose();
 			Thread& cancelClose();
@@ -88,6 +147,7 @@ namespace akt {
 			bool isCurrent() const;
 
 			const std::string& name() const;
+			const std::string& role() const;
 			uint64 id() const;
 			std::thread::id threadID() const;
 	};
@@ -0,0 +1,104 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_THREAD_THREADROLE_HPP_
+#define AK_THREAD_THREADROLE_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akcommon/ScopeGuard.hpp>
+#include <akengine/data/SmartClass.hpp>
+#include <akengine/data/SmartEnum.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace akt {
+	AK_SMART_TENUM_CLASS(SchedulePolicy, uint8,
+		Normal,
+		Batch,
+		Idle,
+		Realtime
+	)
+
+	/**
+	 * Scheduling parameters shared by every thread with the same role.
+	 * Loaded from the "threads" section of the engine config, keyed by role name.
+	 * The generated config only elevates Audio, to realtime. Without the privilege it falls back to Normal with a warning.
+	 */
+	struct ThreadRole final {
+		std::vector<uint32> affinity; /// CPUs the thread may run on, empty for any
+		SchedulePolicy policy;        /// Realtime falls back to Normal where not permitted
+		int32 niceLevel;              /// Applied to non-realtime policies
+		int32 realtimePriority;       /// Applied to the realtime policy
+		uint64 stackSize;             /// Stack size in bytes, 0 for the platform default
+	};
+
+	/// The role configuration a thread actually ended up with
+	struct ThreadTopology final {
+		std::string threadName;
+		std::string roleName;
+		std::vector<uint32> affinity;
+		SchedulePolicy policy;
+		int32 niceLevel;
+		int32 realtimePriority;
+		uint64 stackSize;
+		bool fullyApplied;
+	};
+
+	/**
+	 * Returns the configuration for the given role, or the "Default" role if it isn't configured
+	 * @param roleName The name of the role
+	 * @return The role configuration
+	 */
+	ThreadRole threadRole(const std::string& roleName);
+	void setThreadRole(const std::string& roleName, const ThreadRole& role);
+
+	/**
+	 * Applies the role's affinity and scheduling to the calling thread and records the result in the topology.
+	 * @return If every setting could be applied
+	 */
+	bool applyThreadRole(const std::string& threadName, const std::string& roleName);
+
+	/// Doesn't make any system calls, so realtime threads can hand themselves off to applyThreadRole
+	std::thread::native_handle_type currentThreadHandle();
+
+	/**
+	 * Applies the role to another thread, for threads that shouldn't do it themselves (ie. realtime callbacks).
+	 * @remark Nice levels can only be set by the thread itself, roles with one are not fully applied.
+	 * @return If every setting could be applied
+	 */
+	bool applyThreadRole(std::thread::native_handle_type thread, const std::string& threadName, const std::string& roleName);
+
+	/**
+	 * Makes threads created before the returned guard is destroyed use the role's stack size.
+	 * @remark Holds a lock for the lifetime of the guard, only create a single thread with it.
+	 */
+	akc::ScopeGuard prepareThreadCreation(const std::string& roleName);
+
+	std::vector<ThreadTopology> threadTopology();
+}
+
+AK_SMART_ENUM_SERIALIZE(akt, SchedulePolicy)
+
+AK_SMART_CLASS(akt::ThreadRole,
+	FIELD_DEFAULT, affinity,         std::vector<uint32>(),
+	FIELD_DEFAULT, policy,           akt::SchedulePolicy::Normal,
+	FIELD_DEFAULT, niceLevel,        0,
+	FIELD_DEFAULT, realtimePriority, 0,
+	FIELD_DEFAULT, stackSize,        0
+)
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_THREAD_TIMERWHEEL_HPP_
+#define AK_THREAD_TIMERWHEEL_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <array>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace akt {
+	using TimerID = uint64;
+
+	/**
+	 * Hierarchical timer wheel over abstract ticks.
+	 * Adding and cancelling are O(1), advancing is O(1) per tick plus the timers that expire or cascade.
+	 * Not thread safe, the owner is expected to lock around it.
+	 */
+	class TimerWheel final {
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+		public:
+			struct Expired final {
+				TimerID id;
+				std::function<void()> callback;
+				bool periodic;
+			};
+
+		private:
+			static constexpr uint32 NONE = 0xFFFFFFFF;
+
+			static constexpr uint32 ROOT_BITS = 8;
+			static constexpr uint32 LEVEL_BITS = 6;
+			static constexpr uint32 LEVEL_COUNT = 3;
+			static constexpr uint32 ROOT_SLOTS = 1u << ROOT_BITS;
+			static constexpr uint32 LEVEL_SLOTS = 1u << LEVEL_BITS;
+			static constexpr uint32 SLOT_COUNT = ROOT_SLOTS + LEVEL_COUNT*LEVEL_SLOTS;
+
+			/// Furthest a timer can be placed ahead, longer delays are re-cascaded from the top level
+			static constexpr uint64 MAX_DELTA = uint64(1) << (ROOT_BITS + LEVEL_COUNT*LEVEL_BITS);
+
+			struct Node final {
+				uint64 deadline;
+				uint64 interval;
+				uint32 generation;
+				uint32 slot;
+				uint32 prev;
+				uint32 next;
+				std::function<void()> callback;
+			};
+
+			std::vector<Node> m_nodes;
+			std::vector<uint32> m_freeNodes;
+			std::array<uint32, SLOT_COUNT> m_slots;
+
+			uint64 m_current;
+			akSize m_count;
+
+			static uint32 shiftFor(uint32 level) { return ROOT_BITS + level*LEVEL_BITS; }
+
+			void link(uint32 index);
+			void unlink(uint32 index);
+			void release(uint32 index);
+			void cascade(uint32 level);
+
+			bool isValid(TimerID id) const;
+
+		public:
+			/**
+			 * @param startTick The first tick that will be processed
+			 */
+			TimerWheel(uint64 startTick = 0);
+
+			/**
+			 * Adds a timer
+			 * @param deadline The tick to expire on, past deadlines expire on the next processed tick
+			 * @param interval Ticks between expirations for periodic timers, 0 for one-shot
+			 * @return A handle for cancel()
+			 */
+			TimerID add(uint64 deadline, uint64 interval, std::function<void()> callback);
+			bool cancel(TimerID id);
+
+			/**
+			 * Processes every tick up to and including tick, moving the callbacks of expired timers into out.
+			 * Periodic timers are re-armed immediately but expire at most once per call, give their callback back with restore().
+			 */
+			void advance(uint64 tick, std::vector<Expired>& out);
+
+			/**
+			 * Returns a periodic timer's callback after it has been run
+			 * @return If the timer was still active
+			 */
+			bool restore(TimerID id, std::function<void()>&& callback);
+
+			/**
+			 * Returns the earliest tick that needs processing, either for an expiry or a cascade
+			 * @return The tick, or nothing if there are no timers
+			 */
+			std::optional<uint64> nextTick() const;
+
+			uint64 currentTick() const { return m_current; }
+			akSize size() const { return m_count; }
+	};
+}
+
+#endif
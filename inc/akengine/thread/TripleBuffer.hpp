@@ -0,0 +1,108 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_THREAD_TRIPLEBUFFER_HPP_
+#define AK_THREAD_TRIPLEBUFFER_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <atomic>
+
+namespace akt {
+
+	/**
+	 * Wait-free single-producer/single-consumer state handoff.
+	 * The producer fills write() and publishes it, the consumer acquires the most recently published state and reads it.
+	 * Neither side ever blocks or allocates, intermediate states are dropped if the producer outpaces the consumer.
+	 */
+	template<typename type_t> class TripleBuffer final {
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+		private:
+			static constexpr uint8 INDEX_MASK = 0x03;
+			static constexpr uint8 FRESH_FLAG = 0x04;
+			static constexpr akSize CACHE_LINE_SIZE = 64;
+
+			struct alignas(CACHE_LINE_SIZE) Slot { type_t value; };
+
+			Slot m_buffers[3];
+
+			/// Index of the shared buffer, flagged when it holds a state the consumer hasn't seen
+			alignas(CACHE_LINE_SIZE) std::atomic<uint8> m_shared;
+
+			alignas(CACHE_LINE_SIZE) uint8 m_writeIndex;
+			alignas(CACHE_LINE_SIZE) uint8 m_readIndex;
+
+		public:
+			TripleBuffer() : m_buffers(), m_shared(1), m_writeIndex(0), m_readIndex(2) {}
+			TripleBuffer(const type_t& initial) : m_buffers{{initial}, {initial}, {initial}}, m_shared(1), m_writeIndex(0), m_readIndex(2) {}
+			~TripleBuffer() = default;
+
+			// ////////////// //
+			// // Producer // //
+			// ////////////// //
+
+			/**
+			 * Returns the producer's buffer. It retains whatever state was last swapped into it, not the last published state.
+			 * @return The buffer to write the next state into
+			 */
+			type_t& write() { return m_buffers[m_writeIndex].value; }
+
+			/**
+			 * Hands the write buffer to the consumer and takes back the shared buffer.
+			 */
+			void publish() {
+				m_writeIndex = m_shared.exchange(m_writeIndex | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+			}
+
+			/**
+			 * Copies the given state into the write buffer and publishes it.
+			 * @param val The state to publish
+			 */
+			void publish(const type_t& val) {
+				write() = val;
+				publish();
+			}
+
+			// ////////////// //
+			// // Consumer // //
+			// ////////////// //
+
+			/**
+			 * Swaps in the most recently published state, if there is one.
+			 * @return If a new state was acquired
+			 */
+			bool acquire() {
+				if ((m_shared.load(std::memory_order_relaxed) & FRESH_FLAG) == 0) return false;
+				m_readIndex = m_shared.exchange(m_readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+				return true;
+			}
+
+			/**
+			 * Returns the consumer's buffer. Remains stable until the next successful acquire()
+			 * @return The most recently acquired state
+			 */
+			const type_t& read() const { return m_buffers[m_readIndex].value; }
+
+			/**
+			 * Returns if the producer has published a state that hasn't been acquired yet
+			 * @return If a new state is pending
+			 */
+			bool hasPending() const { return (m_shared.load(std::memory_order_relaxed) & FRESH_FLAG) != 0; }
+	};
+
+}
+
+#endif
@@ -1,13 +1,27 @@
 #ifndef AK_GAME_GAME_HPP_
 #define AK_GAME_GAME_HPP_
 
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/debug/Log.hpp>
+#include <string>
+
 namespace akg {
 
-	void startup(const akl::Logger& log);
+	/**
+	 * @param headless Skip the window and GL context, also enabled by engine.headless in the config
+	 */
+	void startup(const akl::Logger& log, bool headless);
 
 	void cleanup(const akl::Logger& log);
 
-	void runGame();
+	/**
+	 * Runs the fixed-step loop until the window is closed or the process is interrupted.
+	 * @param maxTicks Stop after this many updates, 0 for no limit. Headless runs with a limit aren't paced to real time, for measuring throughput.
+	 * @param replayPath Event recording to replay a frame per update, headless only
+	 */
+	void runGame(uint64 maxTicks = 0, const std::string& replayPath = std::string());
+
+	bool isHeadless();
 
 }
 
@@ -57,4 +57,12 @@ namespace akin {
 	};
 }
 
+namespace akev {
+	template<> struct EventKey<akin::KeyEvent> {
+		static constexpr bool enabled = true;
+		using key_type = akin::Key;
+		static key_type extract(const akin::KeyEvent& event) { return event.data().key; }
+	};
+}
+
 #endif
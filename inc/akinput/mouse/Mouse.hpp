@@ -90,4 +90,12 @@ namespace akin {
 	};
 }
 
+namespace akev {
+	template<> struct EventKey<akin::ButtonEvent> {
+		static constexpr bool enabled = true;
+		using key_type = akin::Button;
+		static key_type extract(const akin::ButtonEvent& event) { return event.data().button; }
+	};
+}
+
 #endif
@@ -86,4 +86,8 @@ AK_SMART_CLASS_ARRAY(akm::Vec2, akm::Vec2::length());
 AK_SMART_CLASS_ARRAY(akm::Vec3, akm::Vec3::length());
 AK_SMART_CLASS_ARRAY(akm::Vec4, akm::Vec4::length());
 
+AK_SMART_CLASS_POD(akm::Vec2);
+AK_SMART_CLASS_POD(akm::Vec3);
+AK_SMART_CLASS_POD(akm::Vec4);
+
 #endif
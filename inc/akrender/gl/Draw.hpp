@@ -26,6 +26,22 @@ namespace akr {
 
 		void init();
 
+		struct RecordedCalls final {
+			uint64 draws = 0;
+			uint64 indexedDraws = 0;
+			uint64 vertices = 0;
+			uint64 clears = 0;
+			uint64 stateChanges = 0;
+		};
+
+		/**
+		 * Stands in for init() without a GL context, calls in this header are then counted instead of issued.
+		 * Buffers, textures and shaders still need a real context.
+		 */
+		void initRecording();
+		bool isRecording();
+		RecordedCalls recordedCalls();
+
 		void setViewport(const akm::Vec2& offset, const akm::Vec2& size);
 
 		void draw(DrawType mode, uint32 vertexCount, uint32 offset = 0);
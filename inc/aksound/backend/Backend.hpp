@@ -32,6 +32,12 @@ namespace aks {
 		void stopDevice();
 		bool isDeviceStarted();
 
+		/**
+		 * Finishes work the audio thread hands off, such as applying its thread role once it has started.
+		 * Call regularly from the thread that started the device.
+		 */
+		void update();
+
 		std::optional<ContextInfo> getContextInfo();
 		std::optional<DeviceInfo> getDeviceInfo();
 
@@ -17,8 +17,9 @@
 #include <akasset/AssetRegistry.hpp>
 #include <akcommon/String.hpp>
 #include <akengine/data/Json.hpp>
-#include <akengine/data/PValue.hpp>
+#include <akengine/data/Serialize.hpp>
 #include <akengine/filesystem/Filesystem.hpp>
+#include <akengine/metrics/Metrics.hpp>
 #include <functional>
 #include <stdexcept>
 #include <string>
@@ -28,7 +29,7 @@ using namespace aka;
 bool AssetRegistry::proccessFile(const akfs::Path& path) {
 	if (path.extension() != ".akres") return true;
 
-	auto assetInfo = akd::tryDeserialize<aka::AssetInfo>(akd::fromJsonFile(path));
+	auto assetInfo = akd::fromJsonFile(m_scanDocument, path) ? akd::tryDeserialize<aka::AssetInfo>(m_scanDocument.root()) : std::optional<aka::AssetInfo>();
 	if (!assetInfo) {
 		akl::Logger("AssetFinder").warn("Failed to parse asset info file: ", path.str());
 		return true;
@@ -51,7 +52,7 @@ bool AssetRegistry::proccessFile(const akfs::Path& path) {
 	return true;
 }
 
-AssetRegistry::AssetRegistry(const akfs::Path& scanRoot, bool supressWarnings) : m_supressWarnings(supressWarnings), m_scanRoot(scanRoot), m_assetBySUID() {
+AssetRegistry::AssetRegistry(const akfs::Path& scanRoot, bool supressWarnings) : m_supressWarnings(supressWarnings), m_scanRoot(scanRoot), m_assetBySUID(), m_scanDocument() {
 	rescan();
 }
 
@@ -63,6 +64,9 @@ void AssetRegistry::rescan() {
 	m_assetBySUID.clear();
 	m_assetByDestination.clear();
 	akfs::iterateDirectory(m_scanRoot, std::bind(&AssetRegistry::proccessFile, this, std::placeholders::_1), true);
+
+	static akmet::Gauge& registeredMetric = akmet::gauge("assets.registered");
+	registeredMetric.set(static_cast<int64>(m_assetInfo.size()));
 }
 
 std::optional<std::pair<aka::AssetInfo, akfs::Path>> AssetRegistry::tryGetAssetInfoBySUID(const akd::SUID& suid) const {
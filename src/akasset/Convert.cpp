@@ -23,9 +23,15 @@
 #include <akengine/data/MsgPack.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/Serialize.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
 #include <akengine/filesystem/Filesystem.hpp>
+#include <akengine/metrics/Metrics.hpp>
 #include <akrender/window/WindowOptions.hpp>
+#include <array>
+#include <chrono>
 #include <iterator>
+#include <utility>
 #include <vector>
 
 using namespace aka;
@@ -39,6 +45,22 @@ static void writeAnimations(ConversionHelper& state);
 static void writeTextures(ConversionHelper& state);
 static void writeSounds(ConversionHelper& state);
 
+static akmet::Counter& writeFailureMetric = akmet::counter("assets.conversion.writeFailures");
+
+static void publishCreatedMetrics(const ConversionHelper& state) {
+	static const std::array<std::pair<akmet::Counter*, akSize(ConversionHelper::*)() const>, 8> createdMetrics{{
+		{&akmet::counter("assets.conversion.created", {{"type", "Mesh"}}),          &ConversionHelper::meshCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "Material"}}),      &ConversionHelper::materialCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "Image"}}),         &ConversionHelper::imageCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "Animation"}}),     &ConversionHelper::animationCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "ShaderStage"}}),   &ConversionHelper::shaderStageCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "ShaderProgram"}}), &ConversionHelper::shaderProgramCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "Texture"}}),       &ConversionHelper::textureCount},
+		{&akmet::counter("assets.conversion.created", {{"type", "Sound"}}),         &ConversionHelper::soundCount},
+	}};
+	for(const auto& entry : createdMetrics) entry.first->add((state.*entry.second)());
+}
+
 template<auto func_f> static bool convertCopyOnly(const std::string& assetTypeName, ConversionHelper& state, const akfs::Path& cfgPath, akd::PValue& cfg);
 
 static bool convertTexture(ConversionHelper& state, const akfs::Path& cfgPath, akd::PValue& cfg);
@@ -48,14 +70,18 @@ static bool convertShaderStage(ConversionHelper& state, const akfs::Path& cfgPat
 static bool convertSound(ConversionHelper& state, const akfs::Path& cfgPath, akd::PValue& cfg) { return convertCopyOnly<&aka::ConversionHelper::registerSound>("sound", state, cfgPath, cfg); }
 
 static auto writeAssetMetaFile = [](const akfs::Path& dst, const akd::SUID& suid, aka::AssetType assetType, const std::string& name, const akfs::Path& source){
-	akd::PValue dstData; akd::serialize(dstData, aka::AssetInfo{suid, assetType, name, source});
-	return akl::Logger("Convert").test_warn(akd::toJsonFile(dstData, dst), "Failed to write to file: ", dst.str());
+	if (akd::streamToJsonFile(aka::AssetInfo{suid, assetType, name, source}, dst)) return true;
+	writeFailureMetric.add();
+	akl::Logger("Convert").warn("Failed to write to file: ", dst.str());
+	return false;
 };
 
+// Streamed, so large assets like meshes are never held as a PValue tree
 static auto writeAssetFile = [](const akfs::Path& filename, const auto& data, bool asJson) {
-	akd::PValue dstData; akd::serialize(dstData, data);
-	if (asJson) return akl::Logger("Convert").test_warn(akd::toJsonFile(   dstData, filename),       "Failed to write to file: ", filename.str());
-	else        return akl::Logger("Convert").test_warn(akd::toMsgPackFile(dstData, filename, true), "Failed to write to file: ", filename.str());
+	if (asJson ? akd::streamToJsonFile(data, filename) : akd::streamToMsgPackFile(data, filename, true)) return true;
+	writeFailureMetric.add();
+	akl::Logger("Convert").warn("Failed to write to file: ", filename.str());
+	return false;
 };
 
 using callback_t = bool(ConversionHelper&, const akfs::Path&, akd::PValue&);
@@ -69,20 +95,29 @@ static const std::map<std::string, callback_t*> proccessFunctions{{
 }};
 
 void aka::convertDirectory(const akfs::Path& dir) {
+	AK_PROFILE_SCOPE("convertDirectory");
+	AK_MEMORY_TAG("Assets");
+	static akmet::Counter& foundMetric       = akmet::counter("assets.conversion.found");
+	static akmet::Counter& convertedMetric   = akmet::counter("assets.conversion.converted");
+	static akmet::Counter& unsupportedMetric = akmet::counter("assets.conversion.unsupported");
+	static akmet::Histogram& assetTimeMetric = akmet::histogram("assets.conversion.assetNS");
 
 	akc::Timer convertTimer;
 
 	akSize fileCount = 0;
 
+	// Only the type is needed to group the files, so they're read into a reused read-only document
 	std::map<aka::AssetSourceType, std::vector<akfs::Path>> collectedAssets;
+	akd::Document convDoc;
 	akfs::iterateDirectory(dir, [&](const akfs::Path& path, bool isDir){
 		if ((isDir) || (path.extension() != ".akconv")) return true;
-		akd::PValue convData = akd::fromJsonFile(path);
-		collectedAssets[akd::deserialize<aka::AssetSourceType>(convData["type"])].push_back(path);
+		if (!akd::fromJsonFile(convDoc, path)) { akl::Logger("Convert").warn("Could not read conversion file, skipping: ", path.str()); return true; }
+		collectedAssets[akd::deserialize<aka::AssetSourceType>(convDoc.root()["type"])].push_back(path);
 		fileCount     += 1;
 		return true;
 	}, true);
 
+	foundMetric.add(fileCount);
 	akl::Logger("Convert").info("Found ", fileCount, " asset conversion definition files in ", convertTimer.markAndReset().msecs() , "ms.");
 
 	akSize proccessCount = 0;
@@ -98,20 +133,23 @@ void aka::convertDirectory(const akfs::Path& dir) {
 
 	for(auto assetTypeIter = collectedAssets.begin(); assetTypeIter != collectedAssets.end(); assetTypeIter++) {
 		for(auto assetPathIter = assetTypeIter->second.begin(); assetPathIter != assetTypeIter->second.end(); assetPathIter++) {
+			AK_PROFILE_SCOPE("convertDirectory::asset");
+			auto assetStart = std::chrono::steady_clock::now();
 			ConversionHelper convertHelper(akfs::Path("data/"), true);
 
 			akd::PValue convData = akd::fromJsonFile(*assetPathIter);
 			auto iter = proccessFunctions.find(convData["type"].getStr());
-			if (iter == proccessFunctions.end()) { akl::Logger("Convert").warn("Could not proccess type '",  convData["type"].getStr(), "' in file: ", (*assetPathIter).str()); continue; }
+			if (iter == proccessFunctions.end()) { unsupportedMetric.add(); akl::Logger("Convert").warn("Could not proccess type '",  convData["type"].getStr(), "' in file: ", (*assetPathIter).str()); continue; }
 
 			const auto convDataTmp = convData;
-			if (iter->second(convertHelper, *assetPathIter, convData)) proccessCount++;
+			if (iter->second(convertHelper, *assetPathIter, convData)) { proccessCount++; convertedMetric.add(); }
 
 			if (convDataTmp != convData) {
 				if (!akd::toJsonFile(convData, *assetPathIter)) akl::Logger("Convert").warn("Could not save modified conversion file at '", assetPathIter->str(), "'. SUIDs may not persist between conversions!");
 				modifiedCount++;
 			}
 
+			AK_PROFILE_SCOPE("convertDirectory::write");
 			writeMeshes(convertHelper);
 			writeMaterials(convertHelper);
 			writeImages(convertHelper);
@@ -129,6 +167,9 @@ void aka::convertDirectory(const akfs::Path& dir) {
 			shaderProgramCount += convertHelper.shaderProgramCount();
 			textureCount  += convertHelper.textureCount();
 			soundCount  += convertHelper.soundCount();
+
+			publishCreatedMetrics(convertHelper);
+			assetTimeMetric.record(std::chrono::steady_clock::now() - assetStart);
 		}
 	}
 
@@ -35,6 +35,8 @@
 #include <akengine/data/Random.hpp>
 #include <akengine/data/Serialize.hpp>
 #include <akengine/data/SUID.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
 #include <akengine/filesystem/CFile.hpp>
 #include <akengine/filesystem/Filesystem.hpp>
 #include <akengine/filesystem/Path.hpp>
@@ -53,10 +55,10 @@ static Asset loadAsset(const akfs::Path& filename);
 static void resolveBuffers(const akfs::Path& root, Asset& asset);
 
 static aka::ConversionInfo getAssetInfo(akd::PValue& cfg, const aka::ConversionHelper& convertHelper, const std::string& categoryName, const std::string& entryName, const std::string& defaultPath, const std::optional<akfs::Path>& source = {}) {
+	// Read the default before holding the entry, inserting into the category can move its members
+	auto defPathStr = (akfs::Path(cfg[categoryName].atOrSet("").getStrOrDef("data/"))/defaultPath).str(); // This isn't right
 	auto& entry = cfg[categoryName].atOrSet(entryName);
-	auto& defEntry = cfg[categoryName].atOrSet("");
 
-	auto defPathStr = (akfs::Path(defEntry.getStrOrDef("data/"))/defaultPath).str(); // This isn't right
 	auto info = convertHelper.findConversionInfo(
 		entryName,
 		akd::tryDeserialize<akd::SUID>(entry.atOrDef("identifier")),
@@ -72,6 +74,8 @@ static aka::ConversionInfo getAssetInfo(akd::PValue& cfg, const aka::ConversionH
 }
 
 bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs::Path& cfgPath, akd::PValue& cfg) {
+	AK_PROFILE_SCOPE("GLTF::convert");
+	AK_MEMORY_TAG("GLTF");
 	akd::CMW4096Engine32d randomGenerator(akd::CMW4096Engine32d::default_seed ^ std::rand() ^ std::time(nullptr));
 	akc::Timer proccessTimer, stepTimer;
 
@@ -95,7 +99,10 @@ bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs
 	// ///////////////////// //
 	// // Resolve Buffers // //
 	// ///////////////////// //
-	resolveBuffers(root, asset);
+	/* Resolve */ {
+		AK_PROFILE_SCOPE("GLTF::resolveBuffers");
+		resolveBuffers(root, asset);
+	}
 
 	// ///////////////////////// //
 	// // Processing Textures // //
@@ -127,6 +134,7 @@ bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs
 
 		if ((skipExisting) && (akfs::exists(info.destination) && akfs::exists(akfs::Path(info.destination).clearExtension()))) continue;
 
+		AK_PROFILE_SCOPE("GLTF::material");
 		convertHelper.registerMaterial(
 			info,
 			proccessGLTFMaterial(asset, material, images),
@@ -158,6 +166,7 @@ bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs
 
 			if ((skipExisting) && (akfs::exists(info.destination)) && akfs::exists(akfs::Path(info.destination).clearExtension())) continue;
 
+			AK_PROFILE_SCOPE("GLTF::mesh");
 			convertHelper.registerMesh(
 				info,
 				processGLTFMesh(asset, mesh, materials),
@@ -179,6 +188,7 @@ bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs
 		auto info = getAssetInfo(cfg, convertHelper, "animations", animation.name, animation.name + ".akanim.akres");
 		if ((skipExisting) && (akfs::exists(info.destination)) && akfs::exists(akfs::Path(info.destination).clearExtension())) continue;
 
+		AK_PROFILE_SCOPE("GLTF::animation");
 		convertHelper.registerAnimation(
 			info,
 			gltf::proccessGLTFAnimation(asset, animation),
@@ -193,6 +203,7 @@ bool aka::gltf::convertGLTFFile(aka::ConversionHelper& convertHelper, const akfs
 }
 
 static Asset loadAsset(const akfs::Path& filename) {
+	AK_PROFILE_SCOPE("GLTF::load");
 	akfs::CFile modelFile(filename, akfs::OpenFlags::In);
 	std::string contents; modelFile.readAllLines(contents);
 	akd::PValue assetData; akd::fromJson(assetData, contents);
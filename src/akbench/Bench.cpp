@@ -0,0 +1,205 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <numeric>
+#include <utility>
+
+using namespace akbench;
+
+static constexpr uint64 MAX_ITERATIONS = 1000000000;
+
+namespace {
+	struct Benchmark final {
+		std::string name;
+		std::function<benchmark_f> func;
+	};
+}
+
+static std::vector<Benchmark>& benchmarks() {
+	static std::vector<Benchmark> instance;
+	return instance;
+}
+
+BenchmarkID akbench::add(const std::string& name, const std::function<benchmark_f>& func) {
+	benchmarks().push_back(Benchmark{name, func});
+	return static_cast<BenchmarkID>(benchmarks().size() - 1);
+}
+
+std::vector<std::string> akbench::names() {
+	std::vector<std::string> result;
+	for(const auto& entry : benchmarks()) result.push_back(entry.name);
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// ///////////// //
+// // Running // //
+// ///////////// //
+
+static int64 runOnce(const Benchmark& benchmark, uint64 iterations, uint64& items, uint64& bytes) {
+	State state(iterations);
+	state.resume();
+	benchmark.func(state);
+	state.pause();
+	items = state.itemsPerIteration();
+	bytes = state.bytesPerIteration();
+	return std::max<int64>(state.elapsedNS(), 1);
+}
+
+/// Grows the iteration count until one call fills minTimeNS, so timer resolution and call overhead are amortized
+static uint64 calibrate(const Benchmark& benchmark, int64 minTimeNS) {
+	uint64 iterations = 1, items, bytes;
+	while(iterations < MAX_ITERATIONS) {
+		auto elapsed = runOnce(benchmark, iterations, items, bytes);
+		if (elapsed >= minTimeNS) break;
+		auto scale = std::clamp(1.4*static_cast<fpDouble>(minTimeNS)/static_cast<fpDouble>(elapsed), 2.0, 10.0);
+		iterations = std::min(MAX_ITERATIONS, static_cast<uint64>(static_cast<fpDouble>(iterations)*scale));
+	}
+	return iterations;
+}
+
+static Statistics computeStatistics(std::vector<fpDouble> samples) {
+	Statistics result;
+	if (samples.empty()) return result;
+
+	std::sort(samples.begin(), samples.end());
+	auto count = static_cast<fpDouble>(samples.size());
+	auto mid = samples.size()/2;
+
+	result.min = samples.front();
+	result.max = samples.back();
+	result.median = (samples.size() % 2 == 0) ? (samples[mid - 1] + samples[mid])/2 : samples[mid];
+	result.mean = std::accumulate(samples.begin(), samples.end(), 0.0)/count;
+
+	fpDouble variance = 0;
+	for(auto sample : samples) variance += (sample - result.mean)*(sample - result.mean);
+	result.stddev = samples.size() > 1 ? std::sqrt(variance/(count - 1)) : 0;
+
+	return result;
+}
+
+static std::string formatRate(fpDouble value, const char* unit) {
+	static constexpr const char* PREFIXES[] = {"", "k", "M", "G", "T"};
+	akSize prefix = 0;
+	while((value >= 1000) && (prefix < 4)) { value /= 1000; prefix++; }
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), "%.2f %s%s/s", value, PREFIXES[prefix], unit);
+	return buffer;
+}
+
+std::vector<Result> akbench::run(const Options& options) {
+	std::vector<const Benchmark*> selected;
+	for(const auto& entry : benchmarks()) if (entry.name.find(options.filter) != std::string::npos) selected.push_back(&entry);
+	std::sort(selected.begin(), selected.end(), [](const Benchmark* lhs, const Benchmark* rhs){ return lhs->name < rhs->name; });
+
+	std::printf("%-40s %14s %12s %12s %10s %s\n", "Benchmark", "Iterations", "Median ns", "Mean ns", "Stddev %", "Throughput");
+
+	std::vector<Result> results;
+	auto minTimeNS = static_cast<int64>(options.minTimeMS)*1000000;
+	for(const auto* benchmark : selected) {
+		auto iterations = calibrate(*benchmark, minTimeNS);
+
+		uint64 items = 1, bytes = 0;
+		for(akSize i = 0; i < options.warmups; i++) runOnce(*benchmark, iterations, items, bytes);
+
+		std::vector<fpDouble> samples;
+		for(akSize i = 0; i < std::max<akSize>(options.repetitions, 1); i++) {
+			auto elapsed = runOnce(*benchmark, iterations, items, bytes);
+			samples.push_back(static_cast<fpDouble>(elapsed)/static_cast<fpDouble>(iterations));
+		}
+
+		Result result;
+		result.name = benchmark->name;
+		result.iterations = iterations;
+		result.repetitions = static_cast<akSize>(samples.size());
+		result.nsPerIteration = computeStatistics(samples);
+		result.itemsPerSecond = 1e9*static_cast<fpDouble>(items)/result.nsPerIteration.median;
+		result.bytesPerSecond = 1e9*static_cast<fpDouble>(bytes)/result.nsPerIteration.median;
+
+		auto throughput = (bytes > 0) ? formatRate(result.bytesPerSecond, "B") : formatRate(result.itemsPerSecond, "items");
+		auto relStddev = result.nsPerIteration.mean > 0 ? 100*result.nsPerIteration.stddev/result.nsPerIteration.mean : 0;
+		std::printf("%-40s %14llu %12.2f %12.2f %10.2f %s\n",
+			result.name.c_str(), static_cast<unsigned long long>(iterations), result.nsPerIteration.median, result.nsPerIteration.mean, relStddev, throughput.c_str());
+		std::fflush(stdout);
+
+		results.push_back(std::move(result));
+	}
+
+	return results;
+}
+
+// /////////////// //
+// // Reporting // //
+// /////////////// //
+
+akd::PValue akbench::toPValue(const std::vector<Result>& results, const Options& options) {
+	akd::PValue result;
+	result["time"].setSInt(static_cast<int64>(std::time(nullptr)));
+	result["options"]["filter"].setStr(options.filter);
+	result["options"]["warmups"].setUInt(options.warmups);
+	result["options"]["repetitions"].setUInt(options.repetitions);
+	result["options"]["minTimeMS"].setUInt(options.minTimeMS);
+
+	auto& entries = result["benchmarks"].setArr().getArr();
+	for(const auto& entry : results) {
+		akd::PValue value;
+		value["name"].setStr(entry.name);
+		value["iterations"].setUInt(entry.iterations);
+		value["repetitions"].setUInt(entry.repetitions);
+		value["nsPerIteration"]["mean"].setDec(entry.nsPerIteration.mean);
+		value["nsPerIteration"]["median"].setDec(entry.nsPerIteration.median);
+		value["nsPerIteration"]["stddev"].setDec(entry.nsPerIteration.stddev);
+		value["nsPerIteration"]["min"].setDec(entry.nsPerIteration.min);
+		value["nsPerIteration"]["max"].setDec(entry.nsPerIteration.max);
+		value["itemsPerSecond"].setDec(entry.itemsPerSecond);
+		value["bytesPerSecond"].setDec(entry.bytesPerSecond);
+		entries.push_back(std::move(value));
+	}
+
+	return result;
+}
+
+akSize akbench::compare(const std::vector<Result>& results, const akd::PValue& baseline, const Options& options) {
+	std::printf("\n%-40s %12s %12s %10s\n", "Benchmark", "Base ns", "Current ns", "Change %");
+
+	static const akd::PValue noEntries;
+	const auto& baseEntries = baseline.atOrDef("benchmarks", noEntries);
+
+	akSize regressions = 0;
+	for(const auto& entry : results) {
+		const akd::PValue* base = nullptr;
+		for(akSize i = 0; baseEntries.exists(i); i++) {
+			if (baseEntries[i].atOrDef("name").asOrDef<std::string>("") == entry.name) { base = &baseEntries[i]; break; }
+		}
+
+		if (!base) { std::printf("%-40s %12s %12.2f %10s\n", entry.name.c_str(), "-", entry.nsPerIteration.median, "new"); continue; }
+
+		auto baseNS = base->atOrDef("nsPerIteration").atOrDef("median").asOrDef<fpDouble>(0);
+		auto change = baseNS > 0 ? 100*(entry.nsPerIteration.median - baseNS)/baseNS : 0;
+		bool regressed = change > options.threshold;
+		if (regressed) regressions++;
+
+		std::printf("%-40s %12.2f %12.2f %+10.2f%s\n", entry.name.c_str(), baseNS, entry.nsPerIteration.median, change, regressed ? "  REGRESSION" : "");
+	}
+
+	std::printf("\n%u of %u benchmarks regressed by more than %.1f%%.\n", regressions, static_cast<akSize>(results.size()), options.threshold);
+	return regressions;
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#ifndef AK_BENCH_BENCH_HPP_
+#define AK_BENCH_BENCH_HPP_
+
+#include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/data/PValue.hpp>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace akbench {
+
+	/**
+	 * Passed to a benchmark body, which performs iterations() operations each time it is called.
+	 * The body is timed as a whole, use pause() and resume() around per-call setup that shouldn't be measured.
+	 */
+	class State final {
+		State(const State&) = delete;
+		State& operator=(const State&) = delete;
+		private:
+			using clock_t = std::chrono::steady_clock;
+
+			uint64 m_iterations;
+			uint64 m_itemsPerIteration;
+			uint64 m_bytesPerIteration;
+
+			clock_t::time_point m_start;
+			clock_t::duration m_elapsed;
+			bool m_running;
+
+		public:
+			explicit State(uint64 iterations) : m_iterations(iterations), m_itemsPerIteration(1), m_bytesPerIteration(0), m_start(), m_elapsed(0), m_running(false) {}
+
+			uint64 iterations() const { return m_iterations; }
+
+			void resume() {
+				if (m_running) return;
+				m_running = true;
+				m_start = clock_t::now();
+			}
+
+			void pause() {
+				if (!m_running) return;
+				m_elapsed += clock_t::now() - m_start;
+				m_running = false;
+			}
+
+			/// Items handled by one iteration, e.g. samples mixed, for the items per second column
+			void setItemsPerIteration(uint64 items) { m_itemsPerIteration = items; }
+
+			/// Bytes handled by one iteration, for the throughput column
+			void setBytesPerIteration(uint64 bytes) { m_bytesPerIteration = bytes; }
+
+			uint64 itemsPerIteration() const { return m_itemsPerIteration; }
+			uint64 bytesPerIteration() const { return m_bytesPerIteration; }
+			int64 elapsedNS() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(m_elapsed).count(); }
+	};
+
+	using BenchmarkID = akSize;
+	using benchmark_f = void(State&);
+
+	/**
+	 * Registers a benchmark, call from a static initializer:
+	 *   static akbench::BenchmarkID slotMapSInitInsert = akbench::add("SlotMap/insert", [](akbench::State& state){ ... });
+	 * @param name "Subsystem/operation", results are sorted by name
+	 */
+	BenchmarkID add(const std::string& name, const std::function<benchmark_f>& func);
+
+	/// Keeps the compiler from discarding a value that is otherwise unused
+	template<typename type_t> inline void doNotOptimize(const type_t& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	/// Forces pending writes to memory to be treated as observable
+	inline void clobberMemory() {
+		asm volatile("" : : : "memory");
+	}
+
+	struct Options {
+		std::string filter;       /// Only run benchmarks whose name contains this
+		akSize warmups = 1;       /// Untimed calls at the final iteration count
+		akSize repetitions = 10;  /// Timed calls, each is one sample for the statistics
+		uint64 minTimeMS = 20;    /// The iteration count is raised until a single call takes at least this long
+		std::string jsonPath;     /// VFS path (data/...) to write results to, empty for none
+		std::string baselinePath; /// Results from an earlier run to compare against, empty for none
+		fpDouble threshold = 10;  /// Percentage slower than the baseline's median that counts as a regression
+		bool list = false;
+	};
+
+	struct Statistics {
+		fpDouble mean = 0;
+		fpDouble median = 0;
+		fpDouble stddev = 0;
+		fpDouble min = 0;
+		fpDouble max = 0;
+	};
+
+	struct Result {
+		std::string name;
+		uint64 iterations;
+		akSize repetitions;
+		Statistics nsPerIteration;
+		fpDouble itemsPerSecond; /// From the median
+		fpDouble bytesPerSecond; /// From the median, 0 if the benchmark doesn't set a byte count
+	};
+
+	std::vector<std::string> names();
+
+	/**
+	 * Runs every registered benchmark matching the filter, printing a line per benchmark as it completes.
+	 */
+	std::vector<Result> run(const Options& options);
+
+	akd::PValue toPValue(const std::vector<Result>& results, const Options& options);
+
+	/**
+	 * Prints the change of each benchmark's median against a baseline written by toPValue.
+	 * @return The number of benchmarks that regressed by more than options.threshold percent
+	 */
+	akSize compare(const std::vector<Result>& results, const akd::PValue& baseline, const Options& options);
+}
+
+#endif
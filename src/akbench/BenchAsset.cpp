@@ -0,0 +1,83 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <akasset/gltf/Accessor.hpp>
+#include <akasset/gltf/Asset.hpp>
+#include <akasset/gltf/Buffer.hpp>
+#include <akasset/gltf/BufferView.hpp>
+#include <akasset/gltf/Util.hpp>
+#include <akcommon/Memory.hpp>
+#include <akmath/Vector.hpp>
+#include <vector>
+
+static constexpr akSize VERTEX_COUNT = 65536;
+
+/// A single interleaved position/normal/uv buffer, as exported for most meshes
+static aka::gltf::Asset buildMeshAsset() {
+	static constexpr int32 STRIDE = (3 + 3 + 2)*sizeof(fpSingle);
+
+	std::vector<fpSingle> vertices;
+	for(akSize i = 0; i < VERTEX_COUNT; i++) {
+		auto value = static_cast<fpSingle>(i);
+		vertices.insert(vertices.end(), {value, value + 1, value + 2, 0, 1, 0, value/VERTEX_COUNT, 1 - value/VERTEX_COUNT});
+	}
+
+	std::vector<uint8> data(vertices.size()*sizeof(fpSingle));
+	akc::memcpy(data.data(), reinterpret_cast<const uint8*>(vertices.data()), static_cast<akSize>(data.size()));
+
+	aka::gltf::Asset result{};
+	result.buffers.push_back(aka::gltf::Buffer{"vertices", "", data, static_cast<int32>(data.size())});
+	result.bufferViews.push_back(aka::gltf::BufferView{"vertexView", 0, 0, static_cast<int32>(data.size()), STRIDE, aka::gltf::BufferTarget::Array});
+	result.accessors.push_back(aka::gltf::Accessor{"position", 0,  0, aka::gltf::ComponnentType::Float, false, static_cast<int32>(VERTEX_COUNT), aka::gltf::AccessorType::Vec3, {}, {}});
+	result.accessors.push_back(aka::gltf::Accessor{"normal",   0, 12, aka::gltf::ComponnentType::Float, false, static_cast<int32>(VERTEX_COUNT), aka::gltf::AccessorType::Vec3, {}, {}});
+	result.accessors.push_back(aka::gltf::Accessor{"texCoord", 0, 24, aka::gltf::ComponnentType::Float, false, static_cast<int32>(VERTEX_COUNT), aka::gltf::AccessorType::Vec2, {}, {}});
+	return result;
+}
+
+// ////////// //
+// // GLTF // //
+// ////////// //
+
+static akbench::BenchmarkID gltfSInitExtractVec3 = akbench::add("GLTF/extractAccessorVec3", [](akbench::State& state){
+	state.pause();
+	auto asset = buildMeshAsset();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto positions = aka::gltf::extractAccessorData<akm::Vec3>(asset, 0);
+		akbench::doNotOptimize(positions.data());
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(VERTEX_COUNT);
+	state.setBytesPerIteration(VERTEX_COUNT*3*sizeof(fpSingle));
+});
+
+static akbench::BenchmarkID gltfSInitExtractVec2 = akbench::add("GLTF/extractAccessorVec2", [](akbench::State& state){
+	state.pause();
+	auto asset = buildMeshAsset();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto texCoords = aka::gltf::extractAccessorData<akm::Vec2>(asset, 2);
+		akbench::doNotOptimize(texCoords.data());
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(VERTEX_COUNT);
+	state.setBytesPerIteration(VERTEX_COUNT*2*sizeof(fpSingle));
+});
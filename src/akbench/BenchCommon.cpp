@@ -0,0 +1,151 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <akcommon/ObjectPool.hpp>
+#include <akcommon/SlotMap.hpp>
+#include <akcommon/SparseGrid.hpp>
+#include <akengine/data/Random.hpp>
+#include <akmath/Vector.hpp>
+#include <utility>
+#include <vector>
+
+static constexpr akSize CONTAINER_SIZE = 10000;
+
+// ///////////// //
+// // SlotMap // //
+// ///////////// //
+
+static akbench::BenchmarkID slotMapSInitInsertErase = akbench::add("SlotMap/insertErase", [](akbench::State& state){
+	akc::SlotMap<uint64> slotMap;
+	slotMap.reserve(CONTAINER_SIZE);
+	std::vector<akc::SlotID> ids(CONTAINER_SIZE);
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) ids[j] = slotMap.insert(j);
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) slotMap.erase(ids[j]);
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(CONTAINER_SIZE);
+});
+
+static akbench::BenchmarkID slotMapSInitLookup = akbench::add("SlotMap/lookup", [](akbench::State& state){
+	state.pause();
+	akc::SlotMap<uint64> slotMap;
+	std::vector<akc::SlotID> ids;
+	for(akSize j = 0; j < CONTAINER_SIZE; j++) ids.push_back(slotMap.insert(j));
+	akd::CMW4096Engine32 random;
+	for(akSize j = CONTAINER_SIZE - 1; j > 0; j--) std::swap(ids[j], ids[random.nextInt() % (j + 1)]);
+	state.resume();
+
+	uint64 sum = 0;
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(const auto& id : ids) sum += slotMap.at(id);
+		akbench::doNotOptimize(sum);
+	}
+
+	state.setItemsPerIteration(CONTAINER_SIZE);
+});
+
+// //////////////// //
+// // ObjectPool // //
+// //////////////// //
+
+static akbench::BenchmarkID objectPoolSInitInsertErase = akbench::add("ObjectPool/insertErase", [](akbench::State& state){
+	akc::ObjectPool<uint64> pool;
+	pool.reserve(CONTAINER_SIZE);
+	std::vector<akSize> ids(CONTAINER_SIZE);
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) ids[j] = pool.insert(j);
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) pool.erase(ids[j]);
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(CONTAINER_SIZE);
+});
+
+// //////////////// //
+// // SparseGrid // //
+// //////////////// //
+
+static constexpr fpSingle GRID_CELL_SIZE = 4;
+static constexpr fpSingle GRID_EXTENT = 256*GRID_CELL_SIZE;
+
+static std::vector<akm::Vec3> gridPositions(akSize count, uint32 seed) {
+	akd::CMW4096Engine32 random(seed);
+	auto next = [&]{ return 1 + static_cast<fpSingle>(random.nextInt() % 65536)*(GRID_EXTENT - 2)/65536; };
+	std::vector<akm::Vec3> result;
+	for(akSize i = 0; i < count; i++) result.push_back({next(), next(), next()});
+	return result;
+}
+
+static akbench::BenchmarkID sparseGridSInitInsertRemove = akbench::add("SparseGrid/insertRemove", [](akbench::State& state){
+	state.pause();
+	auto positions = gridPositions(CONTAINER_SIZE, 1);
+	std::vector<akc::SlotID> ids(CONTAINER_SIZE);
+	akc::sparsegrid::SparseGrid<uint32> grid({0, 0, 0}, {GRID_CELL_SIZE, GRID_CELL_SIZE, GRID_CELL_SIZE});
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) ids[j] = grid.insert(static_cast<uint32>(j), positions[j], {0.5f, 0.5f, 0.5f});
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) grid.remove(ids[j]);
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(CONTAINER_SIZE);
+});
+
+static akbench::BenchmarkID sparseGridSInitMove = akbench::add("SparseGrid/move", [](akbench::State& state){
+	state.pause();
+	auto positions = gridPositions(CONTAINER_SIZE, 2);
+	auto targets = gridPositions(CONTAINER_SIZE, 3);
+	std::vector<akc::SlotID> ids(CONTAINER_SIZE);
+	akc::sparsegrid::SparseGrid<uint32> grid({0, 0, 0}, {GRID_CELL_SIZE, GRID_CELL_SIZE, GRID_CELL_SIZE});
+	for(akSize j = 0; j < CONTAINER_SIZE; j++) ids[j] = grid.insert(static_cast<uint32>(j), positions[j], {0.5f, 0.5f, 0.5f});
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		const auto& dest = (i % 2 == 0) ? targets : positions;
+		for(akSize j = 0; j < CONTAINER_SIZE; j++) grid.move(ids[j], dest[j], {0.5f, 0.5f, 0.5f});
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(CONTAINER_SIZE);
+});
+
+static akbench::BenchmarkID sparseGridSInitCastLine = akbench::add("SparseGrid/castLine", [](akbench::State& state){
+	static constexpr akSize LINE_COUNT = 256;
+
+	state.pause();
+	auto positions = gridPositions(CONTAINER_SIZE, 4);
+	auto lineStarts = gridPositions(LINE_COUNT, 5);
+	auto lineEnds = gridPositions(LINE_COUNT, 6);
+	akc::sparsegrid::SparseGrid<uint32> grid({0, 0, 0}, {GRID_CELL_SIZE, GRID_CELL_SIZE, GRID_CELL_SIZE});
+	for(akSize j = 0; j < CONTAINER_SIZE; j++) grid.insert(static_cast<uint32>(j), positions[j], {0.5f, 0.5f, 0.5f});
+	state.resume();
+
+	akSize visited = 0;
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < LINE_COUNT; j++) {
+			grid.castLine(lineStarts[j], lineEnds[j], [&](const akm::Vec3&, const akm::Vec3&, const akm::Vec3&){ visited++; return true; });
+		}
+		akbench::doNotOptimize(visited);
+	}
+
+	state.setItemsPerIteration(LINE_COUNT);
+});
@@ -0,0 +1,279 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <akcommon/String.hpp>
+#include <akengine/data/Base64.hpp>
+#include <akengine/data/Brotli.hpp>
+#include <akengine/data/Document.hpp>
+#include <akengine/data/Hash.hpp>
+#include <akengine/data/Json.hpp>
+#include <akengine/data/MsgPack.hpp>
+#include <akengine/data/PValue.hpp>
+#include <akengine/data/Random.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// A config/asset-meta shaped tree: nested objects, short strings, numbers and small arrays
+static akd::PValue buildDocument(akSize entryCount) {
+	akd::CMW4096Engine32 random;
+	akd::PValue result;
+	for(akSize i = 0; i < entryCount; i++) {
+		auto& entry = result["entries"][i];
+		entry["name"].setStr(akc::buildString("entry_", i));
+		entry["id"].setUInt(random.nextInt());
+		entry["enabled"].setBool(i % 3 != 0);
+		entry["scale"].setDec(static_cast<fpDouble>(random.nextInt() % 10000)/100.0);
+		auto& position = entry["position"];
+		for(akSize j = 0; j < 3; j++) position[j].setDec(static_cast<fpDouble>(random.nextInt() % 100000)/1000.0);
+		entry["tags"][0].setStr("static");
+		entry["tags"][1].setStr(akc::buildString("group", i % 8));
+	}
+	return result;
+}
+
+static std::vector<uint8> buildBytes(akSize size) {
+	// Repetitive enough to compress, like asset data, rather than uniform noise
+	akd::CMW4096Engine32 random;
+	std::vector<uint8> result(size);
+	for(akSize i = 0; i < size; i++) result[i] = static_cast<uint8>((i % 64 < 48) ? (i % 16) : (random.nextInt() & 0xFF));
+	return result;
+}
+
+// //////////// //
+// // PValue // //
+// //////////// //
+
+static akbench::BenchmarkID pvalueSInitBuild = akbench::add("PValue/build", [](akbench::State& state){
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto document = buildDocument(100);
+		akbench::doNotOptimize(document);
+	}
+	state.setItemsPerIteration(100);
+});
+
+static akbench::BenchmarkID pvalueSInitCopy = akbench::add("PValue/copy", [](akbench::State& state){
+	state.pause();
+	auto document = buildDocument(100);
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		akd::PValue copy = document;
+		akbench::doNotOptimize(copy);
+	}
+	state.setItemsPerIteration(100);
+});
+
+// ////////// //
+// // JSON // //
+// ////////// //
+
+static akbench::BenchmarkID jsonSInitWrite = akbench::add("Json/write", [](akbench::State& state){
+	state.pause();
+	auto document = buildDocument(100);
+	auto size = akd::toJson(document, false).size();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto json = akd::toJson(document, false);
+		akbench::doNotOptimize(json);
+	}
+	state.setBytesPerIteration(size);
+});
+
+static akbench::BenchmarkID jsonSInitRoundTrip = akbench::add("Json/roundTrip", [](akbench::State& state){
+	state.pause();
+	auto document = buildDocument(100);
+	auto size = akd::toJson(document, false).size();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		akd::PValue result;
+		if (!akd::fromJson(result, akd::toJson(document, false))) throw std::runtime_error("Json/roundTrip: Failed to parse output");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(size);
+});
+
+static akbench::BenchmarkID jsonSInitParse = akbench::add("Json/parse", [](akbench::State& state){
+	state.pause();
+	auto json = akd::toJson(buildDocument(100), false);
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		akd::PValue result;
+		if (!akd::fromJson(result, json)) throw std::runtime_error("Json/parse: Failed to parse input");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(json.size());
+});
+
+static akbench::BenchmarkID jsonSInitParseDocument = akbench::add("Json/parseDocument", [](akbench::State& state){
+	state.pause();
+	auto json = akd::toJson(buildDocument(100), false);
+	akd::Document result;
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		if (!akd::fromJson(result, json)) throw std::runtime_error("Json/parseDocument: Failed to parse input");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(json.size());
+});
+
+// ///////////// //
+// // MsgPack // //
+// ///////////// //
+
+static akbench::BenchmarkID msgPackSInitWrite = akbench::add("MsgPack/write", [](akbench::State& state){
+	state.pause();
+	auto document = buildDocument(100);
+	auto size = akd::toMsgPack(document).size();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto data = akd::toMsgPack(document);
+		akbench::doNotOptimize(data);
+	}
+	state.setBytesPerIteration(size);
+});
+
+static akbench::BenchmarkID msgPackSInitRoundTrip = akbench::add("MsgPack/roundTrip", [](akbench::State& state){
+	state.pause();
+	auto document = buildDocument(100);
+	auto size = akd::toMsgPack(document).size();
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		akd::PValue result;
+		if (!akd::fromMsgPack(result, akd::toMsgPack(document))) throw std::runtime_error("MsgPack/roundTrip: Failed to parse output");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(size);
+});
+
+static akbench::BenchmarkID msgPackSInitParse = akbench::add("MsgPack/parse", [](akbench::State& state){
+	state.pause();
+	auto data = akd::toMsgPack(buildDocument(100));
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		akd::PValue result;
+		if (!akd::fromMsgPack(result, data)) throw std::runtime_error("MsgPack/parse: Failed to parse input");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(data.size());
+});
+
+static akbench::BenchmarkID msgPackSInitParseView = akbench::add("MsgPack/parseView", [](akbench::State& state){
+	state.pause();
+	auto data = akd::toMsgPack(buildDocument(100));
+	akd::MsgPackIndex result;
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		if (!result.parse(data)) throw std::runtime_error("MsgPack/parseView: Failed to index input");
+		akbench::doNotOptimize(result);
+	}
+	state.setBytesPerIteration(data.size());
+});
+
+// //////////// //
+// // Brotli // //
+// //////////// //
+
+static constexpr akSize BLOB_SIZE = 256*1024;
+
+static akbench::BenchmarkID brotliSInitCompress = akbench::add("Brotli/compress", [](akbench::State& state){
+	state.pause();
+	auto data = buildBytes(BLOB_SIZE);
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto compressed = akd::compressBrotli(data, 5);
+		akbench::doNotOptimize(compressed);
+	}
+	state.setBytesPerIteration(BLOB_SIZE);
+});
+
+static akbench::BenchmarkID brotliSInitDecompress = akbench::add("Brotli/decompress", [](akbench::State& state){
+	state.pause();
+	auto compressed = akd::compressBrotli(buildBytes(BLOB_SIZE));
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto data = akd::decompressBrotli(compressed);
+		akbench::doNotOptimize(data);
+	}
+	state.setBytesPerIteration(BLOB_SIZE);
+});
+
+// //////////// //
+// // Base64 // //
+// //////////// //
+
+static akbench::BenchmarkID base64SInitEncode = akbench::add("Base64/encode", [](akbench::State& state){
+	state.pause();
+	auto data = buildBytes(BLOB_SIZE);
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto encoded = akd::base64::encode(data.data(), static_cast<akSize>(data.size()));
+		akbench::doNotOptimize(encoded);
+	}
+	state.setBytesPerIteration(BLOB_SIZE);
+});
+
+static akbench::BenchmarkID base64SInitDecode = akbench::add("Base64/decode", [](akbench::State& state){
+	state.pause();
+	auto data = buildBytes(BLOB_SIZE);
+	auto encoded = akd::base64::encode(data.data(), static_cast<akSize>(data.size()));
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto decoded = akd::base64::decode(encoded);
+		akbench::doNotOptimize(decoded);
+	}
+	state.setBytesPerIteration(BLOB_SIZE);
+});
+
+// ////////// //
+// // Hash // //
+// ////////// //
+
+static akbench::BenchmarkID hashSInitFNV64 = akbench::add("Hash/fnv1a64", [](akbench::State& state){
+	state.pause();
+	auto bytes = buildBytes(4096);
+	std::string data(bytes.begin(), bytes.end());
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto hash = akd::hash64FNV1A(data.data(), static_cast<akSize>(data.size()));
+		akbench::doNotOptimize(hash);
+	}
+	state.setBytesPerIteration(data.size());
+});
+
+static akbench::BenchmarkID hashSInitFNV32Name = akbench::add("Hash/fnv1a32Name", [](akbench::State& state){
+	// Component and event names are hashed this way, short keys dominate
+	static const std::string name = "TestComponent1";
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		auto hash = akd::hash32FNV1A(name.data(), static_cast<akSize>(name.size()));
+		akbench::doNotOptimize(hash);
+	}
+	state.setBytesPerIteration(name.size());
+});
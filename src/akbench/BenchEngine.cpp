@@ -0,0 +1,262 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <akcommon/ScopeGuard.hpp>
+#include <akcommon/Span.hpp>
+#include <akengine/data/Hash.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/ecs/Registry.hpp>
+#include <akengine/event/Dispatcher.hpp>
+#include <akengine/event/Event.hpp>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+static constexpr akSize ENTITY_COUNT = 10000;
+
+// ////////////// //
+// // Registry // //
+// ////////////// //
+
+namespace {
+	class BenchComponent1 : public akecs::Component {
+		public:
+			static constexpr std::string_view COMPONENT_NAME = AK_STRING_VIEW("BenchComponent1");
+			static constexpr akecs::ComponentTypeUID COMPONENT_UID = akd::hash32FNV1A<char>(COMPONENT_NAME.data(), COMPONENT_NAME.size());
+
+			uint64 value;
+
+			BenchComponent1(akecs::BaseRegistry&, akecs::EntityRef) : value(0) {}
+	};
+
+	class BenchComponent2 : public akecs::Component {
+		public:
+			static constexpr std::string_view COMPONENT_NAME = AK_STRING_VIEW("BenchComponent2");
+			static constexpr akecs::ComponentTypeUID COMPONENT_UID = akd::hash32FNV1A<char>(COMPONENT_NAME.data(), COMPONENT_NAME.size());
+
+			fpSingle values[4];
+
+			BenchComponent2(akecs::BaseRegistry&, akecs::EntityRef) : values{0, 0, 0, 0} {}
+	};
+
+	using BenchRegistry = akecs::Registry<BenchComponent1, BenchComponent2>;
+}
+
+static akbench::BenchmarkID registrySInitCreateDestroy = akbench::add("Registry/createDestroy", [](akbench::State& state){
+	BenchRegistry registry;
+	registry.reserveEntities(ENTITY_COUNT);
+	std::vector<akecs::EntityRef> entities(ENTITY_COUNT);
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < ENTITY_COUNT; j++) entities[j] = registry.create();
+		for(akSize j = 0; j < ENTITY_COUNT; j++) registry.destroy(entities[j]);
+	}
+
+	state.setItemsPerIteration(ENTITY_COUNT);
+});
+
+static akbench::BenchmarkID registrySInitAttachDetach = akbench::add("Registry/attachDetach", [](akbench::State& state){
+	state.pause();
+	BenchRegistry registry;
+	std::vector<akecs::EntityRef> entities;
+	for(akSize j = 0; j < ENTITY_COUNT; j++) entities.push_back(registry.create());
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(auto& entity : entities) registry.attach<BenchComponent1>(entity);
+		for(auto& entity : entities) registry.detach<BenchComponent1>(entity);
+	}
+
+	state.setItemsPerIteration(ENTITY_COUNT);
+});
+
+static akbench::BenchmarkID registrySInitComponentLookup = akbench::add("Registry/componentLookup", [](akbench::State& state){
+	state.pause();
+	BenchRegistry registry;
+	std::vector<akecs::EntityRef> entities;
+	for(akSize j = 0; j < ENTITY_COUNT; j++) {
+		entities.push_back(registry.create());
+		registry.attach<BenchComponent1>(entities.back());
+		if (j % 2 == 0) registry.attach<BenchComponent2>(entities.back());
+	}
+	state.resume();
+
+	uint64 sum = 0;
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(auto& entity : entities) if (auto* component = registry.component<BenchComponent1>(entity)) sum += ++component->value;
+		akbench::doNotOptimize(sum);
+	}
+
+	state.setItemsPerIteration(ENTITY_COUNT);
+});
+
+// //////////////// //
+// // Dispatcher // //
+// //////////////// //
+
+namespace {
+	struct BenchEventData {
+		uint64 value;
+	};
+
+	AK_DEFINE_EVENT(BenchEvent, BenchEventData, true);
+}
+
+static constexpr akSize SUBSCRIBER_COUNT = 8;
+static constexpr akSize EVENT_BATCH_SIZE = 64;
+
+static akbench::BenchmarkID dispatcherSInitSend = akbench::add("Dispatcher/send", [](akbench::State& state){
+	state.pause();
+	akev::Dispatcher<BenchEvent> dispatcher;
+	uint64 received = 0;
+	for(akSize j = 0; j < SUBSCRIBER_COUNT; j++) dispatcher.subscribe([&](BenchEvent& event){ received += event.data().value; });
+	BenchEvent event(BenchEventData{1});
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) dispatcher.send(event);
+	akbench::doNotOptimize(received);
+
+	state.setItemsPerIteration(SUBSCRIBER_COUNT);
+});
+
+static akbench::BenchmarkID dispatcherSInitMediate = akbench::add("Dispatcher/mediate", [](akbench::State& state){
+	state.pause();
+	akev::Dispatcher<BenchEvent> dispatcher;
+	uint64 received = 0;
+	for(akSize j = 0; j < SUBSCRIBER_COUNT; j++) dispatcher.subscribe([&](BenchEvent& event){ received += event.data().value; });
+	state.resume();
+
+	// Queued then drained by the scheduled send on this thread's update
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < EVENT_BATCH_SIZE; j++) dispatcher.mediate(BenchEventData{j});
+		akt::current().update();
+	}
+	akbench::doNotOptimize(received);
+
+	state.setItemsPerIteration(SUBSCRIBER_COUNT*EVENT_BATCH_SIZE);
+});
+
+/// Runs func(threadIndex) on threadCount threads, the timer only covers the time after they're all started
+template<typename func_t> static void runConcurrently(akbench::State& state, akSize threadCount, const func_t& func) {
+	std::atomic<akSize> ready = 0;
+	std::atomic<bool> start = false;
+	std::vector<std::thread> threads;
+	for(akSize j = 0; j < threadCount; j++) threads.emplace_back([&, j]{
+		ready++;
+		while(!start.load(std::memory_order_acquire)) std::this_thread::yield();
+		func(j);
+	});
+	while(ready.load() != threadCount) std::this_thread::yield();
+
+	state.resume();
+	start.store(true, std::memory_order_release);
+	for(auto& thread : threads) thread.join();
+	state.pause();
+}
+
+static akSize senderThreadCount() {
+	return std::clamp<akSize>(std::thread::hardware_concurrency(), 2, 8);
+}
+
+static akbench::BenchmarkID dispatcherSInitSendContended = akbench::add("Dispatcher/sendContended", [](akbench::State& state){
+	state.pause();
+	akev::Dispatcher<BenchEvent> dispatcher;
+	std::atomic<uint64> received = 0;
+	for(akSize j = 0; j < SUBSCRIBER_COUNT; j++) dispatcher.subscribe([&](BenchEvent& event){ if (event.data().value != 0) received.fetch_add(1, std::memory_order_relaxed); });
+	auto threadCount = senderThreadCount();
+
+	// Subscribers only touch the shared counter for value != 0, so this measures the dispatcher rather than the callback
+	runConcurrently(state, threadCount, [&](akSize /*threadIndex*/){
+		BenchEvent event(BenchEventData{0});
+		for(uint64 i = 0; i < state.iterations(); i++) dispatcher.send(event);
+	});
+	akbench::doNotOptimize(received);
+
+	state.setItemsPerIteration(SUBSCRIBER_COUNT*threadCount);
+});
+
+static akbench::BenchmarkID dispatcherSInitSendWhileSubscribing = akbench::add("Dispatcher/sendWhileSubscribing", [](akbench::State& state){
+	state.pause();
+	akev::Dispatcher<BenchEvent> dispatcher;
+	std::atomic<uint64> received = 0;
+	dispatcher.subscribe([&](BenchEvent& event){ received.fetch_add(event.data().value, std::memory_order_relaxed); });
+	auto threadCount = senderThreadCount();
+	std::atomic<akSize> sendersDone = 0;
+
+	// Half the threads send while the rest churn through subscriptions, the permanent subscriber must see every event
+	runConcurrently(state, threadCount, [&](akSize threadIndex){
+		if (threadIndex%2 == 0) {
+			BenchEvent event(BenchEventData{1});
+			for(uint64 i = 0; i < state.iterations(); i++) dispatcher.send(event);
+			sendersDone++;
+		} else {
+			while(sendersDone.load() < (threadCount + 1)/2) {
+				auto id = dispatcher.subscribe([](BenchEvent&){});
+				dispatcher.unsubscribe(id);
+			}
+		}
+	});
+
+	auto senderCount = (threadCount + 1)/2;
+	if (received.load() != senderCount*state.iterations()) throw std::runtime_error("Dispatcher/sendWhileSubscribing: Events were lost");
+	if (dispatcher.subscriberCount() != 1) throw std::runtime_error("Dispatcher/sendWhileSubscribing: Subscribers were leaked");
+
+	state.setItemsPerIteration(senderCount);
+});
+
+// ///////// //
+// // Log // //
+// ///////// //
+
+static constexpr akSize LOG_BATCH_SIZE = 1024;
+
+/// Times the call site only, console output is filtered out and the queue is processed while paused so the rings never fill
+static void benchLogCalls(akbench::State& state, bool deferred) {
+	constexpr akl::Logger log(AK_STRING_VIEW("Bench"));
+	auto consoleLevel = akl::getConsoleFilterLevel();
+	auto wasDeferred = akl::isDeferredFormatting();
+	akc::ScopeGuard restore([&]{
+		akl::processMessageQueue();
+		akl::setConsoleLevel(consoleLevel);
+		akl::setDeferredFormatting(wasDeferred);
+	});
+
+	state.pause();
+	akl::setConsoleLevel(akl::Level::Fatal);
+	akl::setDeferredFormatting(deferred);
+	state.resume();
+
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		for(akSize j = 0; j < LOG_BATCH_SIZE; j++) log.info("Entity ", j, " moved to ", 1.5f*static_cast<fpSingle>(j), " in frame ", i);
+		state.pause();
+		akl::processMessageQueue();
+		state.resume();
+	}
+
+	state.setItemsPerIteration(LOG_BATCH_SIZE);
+}
+
+static akbench::BenchmarkID logSInitDeferred = akbench::add("Log/deferred", [](akbench::State& state){
+	benchLogCalls(state, true);
+});
+
+static akbench::BenchmarkID logSInitImmediate = akbench::add("Log/immediate", [](akbench::State& state){
+	benchLogCalls(state, false);
+});
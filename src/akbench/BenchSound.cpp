@@ -0,0 +1,54 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <aksound/mixer/MixerBasic.hpp>
+#include <aksound/sampler/SamplerBuffer.hpp>
+#include <vector>
+
+static constexpr akSize SOURCE_COUNT = 16;
+static constexpr akSize SOURCE_LENGTH = 48000;
+static constexpr akSize MIX_FRAME_SIZE = 1024;
+
+// /////////// //
+// // Mixer // //
+// /////////// //
+
+static akbench::BenchmarkID mixerSInitSample = akbench::add("Mixer/sample", [](akbench::State& state){
+	state.pause();
+	std::vector<aks::SamplerBuffer> sources;
+	for(akSize i = 0; i < SOURCE_COUNT; i++) {
+		std::vector<fpSingle> samples(SOURCE_LENGTH + i*100);
+		for(akSize j = 0; j < samples.size(); j++) samples[j] = static_cast<fpSingle>((j*(i + 1)) % 200)/100.f - 1.f;
+		sources.emplace_back(samples.data(), static_cast<akSize>(samples.size()), true);
+	}
+
+	aks::MixerBasic mixer;
+	for(const auto& source : sources) mixer.addSource(source);
+	std::vector<fpSingle> out(MIX_FRAME_SIZE);
+	state.resume();
+
+	akSSize position = 0;
+	for(uint64 i = 0; i < state.iterations(); i++) {
+		mixer.sample(out.data(), position, MIX_FRAME_SIZE);
+		position += MIX_FRAME_SIZE;
+		akbench::doNotOptimize(out.data());
+		akbench::clobberMemory();
+	}
+
+	state.setItemsPerIteration(MIX_FRAME_SIZE);
+	state.setBytesPerIteration(SOURCE_COUNT*MIX_FRAME_SIZE*sizeof(fpSingle));
+});
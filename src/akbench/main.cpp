@@ -0,0 +1,99 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akbench/Bench.hpp>
+#include <akcommon/ScopeGuard.hpp>
+#include <akengine/data/Json.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/thread/CurrentThread.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+static constexpr akl::Logger benchLog(AK_STRING_VIEW("Bench"));
+
+static void printUsage() {
+	std::printf(
+		"Usage: akutenshi_bench [options]\n"
+		"  --list                 List benchmark names and exit\n"
+		"  --filter <text>        Only run benchmarks whose name contains <text>\n"
+		"  --repetitions <n>      Timed runs per benchmark (default 10)\n"
+		"  --warmup <n>           Untimed runs per benchmark (default 1)\n"
+		"  --min-time-ms <n>      Minimum duration of a single run (default 20)\n"
+		"  --json <path>          Write results to a VFS path, e.g. data/bench/results.json\n"
+		"  --baseline <path>      Compare against results from an earlier --json run\n"
+		"  --threshold <percent>  Slowdown counted as a regression (default 10)\n"
+	);
+}
+
+static bool parseArguments(int argc, char* argv[], akbench::Options& options) {
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--list") { options.list = true; continue; }
+		if ((arg == "--help") || (arg == "-h")) return false;
+
+		if (i + 1 >= argc) { std::fprintf(stderr, "Missing value for '%s'.\n", arg.c_str()); return false; }
+		std::string value = argv[++i];
+
+		if      (arg == "--filter")      options.filter = value;
+		else if (arg == "--repetitions") options.repetitions = static_cast<akSize>(std::strtoul(value.c_str(), nullptr, 10));
+		else if (arg == "--warmup")      options.warmups = static_cast<akSize>(std::strtoul(value.c_str(), nullptr, 10));
+		else if (arg == "--min-time-ms") options.minTimeMS = std::strtoull(value.c_str(), nullptr, 10);
+		else if (arg == "--json")        options.jsonPath = value;
+		else if (arg == "--baseline")    options.baselinePath = value;
+		else if (arg == "--threshold")   options.threshold = std::strtod(value.c_str(), nullptr);
+		else { std::fprintf(stderr, "Unknown option '%s'.\n", arg.c_str()); return false; }
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	akbench::Options options;
+	if (!parseArguments(argc, argv, options)) { printUsage(); return 2; }
+
+	if (options.list) {
+		for(const auto& name : akbench::names()) std::printf("%s\n", name.c_str());
+		return 0;
+	}
+
+	akt::current().setName("Main");
+	akl::startProcessing();
+	auto cleanup = akc::ScopeGuard([]{
+		akl::stopProcessing();
+		akl::flush();
+	});
+
+	try {
+		auto results = akbench::run(options);
+
+		if (!options.jsonPath.empty()) {
+			if (!akd::toJsonFile(akbench::toPValue(results, options), options.jsonPath)) benchLog.error("Failed to write results to '", options.jsonPath, "'.");
+			else std::printf("\nWrote results to '%s'.\n", options.jsonPath.c_str());
+		}
+
+		if (!options.baselinePath.empty()) {
+			auto baseline = akd::fromJsonFile(options.baselinePath);
+			if (baseline.isNull()) { benchLog.error("Failed to read baseline '", options.baselinePath, "'."); return 2; }
+			if (akbench::compare(results, baseline, options) > 0) return 1;
+		}
+	} catch(const std::exception& e) {
+		benchLog.error("Benchmark failed: ", e.what());
+		return 2;
+	}
+
+	return 0;
+}
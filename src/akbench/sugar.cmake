@@ -0,0 +1,13 @@
+include_guard(GLOBAL)
+
+# ################ #
+# # Include Dirs # #
+# ################ #
+
+# sugar_include( )
+
+# ################ #
+# # Source Files # #
+# ################ #
+
+sugar_files(AK_BENCH_SOURCE main.cpp Bench.cpp BenchAsset.cpp BenchCommon.cpp BenchData.cpp BenchEngine.cpp BenchSound.cpp)
@@ -21,7 +21,10 @@
 using namespace akc;
 
 Timestamp akc::utcTimestamp() {
-	auto cTime = std::chrono::system_clock::now();
+	return utcTimestamp(std::chrono::system_clock::now());
+}
+
+Timestamp akc::utcTimestamp(const std::chrono::system_clock::time_point& cTime) {
 	auto time = std::chrono::system_clock::to_time_t(cTime);
 	auto utcTime = std::gmtime(&time);
 	return {*utcTime, std::chrono::duration_cast<std::chrono::milliseconds>(cTime.time_since_epoch()).count() % 1000};
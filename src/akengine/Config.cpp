@@ -17,7 +17,9 @@
 #include <akengine/data/Json.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/Config.hpp>
+#include <akengine/debug/Memory.hpp>
 #include <akengine/event/Dispatcher.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akengine/filesystem/CFile.hpp>
 #include <akengine/filesystem/Filesystem.hpp>
 #include <akengine/filesystem/Path.hpp>
@@ -56,6 +58,12 @@ void ake::setConfig(const akd::PValue& nConfig) {
 
 	SetConfigEvent event(nConfig);
 	setConfigDispatcher().send(event);
+
+	// Recorded after dispatch so the config that enables recording is the first record
+	if (akev::isRecording()) {
+		auto json = akd::toJson(nConfig, false);
+		akev::record(SetConfigEvent::EVENT_ID, json.data(), json.size());
+	}
 }
 
 void ake::regenerateConfig() {
@@ -68,6 +76,7 @@ void ake::regenerateConfig() {
 }
 
 ConfigLoadResult ake::loadConfig() {
+	AK_MEMORY_TAG("Config");
 	akfs::CFile configFile(CONFIG_PATH, akfs::In);
 	if (!configFile) return ConfigLoadResult::CannotOpen;
 
@@ -104,6 +113,11 @@ bool ake::saveConfig() {
 	return true;
 }
 
+static bool configSInitReplayHandler = (akev::setReplayHandler(SetConfigEvent::EVENT_ID, [](const uint8* data, akSize size){
+	akd::PValue newConfig;
+	if (akd::fromJson(newConfig, std::string(reinterpret_cast<const char*>(data), size))) setConfig(newConfig);
+}), true);
+
 static bool backupConfig() {
 	return akfs::rename(CONFIG_PATH, BACKUP_PATH, true);
 }
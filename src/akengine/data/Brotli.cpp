@@ -19,7 +19,7 @@
 #include <akengine/data/Brotli.hpp>
 #include <brotli/decode.h>
 #include <brotli/encode.h>
-#include <crtdefs.h>
+#include <cstddef>
 #include <stdexcept>
 #include <vector>
 
@@ -0,0 +1,182 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/data/Document.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace akd;
+
+static constexpr akSize SMALL_OBJECT_SIZE = 32;
+
+// /////////////// //
+// // PValueView // //
+// /////////////// //
+
+PValue PValueView::toPValue() const {
+	PValue result;
+	switch(type()) {
+		case PType::Null: break;
+
+		case PType::Object: {
+			auto& obj = result.setObj().getObj();
+			obj.reserve(size());
+			for(akSize i = 0; i < size(); i++) obj.appendUnsorted(std::string(keyAt(i)), valueAt(i).toPValue());
+			obj.sortAppended();
+		} break;
+
+		case PType::Array: {
+			auto& arr = result.setArr().getArr();
+			arr.reserve(size());
+			for(akSize i = 0; i < size(); i++) arr.push_back(atOrDef(i).toPValue());
+		} break;
+
+		case PType::String:   result.setStr(std::string(getStr())); break;
+		case PType::Signed:   result.setSInt(getSInt()); break;
+		case PType::Unsigned: result.setUInt(getUInt()); break;
+		case PType::Decimal:  result.setDec(getDec()); break;
+		case PType::Boolean:  result.setBool(getBool()); break;
+		case PType::Binary:   result.setBin(getBin().data(), getBin().size()); break;
+	}
+	return result;
+}
+
+// ///////////////////// //
+// // DocumentBuilder // //
+// ///////////////////// //
+
+DocumentBuilder::DocumentBuilder(Document& dest) : m_document(dest), m_pending(), m_frames(), m_key(), m_hasRoot(false) {
+	m_document.clear();
+}
+
+std::string_view DocumentBuilder::copyString(std::string_view val) {
+	// Null terminated so the data can still be handed to C APIs
+	auto dst = m_document.m_arena.allocate<char>(static_cast<akSize>(val.size() + 1));
+	std::memcpy(dst, val.data(), val.size());
+	dst[val.size()] = '\0';
+	return std::string_view(dst, val.size());
+}
+
+void DocumentBuilder::add(const internal::DocNode& node) {
+	if (!m_frames.empty()) {
+		m_pending.push_back(internal::DocMember{m_frames.back().isObject ? m_key : std::string_view(), node});
+		return;
+	}
+
+	if (m_hasRoot) throw std::logic_error("Document already has a root value.");
+	auto root = m_document.m_arena.allocate<internal::DocNode>(1);
+	*root = node;
+	m_document.m_root = root;
+	m_hasRoot = true;
+}
+
+void DocumentBuilder::setKey(std::string_view key) {
+	m_key = copyString(key);
+}
+
+void DocumentBuilder::addNull() {
+	internal::DocNode node{PType::Null, 0, {}};
+	add(node);
+}
+
+void DocumentBuilder::addBool(bool val) {
+	internal::DocNode node{PType::Boolean, 0, {}}; node.value.boolean = val;
+	add(node);
+}
+
+void DocumentBuilder::addSInt(int64 val) {
+	internal::DocNode node{PType::Signed, 0, {}}; node.value.sint = val;
+	add(node);
+}
+
+void DocumentBuilder::addUInt(uint64 val) {
+	internal::DocNode node{PType::Unsigned, 0, {}}; node.value.uint = val;
+	add(node);
+}
+
+void DocumentBuilder::addDec(fpDouble val) {
+	internal::DocNode node{PType::Decimal, 0, {}}; node.value.dec = val;
+	add(node);
+}
+
+void DocumentBuilder::addStr(std::string_view val) {
+	internal::DocNode node{PType::String, static_cast<uint32>(val.size()), {}}; node.value.str = copyString(val).data();
+	add(node);
+}
+
+void DocumentBuilder::addBin(const uint8* data, akSize size) {
+	auto dst = m_document.m_arena.allocate<uint8>(size);
+	std::memcpy(dst, data, size);
+	internal::DocNode node{PType::Binary, size, {}}; node.value.bin = dst;
+	add(node);
+}
+
+void DocumentBuilder::startObject() {
+	m_frames.push_back(Frame{static_cast<akSize>(m_pending.size()), m_key, true});
+}
+
+void DocumentBuilder::endObject() {
+	if (m_frames.empty() || !m_frames.back().isObject) throw std::logic_error("Unbalanced object in document.");
+	auto frame = m_frames.back(); m_frames.pop_back();
+
+	auto begin = m_pending.begin() + frame.start;
+	auto count = static_cast<akSize>(m_pending.size() - frame.start);
+
+	// Stable so the first of any duplicate keys wins, as with PValue. Insertion sort avoids stable_sort's buffer for typical objects.
+	auto compare = [](const internal::DocMember& lhs, const internal::DocMember& rhs){ return lhs.key < rhs.key; };
+	if (count <= SMALL_OBJECT_SIZE) {
+		for(auto iter = begin; iter != m_pending.end(); iter++) {
+			auto member = *iter;
+			auto dst = iter;
+			for(; (dst != begin) && compare(member, *(dst - 1)); dst--) *dst = *(dst - 1);
+			*dst = member;
+		}
+	} else {
+		std::stable_sort(begin, m_pending.end(), compare);
+	}
+
+	auto members = m_document.m_arena.allocate<internal::DocMember>(count);
+	std::copy(begin, m_pending.end(), members);
+	m_pending.erase(begin, m_pending.end());
+
+	m_key = frame.key;
+	internal::DocNode node{PType::Object, count, {}}; node.value.members = members;
+	add(node);
+}
+
+void DocumentBuilder::startArray() {
+	m_frames.push_back(Frame{static_cast<akSize>(m_pending.size()), m_key, false});
+}
+
+void DocumentBuilder::endArray() {
+	if (m_frames.empty() || m_frames.back().isObject) throw std::logic_error("Unbalanced array in document.");
+	auto frame = m_frames.back(); m_frames.pop_back();
+
+	auto count = static_cast<akSize>(m_pending.size() - frame.start);
+	auto elements = m_document.m_arena.allocate<internal::DocNode>(count);
+	for(akSize i = 0; i < count; i++) elements[i] = m_pending[frame.start + i].value;
+	m_pending.resize(frame.start);
+
+	m_key = frame.key;
+	internal::DocNode node{PType::Array, count, {}}; node.value.elements = elements;
+	add(node);
+}
+
+bool DocumentBuilder::finish() {
+	if (m_hasRoot && m_frames.empty()) return true;
+	m_document.clear();
+	return false;
+}
@@ -18,11 +18,14 @@
 #include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/String.hpp>
 #include <akengine/data/Base64.hpp>
+#include <akengine/data/Document.hpp>
 #include <akengine/data/Json.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/PVPath.hpp>
+#include <akengine/data/Stream.hpp>
 #include <akengine/debug/Log.hpp>
 #include <akengine/filesystem/CFile.hpp>
+#include <akengine/filesystem/Filesystem.hpp>
 #include <akengine/filesystem/Path.hpp>
 #include <rapidjson/encodings.h>
 #include <rapidjson/error/en.h>
@@ -42,6 +45,7 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -50,6 +54,7 @@ using namespace akd;
 namespace rj = rapidjson;
 
 constexpr auto JSON_BASE64_IDENTIFIER = AK_STRING_VIEW("[$$BASE64$$]");
+static constexpr akSize JSON_STREAM_BUFFER_SIZE = 64*1024;
 
 struct JSONParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONParser> {
 
@@ -60,6 +65,11 @@ struct JSONParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONParser> {
 
 		JSONParser(akd::PValue& a) : valueStack(), cKey("") { a.setNull(); valueStack.push_back(&a);}
 
+		/// Leaves a partial parse usable, objects still open were never sorted
+		void sortOpenObjects() {
+			for(auto value : valueStack) if (value->isObj()) value->getObj().sortAppended();
+		}
+
 		void addPValue(PValue&& value) {
 
 			bool isObjOrArr = value.isObj() || value.isArr();
@@ -67,13 +77,14 @@ struct JSONParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONParser> {
 			akd::PValue& cValue = *valueStack.back();
 
 			if (cValue.isObj()) {
-				cValue.getObj().emplace(cKey, std::move(value));
-				if (isObjOrArr) valueStack.push_back(&cValue.getObj().at(cKey));
+				// Sorted once the object ends, inserting in order would make large objects quadratic
+				auto& entry = cValue.getObj().appendUnsorted(std::move(cKey), std::move(value));
+				if (isObjOrArr) valueStack.push_back(&entry);
 			} else if (cValue.isArr()) {
 				cValue.getArr().push_back(std::move(value));
 				if (isObjOrArr) valueStack.push_back(&cValue.getArr().back());
 			} else {
-				cValue = value;
+				cValue = std::move(value);
 				if (!isObjOrArr) valueStack.pop_back();
 			}
 		}
@@ -135,6 +146,7 @@ struct JSONParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONParser> {
 	    }
 
 	    bool EndObject(rj::SizeType) {
+			valueStack.back()->getObj().sortAppended();
 			valueStack.pop_back();
 	    	return true;
 	    }
@@ -150,6 +162,38 @@ struct JSONParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONParser> {
 	    }
 };
 
+struct JSONDocumentParser : public rj::BaseReaderHandler<rj::UTF8<>, JSONDocumentParser> {
+	akd::DocumentBuilder& builder;
+
+	explicit JSONDocumentParser(akd::DocumentBuilder& documentBuilder) : builder(documentBuilder) {}
+
+	bool Null()             { builder.addNull(); return true; }
+	bool Bool(bool b)       { builder.addBool(b); return true; }
+	bool Int(int i)         { builder.addSInt(i); return true; }
+	bool Uint(unsigned u)   { builder.addUInt(u); return true; }
+	bool Int64(int64_t i)   { builder.addSInt(i); return true; }
+	bool Uint64(uint64_t u) { builder.addUInt(u); return true; }
+	bool Double(double d)   { builder.addDec(d); return true; }
+
+	bool String(const char* str, rj::SizeType length, bool) {
+		std::string_view inStr(str, length);
+		if (inStr.substr(0, JSON_BASE64_IDENTIFIER.size()) == JSON_BASE64_IDENTIFIER) {
+			auto data = akd::base64::decode(std::string(inStr.substr(JSON_BASE64_IDENTIFIER.size())));
+			builder.addBin(data.data(), static_cast<akSize>(data.size()));
+		} else {
+			builder.addStr(inStr);
+		}
+		return true;
+	}
+
+	bool Key(const char* str, rj::SizeType length, bool) { builder.setKey(std::string_view(str, length)); return true; }
+
+	bool StartObject()               { builder.startObject(); return true; }
+	bool EndObject(rj::SizeType)     { builder.endObject(); return true; }
+	bool StartArray()                { builder.startArray(); return true; }
+	bool EndArray(rj::SizeType)      { builder.endArray(); return true; }
+};
+
 bool akd::fromJson(akd::PValue& dest, const std::string& jsonStr) {
 	dest = akd::PValue();
 	JSONParser handler(dest);
@@ -157,6 +201,7 @@ bool akd::fromJson(akd::PValue& dest, const std::string& jsonStr) {
 	rj::StringStream stream(jsonStr.c_str());
 	auto result = reader.Parse<rj::kParseTrailingCommasFlag | rj::kParseFullPrecisionFlag>(stream, handler);
 	if (result.IsError()) {
+		handler.sortOpenObjects();
 		akl::Logger("Json").warn("JSON Parse error (Offset ", result.Offset(), "): ", rj::GetParseError_En(result.Code()));
 		return false;
 	}
@@ -276,3 +321,271 @@ akd::PValue akd::fromJsonFile(const akfs::Path& filepath) {
 	return dst;
 }
 
+bool akd::fromJson(akd::Document& dest, const std::string& jsonStr) {
+	akd::DocumentBuilder builder(dest);
+	JSONDocumentParser handler(builder);
+	rj::Reader reader;
+	rj::StringStream stream(jsonStr.c_str());
+	auto result = reader.Parse<rj::kParseTrailingCommasFlag | rj::kParseFullPrecisionFlag>(stream, handler);
+	if (result.IsError()) {
+		akl::Logger("Json").warn("JSON Parse error (Offset ", result.Offset(), "): ", rj::GetParseError_En(result.Code()));
+		dest.clear();
+		return false;
+	}
+	return builder.finish();
+}
+
+bool akd::fromJsonFile(akd::Document& dest, const akfs::Path& filepath) {
+	akfs::CFile inFile(filepath);
+	std::string fileContents; if (!inFile.readAllLines(fileContents)) { dest.clear(); return false; }
+	return fromJson(dest, fileContents);
+}
+
+// /////////////// //
+// // Streaming // //
+// /////////////// //
+
+/// rapidjson output stream, buffering writes to a file
+class JSONOutputStream final {
+	private:
+		akfs::CFile& m_file;
+		std::vector<char> m_buffer;
+		bool m_failed;
+
+	public:
+		typedef char Ch;
+
+		explicit JSONOutputStream(akfs::CFile& file) : m_file(file), m_buffer(), m_failed(false) { m_buffer.reserve(JSON_STREAM_BUFFER_SIZE); }
+
+		void Put(Ch c) {
+			m_buffer.push_back(c);
+			if (m_buffer.size() >= JSON_STREAM_BUFFER_SIZE) Flush();
+		}
+
+		void Flush() {
+			if (m_buffer.empty()) return;
+			if (m_file.write(m_buffer.data(), m_buffer.size()) != m_buffer.size()) m_failed = true;
+			m_buffer.clear();
+		}
+
+		bool failed() const { return m_failed; }
+};
+
+/// rapidjson input stream, reading a file in blocks
+class JSONInputStream final {
+	private:
+		akfs::CFile& m_file;
+		std::vector<char> m_buffer;
+		size_t m_pos, m_end, m_count;
+
+	public:
+		typedef char Ch;
+
+		explicit JSONInputStream(akfs::CFile& file) : m_file(file), m_buffer(JSON_STREAM_BUFFER_SIZE), m_pos(0), m_end(0), m_count(0) {}
+
+		Ch Peek() {
+			if (m_pos == m_end) { m_pos = 0; m_end = m_file.read(m_buffer.data(), m_buffer.size()); }
+			return m_pos < m_end ? m_buffer[m_pos] : '\0';
+		}
+
+		Ch Take() {
+			auto c = Peek();
+			if (m_pos < m_end) { m_pos++; m_count++; }
+			return c;
+		}
+
+		size_t Tell() const { return m_count; }
+
+		Ch* PutBegin() { RAPIDJSON_ASSERT(false); return nullptr; }
+		void Put(Ch) { RAPIDJSON_ASSERT(false); }
+		void Flush() { RAPIDJSON_ASSERT(false); }
+		size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+};
+
+template<typename rjwriter_t> class JSONStreamWriter final : public akd::Writer {
+	private:
+		rjwriter_t m_writer;
+
+	public:
+		explicit JSONStreamWriter(JSONOutputStream& stream) : m_writer(stream) {
+			if constexpr (std::is_same<rjwriter_t, rj::PrettyWriter<JSONOutputStream>>::value) m_writer.SetFormatOptions(rj::PrettyFormatOptions::kFormatSingleLineArray);
+		}
+
+		void writeNull() override { m_writer.Null(); }
+		void writeBool(bool val) override { m_writer.Bool(val); }
+		void writeSInt(int64 val) override { m_writer.Int64(val); }
+		void writeUInt(uint64 val) override { m_writer.Uint64(val); }
+		void writeDec(fpDouble val) override { m_writer.Double(val); }
+		void writeStr(std::string_view val) override { m_writer.String(val.data(), static_cast<rj::SizeType>(val.size())); }
+
+		void writeBin(const uint8* data, akSize size) override {
+			std::string binStr = std::string(JSON_BASE64_IDENTIFIER) + akd::base64::encode(data, size);
+			m_writer.String(binStr.data(), static_cast<rj::SizeType>(binStr.size()));
+		}
+
+		void startArray(akSize) override { m_writer.StartArray(); }
+		void endArray() override { m_writer.EndArray(); }
+
+		void startObject(akSize) override { m_writer.StartObject(); }
+		void writeKey(std::string_view key) override { m_writer.Key(key.data(), static_cast<rj::SizeType>(key.size())); }
+		void endObject() override { m_writer.EndObject(); }
+};
+
+/// Pulls one token at a time from rapidjson's iterative parser
+class JSONStreamReader final : public akd::Reader {
+	private:
+		enum class Token : uint8 { None, Null, Bool, SInt, UInt, Dec, Str, Key, StartObject, EndObject, StartArray, EndArray };
+
+		struct Handler : public rj::BaseReaderHandler<rj::UTF8<>, Handler> {
+			JSONStreamReader& owner;
+
+			explicit Handler(JSONStreamReader& reader) : owner(reader) {}
+
+			bool Null()             { owner.m_token = Token::Null; return true; }
+			bool Bool(bool b)       { owner.m_token = Token::Bool; owner.m_bool = b; return true; }
+			bool Int(int i)         { owner.m_token = Token::SInt; owner.m_sint = i; return true; }
+			bool Uint(unsigned u)   { owner.m_token = Token::UInt; owner.m_uint = u; return true; }
+			bool Int64(int64_t i)   { owner.m_token = Token::SInt; owner.m_sint = i; return true; }
+			bool Uint64(uint64_t u) { owner.m_token = Token::UInt; owner.m_uint = u; return true; }
+			bool Double(double d)   { owner.m_token = Token::Dec;  owner.m_dec = d; return true; }
+
+			bool String(const char* str, rj::SizeType length, bool) { owner.m_token = Token::Str; owner.m_str.assign(str, length); return true; }
+			bool Key(const char* str, rj::SizeType length, bool)    { owner.m_token = Token::Key; owner.m_str.assign(str, length); return true; }
+
+			bool StartObject()           { owner.m_token = Token::StartObject; return true; }
+			bool EndObject(rj::SizeType) { owner.m_token = Token::EndObject; return true; }
+			bool StartArray()            { owner.m_token = Token::StartArray; return true; }
+			bool EndArray(rj::SizeType)  { owner.m_token = Token::EndArray; return true; }
+		};
+
+		JSONInputStream& m_stream;
+		rj::Reader m_reader;
+		Handler m_handler;
+
+		Token m_token;
+		bool m_bool;
+		int64 m_sint;
+		uint64 m_uint;
+		fpDouble m_dec;
+		std::string m_str;
+		std::vector<uint8> m_bin;
+
+		bool isBinary() const { return std::string_view(m_str).substr(0, JSON_BASE64_IDENTIFIER.size()) == JSON_BASE64_IDENTIFIER; }
+
+		Token token() {
+			while(m_token == Token::None) {
+				if (m_reader.IterativeParseComplete()) throw std::runtime_error("Unexpected end of JSON data.");
+				if (!m_reader.IterativeParseNext<rj::kParseTrailingCommasFlag | rj::kParseFullPrecisionFlag>(m_stream, m_handler)) {
+					throw std::runtime_error(akc::buildString("JSON Parse error (Offset ", m_reader.GetErrorOffset(), "): ", rj::GetParseError_En(m_reader.GetParseErrorCode())));
+				}
+			}
+			return m_token;
+		}
+
+		void consume(Token expected) {
+			if (token() != expected) throw std::logic_error("JSON stream does not contain the requested type.");
+			m_token = Token::None;
+		}
+
+	public:
+		explicit JSONStreamReader(JSONInputStream& stream) : m_stream(stream), m_reader(), m_handler(*this), m_token(Token::None), m_bool(false), m_sint(0), m_uint(0), m_dec(0), m_str(), m_bin() {
+			m_reader.IterativeParseInit();
+		}
+
+		akd::PType peek() override {
+			switch(token()) {
+				case Token::Null:        return akd::PType::Null;
+				case Token::Bool:        return akd::PType::Boolean;
+				case Token::SInt:        return akd::PType::Signed;
+				case Token::UInt:        return akd::PType::Unsigned;
+				case Token::Dec:         return akd::PType::Decimal;
+				case Token::Str:         return isBinary() ? akd::PType::Binary : akd::PType::String;
+				case Token::StartObject: return akd::PType::Object;
+				case Token::StartArray:  return akd::PType::Array;
+
+				case Token::None:
+				case Token::Key:
+				case Token::EndObject:
+				case Token::EndArray:
+					break;
+			}
+			throw std::logic_error("JSON stream is not at a value.");
+		}
+
+		void readNull() override { consume(Token::Null); }
+		bool readBool() override { consume(Token::Bool); return m_bool; }
+		int64 readSInt() override { consume(Token::SInt); return m_sint; }
+		uint64 readUInt() override { consume(Token::UInt); return m_uint; }
+		fpDouble readDec() override { consume(Token::Dec); return m_dec; }
+
+		std::string_view readStr() override {
+			if (peek() != akd::PType::String) throw std::logic_error("JSON stream does not contain a string.");
+			consume(Token::Str);
+			return m_str;
+		}
+
+		akc::Span<const uint8> readBin() override {
+			if (peek() != akd::PType::Binary) throw std::logic_error("JSON stream does not contain binary data.");
+			consume(Token::Str);
+			m_bin = akd::base64::decode(m_str.substr(JSON_BASE64_IDENTIFIER.size()));
+			return akc::Span<const uint8>(m_bin.data(), static_cast<akSize>(m_bin.size()));
+		}
+
+		akSize startArray() override { consume(Token::StartArray); return 0; }
+
+		bool nextElement() override {
+			if (token() != Token::EndArray) return true;
+			m_token = Token::None;
+			return false;
+		}
+
+		akSize startObject() override { consume(Token::StartObject); return 0; }
+
+		bool nextKey(std::string_view& key) override {
+			if (token() == Token::EndObject) { m_token = Token::None; return false; }
+			consume(Token::Key);
+			key = m_str;
+			return true;
+		}
+};
+
+bool akd::streamToJsonFile(const akfs::Path& filepath, const std::function<void(akd::Writer&)>& func, bool pretty, bool overwrite) {
+	if (!overwrite && akfs::exists(filepath)) return false;
+
+	// A failed or interrupted write must never leave the destination truncated
+	auto tmpPath = akfs::Path(filepath.str() + ".tmp");
+	try {
+		bool written = [&]{
+			akfs::CFile oFile(tmpPath, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+			if (!oFile) return false;
+
+			JSONOutputStream stream(oFile);
+			if (pretty) { JSONStreamWriter<rj::PrettyWriter<JSONOutputStream>> writer(stream); func(writer); }
+			else        { JSONStreamWriter<rj::Writer<JSONOutputStream>> writer(stream);       func(writer); }
+			stream.Flush();
+
+			return !stream.failed() && oFile.flush();
+		}();
+		if (written && akfs::rename(tmpPath, filepath, true)) return true;
+	} catch(const std::exception& e) {
+		akl::Logger("Json").warn("Failed to stream '", filepath.str(), "': ", e.what());
+	}
+
+	akfs::remove(tmpPath);
+	return false;
+}
+
+bool akd::streamFromJsonFile(const akfs::Path& filepath, const std::function<bool(akd::Reader&)>& func) {
+	akfs::CFile inFile(filepath);
+	if (!inFile) return false;
+
+	try {
+		JSONInputStream stream(inFile);
+		JSONStreamReader reader(stream);
+		return func(reader);
+	} catch(const std::exception& e) {
+		akl::Logger("Json").warn("Failed to stream '", filepath.str(), "': ", e.what());
+		return false;
+	}
+}
+
@@ -15,11 +15,16 @@
  **/
 
 #include <akengine/data/Brotli.hpp>
+#include <akengine/data/Document.hpp>
 #include <akengine/data/MsgPack.hpp>
 #include <akengine/data/PVPath.hpp>
+#include <akengine/data/Stream.hpp>
+#include <akengine/debug/Log.hpp>
 #include <akengine/filesystem/CFile.hpp>
+#include <akengine/filesystem/Filesystem.hpp>
 #include <msgpack.hpp>
 #include <string.h>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
@@ -28,17 +33,29 @@
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 using namespace akd;
 
+static constexpr akSize MSGPACK_STREAM_BUFFER_SIZE = 64*1024;
+
 
 struct MSGPackVistor : public msgpack::v2::null_visitor {
 	bool isKeyValue;
 	std::pair<std::string, akd::PValue> nextValue;
 	std::vector<std::pair<std::string, akd::PValue>> stack;
+	std::size_t reserveBudget; /// Entries still allowed to be reserved, every entry takes at least a byte of input
+
+	MSGPackVistor(std::size_t inputSize) : isKeyValue(false), nextValue("", akd::PValue()), stack(), reserveBudget(inputSize) {}
 
-	MSGPackVistor() : isKeyValue(false), nextValue("", akd::PValue()), stack() {}
+	/// Container counts come straight from the input, never reserve more than it could hold
+	std::size_t takeReserve(std::size_t count) {
+		count = std::min(count, reserveBudget);
+		reserveBudget -= count;
+		return count;
+	}
 
     // Value
     bool visit_nil() {
@@ -92,14 +109,14 @@ struct MSGPackVistor : public msgpack::v2::null_visitor {
 
     // Array
 
-    bool start_array(uint32_t /*count*/) {
-    	nextValue.second = akd::PValue().setArr();
-    	stack.push_back(nextValue);
+    bool start_array(uint32_t count) {
+    	nextValue.second.setArr().getArr().reserve(takeReserve(count));
+    	stack.push_back(std::move(nextValue));
         return true;
     }
 
     bool end_array() {
-    	nextValue = stack.back();
+    	nextValue = std::move(stack.back());
     	stack.pop_back();
         return true;
     }
@@ -110,20 +127,21 @@ struct MSGPackVistor : public msgpack::v2::null_visitor {
     }
 
     bool end_array_item() {
-    	stack.back().second.getArr().push_back(nextValue.second);
+    	stack.back().second.getArr().push_back(std::move(nextValue.second));
         return true;
     }
 
     // Object
 
-    bool start_map(uint32_t /*count*/) {
-    	nextValue.second = akd::PValue().setObj();
-    	stack.push_back(nextValue);
+    bool start_map(uint32_t count) {
+    	nextValue.second.setObj().getObj().reserve(takeReserve(count*std::size_t(2))/2);
+    	stack.push_back(std::move(nextValue));
         return true;
     }
 
     bool end_map() {
-    	nextValue = stack.back();
+    	stack.back().second.getObj().sortAppended();
+    	nextValue = std::move(stack.back());
     	stack.pop_back();
         return true;
     }
@@ -145,7 +163,8 @@ struct MSGPackVistor : public msgpack::v2::null_visitor {
     }
 
     bool end_map_value() {
-    	stack.back().second.getObj().insert(nextValue);
+    	// Sorted once the map ends, inserting in order would make large maps quadratic
+    	stack.back().second.getObj().appendUnsorted(std::move(nextValue.first), std::move(nextValue.second));
         return true;
     }
 
@@ -154,6 +173,52 @@ struct MSGPackVistor : public msgpack::v2::null_visitor {
     void insufficient_bytes(size_t /*parsed_offset*/, size_t /*error_offset*/) {}
 };
 
+// Non-string keys are dropped (read as ""), matching MSGPackVistor
+struct MSGPackDocumentVisitor : public msgpack::v2::null_visitor {
+	akd::DocumentBuilder& builder;
+	bool isKeyValue;
+
+	explicit MSGPackDocumentVisitor(akd::DocumentBuilder& documentBuilder) : builder(documentBuilder), isKeyValue(false) {}
+
+    // Value
+    bool visit_nil()                        { if (!isKeyValue) builder.addNull(); return true; }
+    bool visit_boolean(bool v)              { if (!isKeyValue) builder.addBool(v); return true; }
+    bool visit_positive_integer(uint64_t v) { if (!isKeyValue) builder.addUInt(v); return true; }
+    bool visit_negative_integer(int64_t v)  { if (!isKeyValue) builder.addSInt(v); return true; }
+    bool visit_float32(float v)             { if (!isKeyValue) builder.addDec(static_cast<fpDouble>(v)); return true; }
+    bool visit_float64(double v)            { if (!isKeyValue) builder.addDec(v); return true; }
+
+    bool visit_str(const char* v, uint32_t size) {
+    	if (isKeyValue) builder.setKey(std::string_view(v, size));
+    	else builder.addStr(std::string_view(v, size));
+        return true;
+    }
+
+    bool visit_bin(const char* v, uint32_t size) {
+    	if (!isKeyValue) builder.addBin(reinterpret_cast<const uint8*>(v), size);
+        return true;
+    }
+
+    bool visit_ext(const char* v, uint32_t size) {
+    	if (!isKeyValue) builder.addStr(std::string_view(v, size));
+        return true;
+    }
+
+    // Array
+    bool start_array(uint32_t /*count*/) { builder.startArray(); return true; }
+    bool end_array()                     { builder.endArray(); return true; }
+
+    // Object
+    bool start_map(uint32_t /*count*/) { builder.startObject(); return true; }
+    bool end_map()                     { builder.endObject(); return true; }
+    bool start_map_key()               { builder.setKey(""); isKeyValue = true; return true; }
+    bool end_map_key()                 { isKeyValue = false; return true; }
+
+    // Error
+    void parse_error(size_t /*parsed_offset*/, size_t /*error_offset*/) {}
+    void insufficient_bytes(size_t /*parsed_offset*/, size_t /*error_offset*/) {}
+};
+
 std::vector<uint8> akd::toMsgPack(const akd::PValue& src) {
 
     msgpack::sbuffer buffer;
@@ -195,10 +260,10 @@ std::vector<uint8> akd::toMsgPack(const akd::PValue& src) {
 }
 
 bool akd::fromMsgPack(akd::PValue& dest, const std::vector<uint8>& msgPackStream) {
-	MSGPackVistor vistor;
+	MSGPackVistor vistor(msgPackStream.size());
 	std::size_t off = 0;
 	if (!msgpack::v2::parse(reinterpret_cast<const char*>(msgPackStream.data()), msgPackStream.size(), off, vistor)) return false;
-	dest = vistor.nextValue.second;
+	dest = std::move(vistor.nextValue.second);
 	return true;
 }
 
@@ -218,3 +283,315 @@ akd::PValue akd::fromMsgPackFile(const akfs::Path& filepath, bool decompress) {
 	akd::PValue dst; if (!fromMsgPack(dst, fileContents)) return akd::PValue();
 	return dst;
 }
+
+// /////////////// //
+// // Streaming // //
+// /////////////// //
+
+/// msgpack-c packer stream, buffering writes to a file or, without one, keeping everything for compression
+class MSGPackOutputStream final {
+	private:
+		akfs::CFile* m_file;
+		std::vector<uint8> m_buffer;
+		bool m_failed;
+
+	public:
+		explicit MSGPackOutputStream(akfs::CFile* file) : m_file(file), m_buffer(), m_failed(false) {}
+
+		void write(const char* data, size_t size) {
+			m_buffer.insert(m_buffer.end(), reinterpret_cast<const uint8*>(data), reinterpret_cast<const uint8*>(data) + size);
+			if (m_file && (m_buffer.size() >= MSGPACK_STREAM_BUFFER_SIZE)) flush();
+		}
+
+		void flush() {
+			if (!m_file || m_buffer.empty()) return;
+			if (m_file->write(m_buffer.data(), m_buffer.size()) != m_buffer.size()) m_failed = true;
+			m_buffer.clear();
+		}
+
+		std::vector<uint8>& buffer() { return m_buffer; }
+		bool failed() const { return m_failed; }
+};
+
+class MSGPackStreamWriter final : public akd::Writer {
+	private:
+		msgpack::packer<MSGPackOutputStream> m_packer;
+
+	public:
+		explicit MSGPackStreamWriter(MSGPackOutputStream& stream) : m_packer(&stream) {}
+
+		void writeNull() override { m_packer.pack_nil(); }
+		void writeBool(bool val) override { m_packer.pack(val); }
+		void writeSInt(int64 val) override { m_packer.pack(val); }
+		void writeUInt(uint64 val) override { m_packer.pack(val); }
+		void writeDec(fpDouble val) override { m_packer.pack(val); }
+
+		void writeStr(std::string_view val) override {
+			m_packer.pack_str(static_cast<uint32_t>(val.size()));
+			m_packer.pack_str_body(val.data(), static_cast<uint32_t>(val.size()));
+		}
+
+		void writeBin(const uint8* data, akSize size) override {
+			m_packer.pack_bin(size);
+			m_packer.pack_bin_body(reinterpret_cast<const char*>(data), size);
+		}
+
+		void startArray(akSize size) override { m_packer.pack_array(size); }
+		void endArray() override {}
+
+		void startObject(akSize size) override { m_packer.pack_map(size); }
+		void writeKey(std::string_view key) override { writeStr(key); }
+		void endObject() override {}
+};
+
+/// Bytes for MSGPackStreamReader, pulled from a file in blocks or, without one, held entirely in memory
+class MSGPackInputStream final {
+	private:
+		akfs::CFile* m_file;
+		std::vector<uint8> m_buffer;
+		size_t m_pos;
+
+	public:
+		MSGPackInputStream(akfs::CFile* file, std::vector<uint8> data) : m_file(file), m_buffer(std::move(data)), m_pos(0) {}
+
+		/// @return Size contiguous bytes, valid until the next call
+		const uint8* take(size_t size) {
+			if (m_buffer.size() - m_pos < size) {
+				if (!m_file) throw std::runtime_error("Unexpected end of MsgPack data.");
+				m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_pos));
+				m_pos = 0;
+				while(m_buffer.size() < size) {
+					auto offset = m_buffer.size();
+					m_buffer.resize(offset + std::max<size_t>(MSGPACK_STREAM_BUFFER_SIZE, size - offset));
+					auto count = m_file->read(m_buffer.data() + offset, m_buffer.size() - offset);
+					m_buffer.resize(offset + count);
+					if (count == 0) throw std::runtime_error("Unexpected end of MsgPack data.");
+				}
+			}
+			auto result = m_buffer.data() + m_pos;
+			m_pos += size;
+			return result;
+		}
+};
+
+/**
+ * Decodes MsgPack one value at a time, msgpack-c only offers whole-buffer parsing.
+ * Values are typed the same way as MSGPackVistor (e.g. non-negative signed ints read as unsigned).
+ */
+class MSGPackStreamReader final : public akd::Reader {
+	private:
+		MSGPackInputStream& m_stream;
+		std::vector<uint32> m_remaining;
+
+		bool m_hasHeader;
+		akd::PType m_type;
+		uint64 m_value;    /// Length of strings, binary and containers, unsigned values and the bits of signed/decimal values
+		bool m_isSingle;   /// If a decimal is stored as a float32
+
+		uint64 readBigEndian(size_t size) {
+			auto data = m_stream.take(size);
+			uint64 result = 0;
+			for(size_t i = 0; i < size; i++) result = (result << 8) | data[i];
+			return result;
+		}
+
+		void setHeader(akd::PType type, uint64 value) {
+			m_type = type;
+			m_value = value;
+			m_hasHeader = true;
+		}
+
+		void setSigned(int64 value) {
+			if (value >= 0) setHeader(akd::PType::Unsigned, static_cast<uint64>(value));
+			else setHeader(akd::PType::Signed, static_cast<uint64>(value));
+		}
+
+		void readHeader() {
+			auto marker = *m_stream.take(1);
+			m_isSingle = false;
+
+			if (marker <= 0x7F) return setHeader(akd::PType::Unsigned, marker);
+			if (marker <= 0x8F) return setHeader(akd::PType::Object,   marker & 0x0F);
+			if (marker <= 0x9F) return setHeader(akd::PType::Array,    marker & 0x0F);
+			if (marker <= 0xBF) return setHeader(akd::PType::String,   marker & 0x1F);
+			if (marker >= 0xE0) return setHeader(akd::PType::Signed,   static_cast<uint64>(static_cast<int64>(static_cast<int8>(marker))));
+
+			switch(marker) {
+				case 0xC0: return setHeader(akd::PType::Null, 0);
+				case 0xC2: return setHeader(akd::PType::Boolean, 0);
+				case 0xC3: return setHeader(akd::PType::Boolean, 1);
+
+				case 0xC4: return setHeader(akd::PType::Binary, readBigEndian(1));
+				case 0xC5: return setHeader(akd::PType::Binary, readBigEndian(2));
+				case 0xC6: return setHeader(akd::PType::Binary, readBigEndian(4));
+
+				// Extensions read as strings of their type byte and data, as with MSGPackVistor
+				case 0xC7: return setHeader(akd::PType::String, readBigEndian(1) + 1);
+				case 0xC8: return setHeader(akd::PType::String, readBigEndian(2) + 1);
+				case 0xC9: return setHeader(akd::PType::String, readBigEndian(4) + 1);
+				case 0xD4: return setHeader(akd::PType::String, 1 + 1);
+				case 0xD5: return setHeader(akd::PType::String, 2 + 1);
+				case 0xD6: return setHeader(akd::PType::String, 4 + 1);
+				case 0xD7: return setHeader(akd::PType::String, 8 + 1);
+				case 0xD8: return setHeader(akd::PType::String, 16 + 1);
+
+				case 0xCA: m_isSingle = true; return setHeader(akd::PType::Decimal, readBigEndian(4));
+				case 0xCB: return setHeader(akd::PType::Decimal, readBigEndian(8));
+
+				case 0xCC: return setHeader(akd::PType::Unsigned, readBigEndian(1));
+				case 0xCD: return setHeader(akd::PType::Unsigned, readBigEndian(2));
+				case 0xCE: return setHeader(akd::PType::Unsigned, readBigEndian(4));
+				case 0xCF: return setHeader(akd::PType::Unsigned, readBigEndian(8));
+
+				case 0xD0: return setSigned(static_cast<int8>(readBigEndian(1)));
+				case 0xD1: return setSigned(static_cast<int16>(readBigEndian(2)));
+				case 0xD2: return setSigned(static_cast<int32>(readBigEndian(4)));
+				case 0xD3: return setSigned(static_cast<int64>(readBigEndian(8)));
+
+				case 0xD9: return setHeader(akd::PType::String, readBigEndian(1));
+				case 0xDA: return setHeader(akd::PType::String, readBigEndian(2));
+				case 0xDB: return setHeader(akd::PType::String, readBigEndian(4));
+
+				case 0xDC: return setHeader(akd::PType::Array, readBigEndian(2));
+				case 0xDD: return setHeader(akd::PType::Array, readBigEndian(4));
+				case 0xDE: return setHeader(akd::PType::Object, readBigEndian(2));
+				case 0xDF: return setHeader(akd::PType::Object, readBigEndian(4));
+
+				default: throw std::runtime_error(akc::buildString("Invalid MsgPack marker: ", static_cast<uint32>(marker)));
+			}
+		}
+
+		uint64 consume(akd::PType expected) {
+			if (peek() != expected) throw std::logic_error("MsgPack stream does not contain the requested type.");
+			m_hasHeader = false;
+			return m_value;
+		}
+
+		akSize startContainer(akd::PType type) {
+			auto size = static_cast<uint32>(consume(type));
+			m_remaining.push_back(size);
+			return size;
+		}
+
+		bool nextEntry() {
+			if (m_remaining.empty()) throw std::logic_error("MsgPack stream is not in a container.");
+			if (m_remaining.back() == 0) { m_remaining.pop_back(); return false; }
+			m_remaining.back()--;
+			return true;
+		}
+
+	public:
+		explicit MSGPackStreamReader(MSGPackInputStream& stream) : m_stream(stream), m_remaining(), m_hasHeader(false), m_type(akd::PType::Null), m_value(0), m_isSingle(false) {}
+
+		akd::PType peek() override {
+			if (!m_hasHeader) readHeader();
+			return m_type;
+		}
+
+		void readNull() override { consume(akd::PType::Null); }
+		bool readBool() override { return consume(akd::PType::Boolean) != 0; }
+		int64 readSInt() override { return static_cast<int64>(consume(akd::PType::Signed)); }
+		uint64 readUInt() override { return consume(akd::PType::Unsigned); }
+
+		fpDouble readDec() override {
+			auto bits = consume(akd::PType::Decimal);
+			if (m_isSingle) { fpSingle result; auto bits32 = static_cast<uint32>(bits); std::memcpy(&result, &bits32, sizeof(result)); return static_cast<fpDouble>(result); }
+			fpDouble result; std::memcpy(&result, &bits, sizeof(result)); return result;
+		}
+
+		std::string_view readStr() override {
+			auto size = static_cast<size_t>(consume(akd::PType::String));
+			return std::string_view(reinterpret_cast<const char*>(m_stream.take(size)), size);
+		}
+
+		akc::Span<const uint8> readBin() override {
+			auto size = static_cast<akSize>(consume(akd::PType::Binary));
+			return akc::Span<const uint8>(m_stream.take(size), size);
+		}
+
+		akSize startArray() override { return startContainer(akd::PType::Array); }
+		bool nextElement() override { return nextEntry(); }
+
+		akSize startObject() override { return startContainer(akd::PType::Object); }
+
+		bool nextKey(std::string_view& key) override {
+			if (!nextEntry()) return false;
+			if (peek() == akd::PType::String) { key = readStr(); }
+			else { skip(); key = std::string_view(); } // Non-string keys read as "", as with MSGPackVistor
+			return true;
+		}
+};
+
+bool akd::streamToMsgPackFile(const akfs::Path& filepath, const std::function<void(akd::Writer&)>& func, bool compress, bool overwrite) {
+	if (!overwrite && akfs::exists(filepath)) return false;
+
+	// A failed or interrupted write must never leave the destination truncated
+	auto tmpPath = akfs::Path(filepath.str() + ".tmp");
+	try {
+		bool written = [&]{
+			akfs::CFile oFile(tmpPath, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+			if (!oFile) return false;
+
+			MSGPackOutputStream stream(compress ? nullptr : &oFile);
+			MSGPackStreamWriter writer(stream);
+			func(writer);
+
+			if (compress) {
+				auto fileData = akd::compressBrotli(stream.buffer());
+				return (oFile.write(fileData.data(), fileData.size()) == fileData.size()) && oFile.flush();
+			}
+
+			stream.flush();
+			return !stream.failed() && oFile.flush();
+		}();
+		if (written && akfs::rename(tmpPath, filepath, true)) return true;
+	} catch(const std::exception& e) {
+		akl::Logger("MsgPack").warn("Failed to stream '", filepath.str(), "': ", e.what());
+	}
+
+	akfs::remove(tmpPath);
+	return false;
+}
+
+bool akd::streamFromMsgPackFile(const akfs::Path& filepath, const std::function<bool(akd::Reader&)>& func, bool decompress) {
+	akfs::CFile inFile(filepath);
+	if (!inFile) return false;
+
+	try {
+		if (decompress) {
+			std::vector<uint8> fileContents; if (!inFile.readAll(fileContents)) return false;
+			MSGPackInputStream stream(nullptr, akd::decompressBrotli(fileContents));
+			MSGPackStreamReader reader(stream);
+			return func(reader);
+		}
+
+		MSGPackInputStream stream(&inFile, {});
+		MSGPackStreamReader reader(stream);
+		return func(reader);
+	} catch(const std::exception& e) {
+		akl::Logger("MsgPack").warn("Failed to stream '", filepath.str(), "': ", e.what());
+		return false;
+	}
+}
+
+bool akd::fromMsgPack(akd::Document& dest, const std::vector<uint8>& msgPackStream) {
+	akd::DocumentBuilder builder(dest);
+	MSGPackDocumentVisitor vistor(builder);
+	std::size_t off = 0;
+	if (!msgpack::v2::parse(reinterpret_cast<const char*>(msgPackStream.data()), msgPackStream.size(), off, vistor)) { dest.clear(); return false; }
+	return builder.finish();
+}
+
+bool akd::fromMsgPackFile(akd::Document& dest, const akfs::Path& filepath, bool decompress) {
+	akfs::CFile inFile(filepath);
+	std::vector<uint8> fileContents; if (!inFile.readAll(fileContents)) { dest.clear(); return false; }
+	if (decompress) fileContents = akd::decompressBrotli(fileContents);
+	return fromMsgPack(dest, fileContents);
+}
+
+bool akd::fromMsgPackFile(akd::MsgPackIndex& dest, const akfs::Path& filepath, bool decompress) {
+	akfs::CFile inFile(filepath);
+	std::vector<uint8> fileContents; if (!inFile.readAll(fileContents)) { dest.clear(); return false; }
+	if (decompress) fileContents = akd::decompressBrotli(fileContents);
+	return dest.parse(std::move(fileContents));
+}
@@ -0,0 +1,245 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/data/MsgPackView.hpp>
+#include <cstring>
+#include <utility>
+
+using namespace akd;
+
+namespace {
+	struct Header final {
+		PType type;
+		uint8 size;    /// Bytes before the payload or first child
+		uint32 length; /// Bytes of string/binary payload, entry count of containers
+	};
+
+	uint64 readBigEndian(const uint8* data, akSize size) {
+		uint64 result = 0;
+		for(akSize i = 0; i < size; i++) result = (result << 8) | data[i];
+		return result;
+	}
+
+	/// @return 0 for the unused marker
+	uint8 headerSize(uint8 marker) {
+		if ((marker <= 0xBF) || (marker >= 0xE0)) return 1;
+		switch(marker) {
+			case 0xC1: return 0;
+			case 0xC4: case 0xC7: case 0xCC: case 0xD0: case 0xD9: return 2;
+			case 0xC5: case 0xC8: case 0xCD: case 0xD1: case 0xDA: case 0xDC: case 0xDE: return 3;
+			case 0xC6: case 0xC9: case 0xCA: case 0xCE: case 0xD2: case 0xDB: case 0xDD: case 0xDF: return 5;
+			case 0xCB: case 0xCF: case 0xD3: return 9;
+			default: return 1; // nil, booleans and fixext
+		}
+	}
+
+	int64 readSigned(const uint8* data) {
+		switch(data[0]) {
+			case 0xD0: return static_cast<int8>(data[1]);
+			case 0xD1: return static_cast<int16>(readBigEndian(data + 1, 2));
+			case 0xD2: return static_cast<int32>(readBigEndian(data + 1, 4));
+			default:   return static_cast<int64>(readBigEndian(data + 1, 8));
+		}
+	}
+
+	/// Assumes headerSize(data[0]) bytes are available
+	Header readHeader(const uint8* data) {
+		auto marker = data[0];
+		if (marker <= 0x7F) return {PType::Unsigned, 1, 0};
+		if (marker <= 0x8F) return {PType::Object, 1, static_cast<uint32>(marker & 0x0F)};
+		if (marker <= 0x9F) return {PType::Array,  1, static_cast<uint32>(marker & 0x0F)};
+		if (marker <= 0xBF) return {PType::String, 1, static_cast<uint32>(marker & 0x1F)};
+		if (marker >= 0xE0) return {PType::Signed, 1, 0};
+
+		auto size = headerSize(marker);
+		auto length = [&]{ return static_cast<uint32>(readBigEndian(data + 1, size - 1u)); };
+		switch(marker) {
+			case 0xC2: case 0xC3: return {PType::Boolean, size, 0};
+			case 0xC4: case 0xC5: case 0xC6: return {PType::Binary, size, length()};
+			case 0xC7: case 0xC8: case 0xC9: return {PType::String, size, length() + 1}; // Type byte is part of the payload
+			case 0xCA: case 0xCB: return {PType::Decimal, size, 0};
+			case 0xCC: case 0xCD: case 0xCE: case 0xCF: return {PType::Unsigned, size, 0};
+			case 0xD0: case 0xD1: case 0xD2: case 0xD3: return {(readSigned(data) < 0) ? PType::Signed : PType::Unsigned, size, 0};
+			case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8: return {PType::String, size, static_cast<uint32>(1 + (1 << (marker - 0xD4)))};
+			case 0xD9: case 0xDA: case 0xDB: return {PType::String, size, length()};
+			case 0xDC: case 0xDD: return {PType::Array,  size, length()};
+			case 0xDE: case 0xDF: return {PType::Object, size, length()};
+			default: return {PType::Null, size, 0};
+		}
+	}
+}
+
+// ///////////////// //
+// // MsgPackView // //
+// ///////////////// //
+
+MsgPackView MsgPackView::atOrDef(std::string_view name) const {
+	if (!isObj()) return MsgPackView();
+	for(akSize i = 0; i < size(); i++) {
+		auto key = child(i*2);
+		if (key.isStr() && (key.getStr() == name)) return child(i*2 + 1);
+	}
+	return MsgPackView();
+}
+
+std::string_view MsgPackView::getStr() const {
+	if (!isStr()) throw std::logic_error("MsgPackView does not contain a string.");
+	auto data = m_data + m_node->offset;
+	auto header = readHeader(data);
+	return std::string_view(reinterpret_cast<const char*>(data + header.size), header.length);
+}
+
+akc::Span<const uint8> MsgPackView::getBin() const {
+	if (!isBin()) throw std::logic_error("MsgPackView does not contain binary data.");
+	auto data = m_data + m_node->offset;
+	auto header = readHeader(data);
+	return akc::Span<const uint8>(data + header.size, header.length);
+}
+
+PValue::sint_t MsgPackView::getSInt() const {
+	if (!isSInt()) throw std::logic_error("MsgPackView does not contain a signed integer.");
+	auto data = m_data + m_node->offset;
+	return (data[0] >= 0xE0) ? static_cast<int8>(data[0]) : readSigned(data);
+}
+
+PValue::uint_t MsgPackView::getUInt() const {
+	if (!isUInt()) throw std::logic_error("MsgPackView does not contain an unsigned integer.");
+	auto data = m_data + m_node->offset;
+	if (data[0] <= 0x7F) return data[0];
+	if (data[0] >= 0xD0) return static_cast<uint64>(readSigned(data));
+	return readBigEndian(data + 1, headerSize(data[0]) - 1u);
+}
+
+PValue::dec_t MsgPackView::getDec() const {
+	if (!isDec()) throw std::logic_error("MsgPackView does not contain a floating point number.");
+	auto data = m_data + m_node->offset;
+	if (data[0] == 0xCA) {
+		auto bits = static_cast<uint32>(readBigEndian(data + 1, 4));
+		fpSingle result; std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+	auto bits = readBigEndian(data + 1, 8);
+	fpDouble result; std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+PValue::bool_t MsgPackView::getBool() const {
+	if (!isBool()) throw std::logic_error("MsgPackView does not contain a boolean.");
+	return m_data[m_node->offset] == 0xC3;
+}
+
+PValue MsgPackView::toPValue() const {
+	PValue result;
+	switch(type()) {
+		case PType::Null: break;
+
+		case PType::Object: {
+			auto& obj = result.setObj().getObj();
+			obj.reserve(size());
+			for(akSize i = 0; i < size(); i++) obj.appendUnsorted(std::string(keyAt(i)), valueAt(i).toPValue());
+			obj.sortAppended();
+		} break;
+
+		case PType::Array: {
+			auto& arr = result.setArr().getArr();
+			arr.reserve(size());
+			for(akSize i = 0; i < size(); i++) arr.push_back(child(i).toPValue());
+		} break;
+
+		case PType::String:   result.setStr(std::string(getStr())); break;
+		case PType::Signed:   result.setSInt(getSInt()); break;
+		case PType::Unsigned: result.setUInt(getUInt()); break;
+		case PType::Decimal:  result.setDec(getDec()); break;
+		case PType::Boolean:  result.setBool(getBool()); break;
+		case PType::Binary:   result.setBin(getBin().data(), getBin().size()); break;
+	}
+	return result;
+}
+
+PType MsgPackView::type() const {
+	return m_node ? readHeader(m_data + m_node->offset).type : PType::Null;
+}
+
+akSize MsgPackView::size() const {
+	if (!m_node) return 0;
+	auto header = readHeader(m_data + m_node->offset);
+	return ((header.type == PType::Array) || (header.type == PType::Object)) ? header.length : 0;
+}
+
+// ////////////////// //
+// // MsgPackIndex // //
+// ////////////////// //
+
+bool MsgPackIndex::parse(akc::Span<const uint8> data) {
+	m_storage.clear();
+	m_data = data;
+	return build();
+}
+
+bool MsgPackIndex::parse(std::vector<uint8>&& data) {
+	m_storage = std::move(data);
+	m_data = akc::Span<const uint8>(m_storage.data(), static_cast<akSize>(m_storage.size()));
+	return build();
+}
+
+bool MsgPackIndex::build() {
+	struct Frame final {
+		akSize next;
+		akSize end;
+	};
+
+	m_nodes.clear();
+	if (m_data.empty()) return false;
+
+	// Every node's slot is reserved by its parent, so siblings stay contiguous while their own children are appended
+	std::vector<Frame> frames;
+	m_nodes.push_back(internal::MsgPackNode{0, 0});
+	akSize slot = 0, offset = 0, pending = 0;
+	while(true) {
+		auto remaining = m_data.size() - offset;
+		if (remaining == 0) { clear(); return false; }
+
+		auto size = headerSize(m_data[offset]);
+		if ((size == 0) || (size > remaining)) { clear(); return false; }
+
+		auto header = readHeader(m_data.data() + offset);
+		m_nodes[slot] = internal::MsgPackNode{offset, 0};
+		offset += size;
+
+		if ((header.type == PType::Array) || (header.type == PType::Object)) {
+			// Every reserved entry still needs at least a byte, which bounds the table for malformed counts
+			uint64 count = (header.type == PType::Object) ? uint64(header.length)*2 : header.length;
+			if (count + pending > m_data.size() - offset) { clear(); return false; }
+			auto entries = static_cast<akSize>(count);
+			pending += entries;
+
+			auto first = static_cast<akSize>(m_nodes.size());
+			m_nodes[slot].children = first;
+			m_nodes.resize(m_nodes.size() + entries);
+			if (entries > 0) frames.push_back(Frame{first, first + entries});
+		} else if ((header.type == PType::String) || (header.type == PType::Binary)) {
+			if (header.length > m_data.size() - offset) { clear(); return false; }
+			offset += header.length;
+		}
+
+		while(!frames.empty() && (frames.back().next == frames.back().end)) frames.pop_back();
+		if (frames.empty()) break;
+		slot = frames.back().next++;
+		pending--;
+	}
+
+	return true;
+}
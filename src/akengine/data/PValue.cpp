@@ -205,9 +205,10 @@ PValue& PValue::setNull() {
 	#pragma clang diagnostic push
 	#pragma clang diagnostic ignored "-Wswitch"
 	switch(m_type) {
-		case PType::Object: m_value.oVal.~map(); break;
-		case PType::Array: m_value.aVal.~deque(); break;
+		case PType::Object: m_value.oVal.~obj_t(); break;
+		case PType::Array: m_value.aVal.~arr_t(); break;
 		case PType::String: m_value.sVal.~basic_string(); break;
+		case PType::Binary: m_value.binVal.~bin_t(); break;
 	}
 	#pragma clang diagnostic pop
 	m_type = PType::Null;
@@ -232,23 +233,59 @@ PValue& PValue::setPValue(const PValue& val) {
 	return *this;
 }
 
+void PValue::movePValue(PValue& val) noexcept {
+	switch(val.m_type) {
+		case PType::Null: break;
+
+		case PType::Object: new(&m_value.oVal) obj_t(std::move(val.m_value.oVal)); break;
+		case PType::Array: new(&m_value.aVal) arr_t(std::move(val.m_value.aVal)); break;
+		case PType::String: new(&m_value.sVal) str_t(std::move(val.m_value.sVal)); break;
+
+		case PType::Signed: m_value.iVal = val.m_value.iVal; break;
+		case PType::Unsigned: m_value.uVal = val.m_value.uVal; break;
+		case PType::Decimal: m_value.dVal = val.m_value.dVal; break;
+		case PType::Boolean: m_value.bVal = val.m_value.bVal; break;
+
+		case PType::Binary: new(&m_value.binVal) bin_t(std::move(val.m_value.binVal)); break;
+	}
+	m_type = val.m_type;
+	val.setNull();
+}
+
+// The source may live inside this value (ie. val = val["child"]), so it is taken before the old value is destroyed
+
 PValue& PValue::setObj(const obj_t& val) {
-	if (!isObj()) setNull();
-	new(&m_value.oVal) obj_t(val);
+	return setObj(obj_t(val));
+}
+
+PValue& PValue::setObj(obj_t&& val) {
+	obj_t tmp(std::move(val));
+	setNull();
+	new(&m_value.oVal) obj_t(std::move(tmp));
 	m_type = PType::Object;
 	return *this;
 }
 
 PValue& PValue::setArr(const arr_t& val) {
-	if (!isArr()) setNull();
-	new(&m_value.aVal) arr_t(val);
+	return setArr(arr_t(val));
+}
+
+PValue& PValue::setArr(arr_t&& val) {
+	arr_t tmp(std::move(val));
+	setNull();
+	new(&m_value.aVal) arr_t(std::move(tmp));
 	m_type = PType::Array;
 	return *this;
 }
 
 PValue& PValue::setStr(const str_t& val) {
-	if (!isStr()) setNull();
-	new(&m_value.sVal) std::string(val);
+	return setStr(str_t(val));
+}
+
+PValue& PValue::setStr(str_t&& val) {
+	str_t tmp(std::move(val));
+	setNull();
+	new(&m_value.sVal) str_t(std::move(tmp));
 	m_type = PType::String;
 	return *this;
 }
@@ -268,7 +305,7 @@ PValue& PValue::setUInt(const uint_t& val) {
 }
 
 PValue& PValue::setDec(const dec_t& val) {
-	if (!isUInt()) setNull();
+	if (!isDec()) setNull();
 	m_value.dVal = val;
 	m_type = PType::Decimal;
 	return *this;
@@ -282,8 +319,13 @@ PValue& PValue::setBool(const bool_t& val) {
 }
 
 PValue& PValue::setBin(const bin_t& val) {
-	if (!isBin()) setNull();
-	new(&m_value.binVal) bin_t(val);
+	return setBin(bin_t(val));
+}
+
+PValue& PValue::setBin(bin_t&& val) {
+	bin_t tmp(std::move(val));
+	setNull();
+	new(&m_value.binVal) bin_t(std::move(tmp));
 	m_type = PType::Binary;
 	return *this;
 }
@@ -14,11 +14,115 @@
  * limitations under the License.
  **/
 
+#include <akengine/data/Hash.hpp>
 #include <akengine/data/Serialize.hpp>
 #include <akengine/debug/Log.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace akd;
+
+// Blob header: magic, version, byte order, element alignment, element size, element count, layout fingerprint
+// Header fields are always little endian, the elements are in the writer's byte order
+static constexpr uint8 POD_BLOB_MAGIC[4] = {'A', 'K', 'P', 'D'};
+static constexpr uint8 POD_BLOB_VERSION = 2;
+static constexpr akSize POD_BLOB_HEADER_SIZE = 24;
+
+static constexpr uint8 POD_BLOB_LITTLE_ENDIAN = 0;
+static constexpr uint8 POD_BLOB_BIG_ENDIAN = 1;
+
+static uint8 nativeByteOrder() {
+	const uint16 probe = 1;
+	uint8 firstByte; std::memcpy(&firstByte, &probe, 1);
+	return firstByte == 1 ? POD_BLOB_LITTLE_ENDIAN : POD_BLOB_BIG_ENDIAN;
+}
+
+static void writeLE(uint8* dst, uint64 val, akSize size) {
+	for(akSize i = 0; i < size; i++) dst[i] = static_cast<uint8>(val >> (i*8));
+}
+
+static uint64 readLE(const uint8* src, akSize size) {
+	uint64 result = 0;
+	for(akSize i = 0; i < size; i++) result |= static_cast<uint64>(src[i]) << (i*8);
+	return result;
+}
 
 void akd::internal::logError(const std::string& name, const std::string& message) {
 	akl::Logger(name).error(message);
 }
 
+void akd::internal::finishPODLayout(PODLayout& layout, akSize elementSize) {
+	auto& spans = layout.spans;
+	std::sort(spans.begin(), spans.end(), [](const auto& a, const auto& b){ return a.offset < b.offset; });
+
+	std::vector<PODLayout::Span> merged;
+	for(const auto& span : spans) {
+		if (!merged.empty() && (merged.back().offset + merged.back().size >= span.offset)) {
+			merged.back().size = std::max(merged.back().size, span.offset + span.size - merged.back().offset);
+		} else {
+			merged.push_back(span);
+		}
+	}
+	spans = std::move(merged);
+
+	layout.padded = (spans.size() != 1) || (spans.front().offset != 0) || (spans.front().size != elementSize);
+	layout.fingerprint = hash64FNV1A(layout.description.data(), static_cast<akSize>(layout.description.size()));
+}
+
+uint8* akd::internal::startPODBlob(PValue::bin_t& dst, akSize elementSize, akSize elementAlign, uint64 fingerprint, size_t count) {
+	// Blob sizes are stored and streamed as 32-bit
+	if (count > (std::numeric_limits<akSize>::max() - POD_BLOB_HEADER_SIZE)/elementSize) throw std::length_error(akc::buildString("Too many elements for a POD blob: ", count));
+
+	dst.resize(POD_BLOB_HEADER_SIZE + elementSize*count);
+	auto header = dst.data();
+	std::memcpy(header, POD_BLOB_MAGIC, sizeof(POD_BLOB_MAGIC));
+	header[4] = POD_BLOB_VERSION;
+	header[5] = nativeByteOrder();
+	writeLE(header +  6, elementAlign, 2);
+	writeLE(header +  8, elementSize,  4);
+	writeLE(header + 12, count,        4);
+	writeLE(header + 16, fingerprint,  8);
+	return header + POD_BLOB_HEADER_SIZE;
+}
+
+const uint8* akd::internal::checkPODBlob(const uint8* data, akSize size, akSize elementSize, akSize elementAlign, uint64 fingerprint, akSize& count) {
+	if ((size < POD_BLOB_HEADER_SIZE) || (std::memcmp(data, POD_BLOB_MAGIC, sizeof(POD_BLOB_MAGIC)) != 0)) {
+		logError("Serialize", "Binary data is not a POD blob.");
+		return nullptr;
+	}
+
+	if (data[4] != POD_BLOB_VERSION) {
+		logError("Serialize", "Unsupported POD blob version: ", static_cast<uint32>(data[4]));
+		return nullptr;
+	}
+
+	if (data[5] != nativeByteOrder()) {
+		logError("Serialize", "POD blob was written with a different byte order.");
+		return nullptr;
+	}
+
+	auto blobAlign = static_cast<akSize>(readLE(data + 6, 2));
+	auto blobSize  = static_cast<akSize>(readLE(data + 8, 4));
+	if ((blobAlign != elementAlign) || (blobSize != elementSize)) {
+		logError("Serialize", "POD blob layout mismatch. Expected size/align ", elementSize, "/", elementAlign, ", got ", blobSize, "/", blobAlign);
+		return nullptr;
+	}
+
+	// Catches fields that were renamed, reordered or retyped without changing the element size
+	if (readLE(data + 16, 8) != fingerprint) {
+		logError("Serialize", "POD blob layout mismatch. The element's fields have changed since it was written.");
+		return nullptr;
+	}
+
+	count = static_cast<akSize>(readLE(data + 12, 4));
+	if ((size - POD_BLOB_HEADER_SIZE)/elementSize < count) {
+		logError("Serialize", "POD blob is truncated.");
+		return nullptr;
+	}
+
+	return data + POD_BLOB_HEADER_SIZE;
+}
+
 
@@ -0,0 +1,106 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/data/Stream.hpp>
+#include <string>
+#include <string_view>
+
+using namespace akd;
+
+void Reader::skip() {
+	switch(peek()) {
+		case PType::Null:     readNull(); break;
+		case PType::Boolean:  readBool(); break;
+		case PType::Signed:   readSInt(); break;
+		case PType::Unsigned: readUInt(); break;
+		case PType::Decimal:  readDec();  break;
+		case PType::String:   readStr();  break;
+		case PType::Binary:   readBin();  break;
+
+		case PType::Array: {
+			startArray();
+			while(nextElement()) skip();
+		} break;
+
+		case PType::Object: {
+			startObject();
+			std::string_view key;
+			while(nextKey(key)) skip();
+		} break;
+	}
+}
+
+void akd::write(Writer& writer, const PValue& src) {
+	switch(src.type()) {
+		case PType::Null:     writer.writeNull(); break;
+		case PType::Boolean:  writer.writeBool(src.getBool()); break;
+		case PType::Signed:   writer.writeSInt(src.getSInt()); break;
+		case PType::Unsigned: writer.writeUInt(src.getUInt()); break;
+		case PType::Decimal:  writer.writeDec(src.getDec()); break;
+		case PType::String:   writer.writeStr(src.getStr()); break;
+		case PType::Binary:   writer.writeBin(src.getBin().data(), static_cast<akSize>(src.getBin().size())); break;
+
+		case PType::Array: {
+			writer.startArray(static_cast<akSize>(src.getArr().size()));
+			for(const auto& entry : src.getArr()) write(writer, entry);
+			writer.endArray();
+		} break;
+
+		case PType::Object: {
+			writer.startObject(static_cast<akSize>(src.getObj().size()));
+			for(const auto& entry : src.getObj()) {
+				writer.writeKey(entry.first);
+				write(writer, entry.second);
+			}
+			writer.endObject();
+		} break;
+	}
+}
+
+bool akd::read(Reader& reader, PValue& dst) {
+	switch(reader.peek()) {
+		case PType::Null:     reader.readNull(); dst.setNull(); break;
+		case PType::Boolean:  dst.setBool(reader.readBool()); break;
+		case PType::Signed:   dst.setSInt(reader.readSInt()); break;
+		case PType::Unsigned: dst.setUInt(reader.readUInt()); break;
+		case PType::Decimal:  dst.setDec(reader.readDec()); break;
+		case PType::String:   dst.setStr(std::string(reader.readStr())); break;
+		case PType::Binary:   { auto data = reader.readBin(); dst.setBin(data.data(), data.size()); } break;
+
+		case PType::Array: {
+			PValue::arr_t result;
+			result.reserve(internal::reserveHint(reader.startArray()));
+			while(reader.nextElement()) {
+				result.emplace_back();
+				read(reader, result.back());
+			}
+			dst.setArr(std::move(result));
+		} break;
+
+		case PType::Object: {
+			PValue::obj_t result;
+			result.reserve(internal::reserveHint(reader.startObject()));
+			std::string_view key;
+			while(reader.nextKey(key)) {
+				PValue val; std::string keyStr(key); // Key is invalidated by the value's read
+				read(reader, val);
+				result.try_emplace(std::move(keyStr), std::move(val));
+			}
+			dst.setObj(std::move(result));
+		} break;
+	}
+	return true;
+}
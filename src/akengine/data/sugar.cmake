@@ -12,9 +12,12 @@ include_guard(GLOBAL)
 
 sugar_files(AK_ENGINE_SOURCE 
 	Brotli.cpp 
+	Document.cpp 
 	Json.cpp 
 	MsgPack.cpp 
+	MsgPackView.cpp 
 	PValue.cpp 
 	PVPath.cpp 
 	Serialize.cpp 
+	Stream.cpp 
 )
@@ -16,39 +16,209 @@
 
 #include <akcommon/ScopeGuard.hpp>
 #include <akengine/debug/Log.hpp>
+#include <akengine/debug/LogSink.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
 #include <akengine/Config.hpp>
 #include <akengine/event/Dispatcher.hpp>
 #include <akengine/event/Event.hpp>
-#include <akengine/filesystem/CFile.hpp>
+#include <akengine/metrics/Metrics.hpp>
+#include <akengine/thread/ByteRing.hpp>
 #include <akengine/thread/DoubleBuffer.hpp>
 #include <akengine/thread/Spinlock.hpp>
 #include <akengine/thread/Thread.hpp>
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <utility>
+#include <vector>
 
 using namespace akl;
 
 static akt::Thread loggingThread("Log");
 
-static akt::Spinlock messageQueueProcessLock;
-static akt::DoubleBuffer<std::pair<Level, std::string>> logMessageBuffer;
+static akt::Spinlock messageQueueProcessLock("Log::Process");
+static akt::DoubleBuffer<internal::Record> logMessageBuffer;
 static Level consoleFilterLevel = Level::Debug;
 static Level fileFilterLevel = Level::Debug;
 
 static std::atomic<bool> isRedirrectingStd = false;
 
-static akt::Spinlock logFileLock;
-static akfs::CFile logFile;
+static akt::Spinlock logFileLock("Log::File");
+static akl::FileSink logFile("data/logs/log_", ".txt");
+static akl::FileSink jsonFile("data/logs/log_", ".jsonl");
+
+static std::string consoleBuffer;
+static std::string textBuffer;
+static std::string jsonBuffer;
+
+static std::atomic<bool> deferredFormatting = true;
+static constexpr akSize DEFERRED_RING_SIZE = 256*1024;
+
+namespace {
+	struct DeferredRing final {
+		akt::ByteRing ring;
+		uint64 threadID;
+		std::string threadName;
+		std::atomic<bool> orphaned;
+
+		DeferredRing(uint64 id, const std::string& name) : ring(DEFERRED_RING_SIZE), threadID(id), threadName(name), orphaned(false) {}
+	};
+
+	/// Owned by the producing thread, marks the ring for removal once the thread exits and it has been drained
+	struct DeferredRingHandle final {
+		std::shared_ptr<DeferredRing> ring;
+		~DeferredRingHandle() { if (ring) ring->orphaned = true; }
+	};
+
+}
+
+static akt::Spinlock& deferredRingsLock() { static akt::Spinlock instance("Log::DeferredRings"); return instance; }
+static std::vector<std::shared_ptr<DeferredRing>>& deferredRings() { static std::vector<std::shared_ptr<DeferredRing>> instance; return instance; }
+
+static DeferredRing& deferredRing() {
+	thread_local DeferredRingHandle handle;
+	if (!handle.ring) {
+		handle.ring = std::make_shared<DeferredRing>(akt::current().id(), akt::current().name());
+		auto lock = deferredRingsLock().lock();
+		deferredRings().push_back(handle.ring);
+	}
+	return *handle.ring;
+}
+
+static void drainDeferredMessages(std::vector<internal::Record>& records) {
+	// Deferred records only carry a steady timestamp, wall time is reconstructed from the current clock offset
+	auto wallOffset = internal::wallTimeNS() - internal::monotonicTimeNS();
+
+	auto lock = deferredRingsLock().lock();
+	auto& rings = deferredRings();
+	for(auto iter = rings.begin(); iter != rings.end();) {
+		auto& entry = **iter;
+		bool orphaned = entry.orphaned;
+
+		entry.ring.drain([&](const uint8* data, akSize /*size*/) {
+			internal::DeferredHeader header;
+			std::memcpy(&header, data, sizeof(internal::DeferredHeader));
+			std::string_view logName(reinterpret_cast<const char*>(data + sizeof(internal::DeferredHeader)), header.nameLength);
+
+			internal::MessageBuilder builder;
+			header.format(builder, data + sizeof(internal::DeferredHeader) + header.nameLength);
+
+			records.push_back(internal::Record{header.level, header.timestamp + wallOffset, header.timestamp, header.sequence, entry.threadID, entry.threadName, std::string(logName), builder.message.str(), std::move(builder.fields)});
+		});
+
+		// The owning thread has exited, nothing more can be written
+		if (orphaned) iter = rings.erase(iter);
+		else iter++;
+	}
+}
+
+/// Orders by time, a thread's records with the same timestamp keep the order they were logged in
+static bool isRecordBefore(const internal::Record& lhs, const internal::Record& rhs) {
+	if (lhs.monotonicTime != rhs.monotonicTime) return lhs.monotonicTime < rhs.monotonicTime;
+	if (lhs.threadID != rhs.threadID) return lhs.threadID < rhs.threadID;
+	return lhs.sequence < rhs.sequence;
+}
+
+// //////////////// //
+// // Formatting // //
+// //////////////// //
+
+static void writeText(std::string& out, const internal::Record& record) {
+	if (record.level == Level::Raw) { out.append(record.message); return; }
+
+	auto time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(record.wallTime)));
+	auto utc = akc::utcTimestamp(time);
+
+	std::stringstream sstream;
+	sstream << "[" << std::put_time(&utc.ctime, "%H:%M:%S");
+	sstream << "." << std::setfill('0') << std::setw(3) << utc.milliseconds;
+	sstream << "][" << record.threadName << "][" << record.logName << "][" << Logger::LevelTags[static_cast<uint8>(record.level)] << "]";
+	if (record.message.empty() || (record.message.front() != '[')) sstream << " ";
+	sstream << record.message;
+	for(const auto& field : record.fields) sstream << " " << field.key << "=" << field.value;
+	sstream << "\n";
+
+	out.append(sstream.str());
+}
+
+static void appendJsonString(std::string& out, const std::string_view& str) {
+	static constexpr char HEX[] = "0123456789abcdef";
+	out.push_back('"');
+	for(char c : str) {
+		switch(c) {
+			case '"':  out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\n': out.append("\\n"); break;
+			case '\r': out.append("\\r"); break;
+			case '\t': out.append("\\t"); break;
+			default:
+				if (static_cast<uint8>(c) < 0x20) {
+					out.append("\\u00");
+					out.push_back(HEX[static_cast<uint8>(c) >> 4]);
+					out.push_back(HEX[static_cast<uint8>(c) & 0xF]);
+				} else {
+					out.push_back(c);
+				}
+		}
+	}
+	out.push_back('"');
+}
+
+static void appendJsonKey(std::string& out, const std::string_view& key) {
+	if (out.back() != '{') out.push_back(',');
+	appendJsonString(out, key);
+	out.push_back(':');
+}
+
+static void writeJson(std::string& out, const internal::Record& record) {
+	auto time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(record.wallTime)));
+	auto utc = akc::utcTimestamp(time);
+	char timeStr[32];
+	auto timeLength = std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S", &utc.ctime);
+	auto nanoseconds = static_cast<uint32>(((record.wallTime % 1000000000) + 1000000000) % 1000000000);
+	timeLength += static_cast<std::size_t>(std::snprintf(timeStr + timeLength, sizeof(timeStr) - timeLength, ".%09uZ", nanoseconds));
+
+	out.push_back('{');
+	appendJsonKey(out, "level");
+	appendJsonString(out, record.level == Level::Raw ? std::string_view("RAW") : Logger::LevelTags[static_cast<uint8>(record.level)]);
+	appendJsonKey(out, "time");     appendJsonString(out, std::string_view(timeStr, timeLength));
+	appendJsonKey(out, "wallNS");   out.append(std::to_string(record.wallTime));
+	appendJsonKey(out, "monoNS");   out.append(std::to_string(record.monotonicTime));
+	appendJsonKey(out, "threadID"); out.append(std::to_string(record.threadID));
+	appendJsonKey(out, "thread");   appendJsonString(out, record.threadName);
+	appendJsonKey(out, "logger");   appendJsonString(out, record.logName);
+	appendJsonKey(out, "message");  appendJsonString(out, record.message);
+
+	if (!record.fields.empty()) {
+		appendJsonKey(out, "fields");
+		out.push_back('{');
+		for(const auto& field : record.fields) {
+			appendJsonKey(out, field.key);
+			if (field.literal) out.append(field.value);
+			else appendJsonString(out, field.value);
+		}
+		out.push_back('}');
+	}
+
+	out.append("}\n");
+}
 
 bool akl::startProcessing(uint64 delayUS) {
 	if (loggingThread.isRunning()) return false;
 
 	loggingThread.execute([=]{
+		akt::current().scheduleEvery(static_cast<int64>(delayUS), processMessageQueue);
 		while(!akt::current().isCloseRequested()) {
-			processMessageQueue();
-			akt::current().sleep(delayUS);
+			akt::current().update();
+			akt::current().park();
 		}
 	});
 
@@ -59,6 +229,8 @@ bool akl::stopProcessing() {
 	if (!loggingThread.isRunning()) return false;
 	loggingThread.requestClose();
 	loggingThread.join();
+	flush();
+	stopSinkCompression();
 	return true;
 }
 
@@ -68,50 +240,96 @@ bool akl::isProcessing() {
 
 
 void akl::processMessageQueue() {
+	AK_PROFILE_SCOPE("Log::processMessageQueue");
+	AK_MEMORY_TAG("Log");
+	static const std::array<akmet::Counter*, 7> levelMetrics = []{
+		std::array<akmet::Counter*, 7> result;
+		for(uint8 i = 0; i < result.size(); i++) result[i] = &akmet::counter("log.records", {{"level", se_internal::convertLevelToString(static_cast<Level>(i))}});
+		return result;
+	}();
+
+	static std::vector<internal::Record> records;
+
 	auto processLock = messageQueueProcessLock.lock();
+	records.clear();
 
+	// Immediate records are taken before the rings are drained, so any deferred record logged before one of them is written in the same pass or an earlier one
 	logMessageBuffer.swap();
-	logMessageBuffer.iterate([&](akSize, const std::pair<Level, std::string>& record){
-		if (isConsoleFilterLevelEnabled(record.first)) {
-			if (isRedirrectingStd) {
-				//@todo Implement
-			} else {
-				std::cout << record.second << std::flush;
-			}
+	logMessageBuffer.iterate([&](akSize, internal::Record& record){ records.push_back(std::move(record)); });
+	drainDeferredMessages(records);
+	std::sort(records.begin(), records.end(), isRecordBefore);
+
+	auto fileLock = logFileLock.lock();
+	for(const auto& record : records) {
+		levelMetrics[std::min<akSize>(static_cast<uint8>(record.level), levelMetrics.size() - 1)]->add();
+
+		bool toConsole = isConsoleFilterLevelEnabled(record.level) && !isRedirrectingStd;
+		bool toFile = isFileFilterLevelEnabled(record.level);
+
+		if (toConsole || (toFile && logFile.isOpen())) {
+			textBuffer.clear();
+			writeText(textBuffer, record);
+			if (toConsole) consoleBuffer.append(textBuffer);
+			if (toFile) logFile.write(textBuffer);
 		}
 
-		if (!isFileFilterLevelEnabled(record.first)) return;
+		if (toFile && jsonFile.isOpen()) {
+			jsonBuffer.clear();
+			writeJson(jsonBuffer, record);
+			jsonFile.write(jsonBuffer);
+		}
 
-		auto scopeLock = logFileLock.lock();
-		if (logFile) {
-			logFile.write(record.second.c_str(), record.second.size());
+		if (toFile && (record.level == Level::Fatal)) {
 			logFile.flush();
+			jsonFile.flush();
 		}
-	});
+	}
+	logFile.update();
+	jsonFile.update();
+
+	if (!consoleBuffer.empty()) {
+		std::cout.write(consoleBuffer.data(), static_cast<std::streamsize>(consoleBuffer.size())) << std::flush;
+		consoleBuffer.clear();
+	}
 }
 
+void akl::flush() {
+	processMessageQueue();
+	processMessageQueue();
 
-bool akl::enableFileOutput() {
 	auto fileLock = logFileLock.lock();
+	logFile.flush();
+	jsonFile.flush();
+}
 
-	auto utc = akc::utcTimestamp();
-	std::stringstream filename;
-	filename << "data/logs/log_" << std::put_time(&utc.ctime, "%Y%m%d_%H%M%S") << ".txt";
-
-	auto newLogFile = akfs::CFile(filename.str(), akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
-	if (!newLogFile) return false;
-	logFile = std::move(newLogFile);
 
-	return true;
+bool akl::enableFileOutput() {
+	auto fileLock = logFileLock.lock();
+	return logFile.open();
 }
 
 void akl::disableFileOutput() {
 	auto fileLock = logFileLock.lock();
-	logFile = akfs::CFile();
+	logFile.close();
+}
+
+bool akl::enableJsonOutput() {
+	auto fileLock = logFileLock.lock();
+	return jsonFile.isOpen() || jsonFile.open();
+}
+
+void akl::disableJsonOutput() {
+	auto fileLock = logFileLock.lock();
+	jsonFile.close();
+}
+
+static void updateEnabledLevel() {
+	internal::enabledLevel = std::max(static_cast<uint8>(consoleFilterLevel), static_cast<uint8>(fileFilterLevel));
 }
 
 void akl::setConsoleLevel(Level logLevel) {
 	consoleFilterLevel = logLevel;
+	updateEnabledLevel();
 }
 
 bool akl::isConsoleFilterLevelEnabled(Level logLevel) {
@@ -125,6 +343,7 @@ Level akl::getConsoleFilterLevel() {
 
 void akl::setFileLevel(Level logLevel) {
 	fileFilterLevel = logLevel;
+	updateEnabledLevel();
 }
 
 bool akl::isFileFilterLevelEnabled(Level logLevel) {
@@ -135,8 +354,12 @@ Level akl::getFileFilterLevel() {
 	return fileFilterLevel;
 }
 
-bool akl::isFilterLevelEnabled(Level logLevel) {
-	return isFileFilterLevelEnabled(logLevel) || isConsoleFilterLevelEnabled(logLevel);
+void akl::setDeferredFormatting(bool enabled) {
+	deferredFormatting = enabled;
+}
+
+bool akl::isDeferredFormatting() {
+	return deferredFormatting.load(std::memory_order_relaxed);
 }
 
 void akl::captureStandardStreams() {
@@ -150,18 +373,63 @@ void akl::restoreStandardStreams() {
 
 
 void akl::internal::printMessage(Level logLevel, const std::string& str) {
-	logMessageBuffer.push_back(std::make_pair(logLevel, str));
+	auto& thread = akt::current();
+	logMessageBuffer.push_back(Record{logLevel, wallTimeNS(), monotonicTimeNS(), nextSequence(), thread.id(), thread.name(), std::string(), str, {}});
+}
+
+void akl::internal::printRecord(Record&& record) {
+	logMessageBuffer.push_back(std::move(record));
+}
+
+uint8* akl::internal::reserveDeferred(akSize size) {
+	static akmet::Counter& fallbackMetric = akmet::counter("log.deferredFallbacks");
+	auto result = deferredRing().ring.reserve(size);
+	if (!result) fallbackMetric.add(); // Formatted on the calling thread instead
+	return result;
+}
+
+void akl::internal::commitDeferred() {
+	deferredRing().ring.commit();
 }
 
 static akev::SubscriberID logSInitRegenerateConfigHook = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& event){
 	akd::serialize(event.data()["log"]["consoleLevel"], akl::Level::Debug);
 	akd::serialize(event.data()["log"]["fileLevel"],   akl::Level::Debug);
+	akd::serialize(event.data()["log"]["deferred"],    true);
+	akd::serialize(event.data()["log"]["json"],        false);
+
+	akl::FileSinkConfig fileConfig;
+	akd::serialize(event.data()["log"]["file"]["bufferSize"],      fileConfig.bufferSize);
+	akd::serialize(event.data()["log"]["file"]["flushIntervalMS"], fileConfig.flushIntervalMS);
+	akd::serialize(event.data()["log"]["file"]["rotateSize"],      fileConfig.rotateSize);
+	akd::serialize(event.data()["log"]["file"]["rotateMinutes"],   fileConfig.rotateMinutes);
+	akd::serialize(event.data()["log"]["file"]["compressRotated"], fileConfig.compressRotated);
 });
 
 static akev::SubscriberID logSInitRegisterConfigHooks = ake::setConfigDispatch().subscribe([](ake::SetConfigEvent& event) {
 	akl::Level tmp;
 	if (akd::deserialize(tmp, event.data().atOrDef("log").atOrDef("consoleLevel"))) setConsoleLevel(tmp);
 	if (akd::deserialize(tmp, event.data().atOrDef("log").atOrDef("fileLevel"))) setFileLevel(tmp);
+
+	bool deferred;
+	if (akd::deserialize(deferred, event.data().atOrDef("log").atOrDef("deferred"))) setDeferredFormatting(deferred);
+
+	bool json;
+	if (akd::deserialize(json, event.data().atOrDef("log").atOrDef("json"))) {
+		if (json) enableJsonOutput();
+		else disableJsonOutput();
+	}
+
+	auto fileLock = logFileLock.lock();
+	auto fileConfig = logFile.config();
+	auto fileData = event.data().atOrDef("log").atOrDef("file");
+	akd::deserialize(fileConfig.bufferSize,      fileData.atOrDef("bufferSize"));
+	akd::deserialize(fileConfig.flushIntervalMS, fileData.atOrDef("flushIntervalMS"));
+	akd::deserialize(fileConfig.rotateSize,      fileData.atOrDef("rotateSize"));
+	akd::deserialize(fileConfig.rotateMinutes,   fileData.atOrDef("rotateMinutes"));
+	akd::deserialize(fileConfig.compressRotated, fileData.atOrDef("compressRotated"));
+	logFile.setConfig(fileConfig);
+	jsonFile.setConfig(fileConfig);
 });
 
 
@@ -0,0 +1,173 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akcommon/Time.hpp>
+#include <akengine/data/Brotli.hpp>
+#include <akengine/debug/LogSink.hpp>
+#include <akengine/filesystem/Filesystem.hpp>
+#include <akengine/thread/CurrentThread.hpp>
+#include <akengine/thread/Thread.hpp>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace akl;
+
+static constexpr uint8 ROTATED_COMPRESSION_LEVEL = 9;
+
+static akt::Thread& compressionThread() {
+	static akt::Thread instance("Log::Compress");
+	return instance;
+}
+
+static void compressFile(const akfs::Path& path) {
+	try {
+		std::vector<uint8> data;
+		/* Read */ {
+			akfs::CFile inFile(path, akfs::OpenFlags::In);
+			if (!inFile) return;
+			inFile.readAll(data);
+		}
+
+		auto compressed = akd::compressBrotli(data, ROTATED_COMPRESSION_LEVEL);
+
+		akfs::Path outPath(path.str() + ".br");
+		akfs::CFile outFile(outPath, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+		if (!outFile) return;
+		if (outFile.write(compressed.data(), compressed.size()) != compressed.size()) {
+			outFile = akfs::CFile();
+			akfs::remove(outPath);
+			return;
+		}
+		outFile = akfs::CFile();
+
+		akfs::remove(path);
+	} catch(const std::exception&) {
+		// Keep the uncompressed file, logging from here could recurse into the sink
+	}
+}
+
+static void scheduleCompression(const akfs::Path& path) {
+	auto& thread = compressionThread();
+	if (!thread.isRunning()) {
+		thread.execute([]{
+			while(!akt::current().isCloseRequested()) {
+				akt::current().update();
+				akt::current().park();
+			}
+			akt::current().update();
+		});
+	}
+	thread.schedule(std::function<void()>([path]{ compressFile(path); }));
+}
+
+void akl::stopSinkCompression() {
+	auto& thread = compressionThread();
+	if (!thread.isRunning()) return;
+	thread.requestClose();
+	thread.join();
+}
+
+FileSink::FileSink(const std::string& prefix, const std::string& extension)
+	: m_prefix(prefix), m_extension(extension), m_config(), m_file(), m_path(), m_buffer(), m_fileSize(0), m_lastFlush(), m_openTime() {}
+
+FileSink::~FileSink() {
+	close();
+}
+
+bool FileSink::open() {
+	close();
+	return openNext();
+}
+
+bool FileSink::openNext() {
+	auto utc = akc::utcTimestamp();
+	std::stringstream baseName;
+	baseName << m_prefix << std::put_time(&utc.ctime, "%Y%m%d_%H%M%S");
+
+	// Rotation can happen more than once a second
+	akfs::Path path(baseName.str() + m_extension);
+	for(uint32 i = 1; akfs::exists(path) || akfs::exists(akfs::Path(path.str() + ".br")); i++) {
+		path = akfs::Path(baseName.str() + "_" + std::to_string(i) + m_extension);
+	}
+
+	auto newFile = akfs::CFile(path, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+	if (!newFile) return false;
+
+	close();
+	m_file = std::move(newFile);
+	m_path = path;
+	m_buffer.reserve(m_config.bufferSize);
+	m_fileSize = 0;
+	m_openTime = m_lastFlush = std::chrono::steady_clock::now();
+	return true;
+}
+
+void FileSink::close() {
+	if (!m_file) return;
+	flush();
+	m_file = akfs::CFile();
+}
+
+void FileSink::write(const std::string_view& data) {
+	if (!m_file) return;
+	m_buffer.append(data.data(), data.size());
+
+	if ((m_buffer.size() >= m_config.bufferSize) || (std::chrono::steady_clock::now() - m_lastFlush >= std::chrono::milliseconds(m_config.flushIntervalMS))) flush();
+	if ((m_config.rotateSize > 0) && (m_fileSize >= m_config.rotateSize)) rotate();
+}
+
+void FileSink::update() {
+	if (!m_file) return;
+	auto now = std::chrono::steady_clock::now();
+
+	if (!m_buffer.empty() && (now - m_lastFlush >= std::chrono::milliseconds(m_config.flushIntervalMS))) flush();
+	if ((m_config.rotateMinutes > 0) && (m_fileSize > 0) && (now - m_openTime >= std::chrono::minutes(m_config.rotateMinutes))) rotate();
+}
+
+bool FileSink::flush() {
+	if (!m_file) return false;
+	m_lastFlush = std::chrono::steady_clock::now();
+	if (m_buffer.empty()) return true;
+
+	auto written = m_file.write(m_buffer.data(), m_buffer.size());
+	m_fileSize += written;
+	m_buffer.clear();
+
+	return m_file.flush() && (written > 0);
+}
+
+void FileSink::setConfig(const FileSinkConfig& config) {
+	m_config = config;
+	if (m_buffer.size() >= m_config.bufferSize) flush();
+}
+
+bool FileSink::rotate() {
+	flush();
+	auto oldPath = m_path;
+	bool compress = m_config.compressRotated;
+
+	if (!openNext()) {
+		// Logging from here would recurse into the sink. Keep the current file and wait until the next rotation is due to retry.
+		std::cerr << "Log: Failed to open a new log file, continuing to write to " << oldPath.str() << std::endl;
+		m_fileSize = 0;
+		m_openTime = std::chrono::steady_clock::now();
+		return false;
+	}
+	if (compress) scheduleCompression(oldPath);
+	return true;
+}
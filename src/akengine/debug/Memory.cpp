@@ -0,0 +1,286 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/debug/Log.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <utility>
+
+using namespace akmem;
+
+static constexpr akl::Logger log(AK_STRING_VIEW("Memory"));
+
+static constexpr int64  FLUSH_BYTES = 64*1024;
+static constexpr uint32 FLUSH_OPERATIONS = 1024;
+
+// Nothing here may allocate, it runs inside operator new
+namespace {
+	struct GlobalTag final {
+		std::atomic<const char*> name{nullptr};
+		std::atomic<int64> live{0};
+		std::atomic<int64> peak{0};
+		std::atomic<uint64> allocations{0};
+		std::atomic<uint64> frees{0};
+		std::atomic<uint64> allocatedBytes{0};
+
+		// Guarded by frameLock
+		uint64 lastAllocations = 0;
+		uint64 lastAllocatedBytes = 0;
+		uint64 frameAllocations = 0;
+		uint64 frameAllocatedBytes = 0;
+	};
+
+	/// Per-thread changes not yet added to the global counters
+	struct LocalTag final {
+		int64 live;
+		uint64 allocations;
+		uint64 frees;
+		uint64 allocatedBytes;
+		uint32 operations;
+	};
+
+	struct LocalState final {
+		std::array<LocalTag, MAX_TAGS> tags;
+
+		/// Publishes the pending counts so threads that exit early don't leave the totals short.
+		/// Registering it uses calloc rather than operator new, so the state can still be created inside operator new.
+		~LocalState();
+	};
+}
+
+static std::array<GlobalTag, MAX_TAGS> globalTags;
+static std::atomic<uint32> tagCount{1};
+static std::mutex registerLock;
+static std::mutex frameLock;
+
+static thread_local LocalState localState;
+
+// Trivially destructible, so both stay readable after localState is destroyed
+static thread_local TagID localTag = UNTAGGED;
+static thread_local bool localExited = false; /// Set once localState is destroyed, later counts are published immediately
+
+static void flushTag(TagID tag, LocalTag& local) {
+	auto& global = globalTags[tag];
+	auto live = global.live.fetch_add(local.live, std::memory_order_relaxed) + local.live;
+	global.allocations.fetch_add(local.allocations, std::memory_order_relaxed);
+	global.frees.fetch_add(local.frees, std::memory_order_relaxed);
+	global.allocatedBytes.fetch_add(local.allocatedBytes, std::memory_order_relaxed);
+
+	auto peak = global.peak.load(std::memory_order_relaxed);
+	while((live > peak) && !global.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+
+	local = LocalTag{};
+}
+
+LocalState::~LocalState() {
+	for(akSize i = 0; i < MAX_TAGS; i++) if (tags[i].operations > 0) flushTag(static_cast<TagID>(i), tags[i]);
+	localExited = true;
+}
+
+[[maybe_unused]] static void countAllocation(TagID tag, std::size_t size) {
+	if (localExited) {
+		LocalTag late{static_cast<int64>(size), 1, 0, size, 1};
+		flushTag(tag, late);
+		return;
+	}
+
+	auto& local = localState.tags[tag];
+	local.live += static_cast<int64>(size);
+	local.allocations++;
+	local.allocatedBytes += size;
+	if ((++local.operations >= FLUSH_OPERATIONS) || (local.live >= FLUSH_BYTES)) flushTag(tag, local);
+}
+
+[[maybe_unused]] static void countFree(TagID tag, std::size_t size) {
+	if (localExited) {
+		LocalTag late{-static_cast<int64>(size), 0, 1, 0, 1};
+		flushTag(tag, late);
+		return;
+	}
+
+	auto& local = localState.tags[tag];
+	local.live -= static_cast<int64>(size);
+	local.frees++;
+	if ((++local.operations >= FLUSH_OPERATIONS) || (local.live <= -FLUSH_BYTES)) flushTag(tag, local);
+}
+
+TagID akmem::internal::swapTag(TagID tag) {
+	return std::exchange(localTag, tag);
+}
+
+TagID akmem::registerTag(const char* name) {
+	std::lock_guard<std::mutex> lock(registerLock);
+
+	auto count = tagCount.load(std::memory_order_relaxed);
+	for(uint32 i = 1; i < count; i++) {
+		auto existing = globalTags[i].name.load(std::memory_order_relaxed);
+		if ((existing == name) || (std::string_view(existing) == name)) return static_cast<TagID>(i);
+	}
+
+	if (count >= MAX_TAGS) return UNTAGGED;
+	globalTags[count].name.store(name, std::memory_order_relaxed);
+	tagCount.store(count + 1, std::memory_order_release);
+	return static_cast<TagID>(count);
+}
+
+bool akmem::isTracking() {
+#	ifdef AK_MEMORY_TRACKING
+		return true;
+#	else
+		return false;
+#	endif
+}
+
+std::vector<TagStats> akmem::tagStats() {
+	if (!isTracking()) return {};
+
+	// Include what this thread hasn't published yet, other threads catch up on their next flush
+	if (!localExited) for(akSize i = 0; i < MAX_TAGS; i++) if (localState.tags[i].operations > 0) flushTag(static_cast<TagID>(i), localState.tags[i]);
+
+	std::vector<TagStats> result;
+	std::lock_guard<std::mutex> lock(frameLock);
+	auto count = tagCount.load(std::memory_order_acquire);
+	for(uint32 i = 0; i < count; i++) {
+		const auto& tag = globalTags[i];
+		auto name = tag.name.load(std::memory_order_relaxed);
+		result.push_back(TagStats{
+			name ? std::string(name) : std::string("Untagged"),
+			tag.live.load(std::memory_order_relaxed),
+			tag.peak.load(std::memory_order_relaxed),
+			tag.allocations.load(std::memory_order_relaxed),
+			tag.frees.load(std::memory_order_relaxed),
+			tag.allocatedBytes.load(std::memory_order_relaxed),
+			tag.frameAllocations,
+			tag.frameAllocatedBytes
+		});
+	}
+	return result;
+}
+
+void akmem::endFrame() {
+	if (!isTracking()) return;
+
+	std::lock_guard<std::mutex> lock(frameLock);
+	auto count = tagCount.load(std::memory_order_acquire);
+	for(uint32 i = 0; i < count; i++) {
+		auto& tag = globalTags[i];
+		auto allocations = tag.allocations.load(std::memory_order_relaxed);
+		auto allocatedBytes = tag.allocatedBytes.load(std::memory_order_relaxed);
+		tag.frameAllocations = allocations - tag.lastAllocations;
+		tag.frameAllocatedBytes = allocatedBytes - tag.lastAllocatedBytes;
+		tag.lastAllocations = allocations;
+		tag.lastAllocatedBytes = allocatedBytes;
+	}
+}
+
+void akmem::logReport() {
+	if (!isTracking()) { log.info("Allocation tracking is not compiled in, build with AK_MEMORY_TRACKING."); return; }
+
+	auto stats = tagStats();
+	std::sort(stats.begin(), stats.end(), [](const TagStats& lhs, const TagStats& rhs){ return lhs.liveBytes > rhs.liveBytes; });
+
+	for(const auto& entry : stats) {
+		if (entry.allocations == 0) continue;
+		log.info("'", entry.name, "': ", entry.liveBytes/1024, "KB live, ", entry.peakBytes/1024, "KB peak, ", entry.allocations - std::min(entry.frees, entry.allocations), " live allocations.",
+			akl::field("tag", entry.name), akl::field("liveBytes", entry.liveBytes), akl::field("peakBytes", entry.peakBytes),
+			akl::field("allocations", entry.allocations), akl::field("frees", entry.frees), akl::field("allocatedBytes", entry.allocatedBytes),
+			akl::field("frameAllocations", entry.frameAllocations), akl::field("frameAllocatedBytes", entry.frameAllocatedBytes));
+	}
+}
+
+// /////////// //
+// // Hooks // //
+// /////////// //
+
+#ifdef AK_MEMORY_TRACKING
+
+namespace {
+	/// Precedes every tracked block
+	struct AllocationHeader final {
+		void* block;
+		std::size_t size;
+		TagID tag;
+		uint32 magic;
+	};
+}
+
+static constexpr uint32 HEADER_MAGIC = 0xA110C8ED;
+static constexpr std::size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+static void* trackedAllocate(std::size_t size, std::size_t alignment) noexcept {
+	alignment = std::max(alignment, DEFAULT_ALIGNMENT);
+	auto block = std::malloc(size + sizeof(AllocationHeader) + alignment);
+	if (!block) return nullptr;
+
+	auto address = (reinterpret_cast<std::uintptr_t>(block) + sizeof(AllocationHeader) + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+	auto result = reinterpret_cast<void*>(address);
+
+	auto tag = localTag;
+	new(reinterpret_cast<AllocationHeader*>(result) - 1) AllocationHeader{block, size, tag, HEADER_MAGIC};
+	countAllocation(tag, size);
+	return result;
+}
+
+static void trackedFree(void* ptr) noexcept {
+	if (!ptr) return;
+	auto header = reinterpret_cast<AllocationHeader*>(ptr) - 1;
+	if (header->magic != HEADER_MAGIC) std::abort(); // Not allocated through the hooks, or already freed
+
+	header->magic = 0;
+	countFree(header->tag, header->size);
+	std::free(header->block);
+}
+
+static void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+	while(true) {
+		if (auto result = trackedAllocate(size, alignment)) return result;
+		auto handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, DEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, DEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size, DEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size, DEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return trackedAllocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return trackedAllocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { trackedFree(ptr); }
+
+#endif
@@ -0,0 +1,481 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akcommon/Time.hpp>
+#include <akengine/Config.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
+#include <akengine/filesystem/CFile.hpp>
+#include <akengine/metrics/Metrics.hpp>
+#include <akengine/thread/ByteRing.hpp>
+#include <akengine/thread/CurrentThread.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+using namespace akprof;
+
+static constexpr akl::Logger log(AK_STRING_VIEW("Profiler"));
+
+static constexpr akSize ZONE_RING_SIZE = 1024*1024;
+static constexpr akSize CAPTURE_LIMIT = 4*1024*1024;
+static constexpr akSize FRAME_ZONE_LIMIT = 64*1024; /// Per thread, bounds memory when frames aren't being ended
+
+namespace {
+	struct ZoneRecord final {
+		const char* name;
+		int64 begin;
+		int64 end;
+		uint32 depth;
+	};
+}
+
+struct akprof::internal::ZoneRing final {
+	akt::ByteRing ring;
+	std::atomic<uint64> threadID; /// 0 until a buffer from makeZoneBuffer is adopted
+	std::string threadName;
+	std::atomic<uint64> dropped;
+	std::atomic<bool> orphaned;
+
+	std::vector<ZoneRecord> frameZones; /// Drained but not yet aggregated, collector only
+
+	ZoneRing(uint64 id, const std::string& name) : ring(ZONE_RING_SIZE), threadID(id), threadName(name), dropped(0), orphaned(false), frameZones() {}
+};
+
+namespace {
+	using internal::ZoneRing;
+
+	/// Owned by the producing thread, marks the ring for removal once the thread exits and it has been collected
+	struct ZoneRingHandle final {
+		std::shared_ptr<ZoneRing> ring;
+		uint32 depth = 0;
+		~ZoneRingHandle() { if (ring) ring->orphaned = true; }
+	};
+
+	struct CapturedZone final {
+		uint64 threadID;
+		ZoneRecord zone;
+	};
+
+	struct ProfilerState final {
+		akt::Spinlock ringsLock{"Profiler::Rings"};
+		std::vector<std::shared_ptr<ZoneRing>> rings;
+
+		akt::Spinlock collectLock{"Profiler::Collect"};
+		std::vector<std::pair<uint64, std::string>> threadNames; /// Every thread seen while capturing
+		std::vector<CapturedZone> captured;
+		akfs::Path capturePath;
+		bool capturing = false;
+		uint64 captureDropped = 0;
+		int64 captureStart = 0;
+
+		uint64 frame = 0;
+		int64 frameStart = 0;
+		FrameProfile lastFrame;
+	};
+
+	struct StatsRegistry final {
+		akt::Spinlock lock{"Profiler::Stats"};
+		std::vector<std::pair<std::string, std::unique_ptr<akc::FrameStats>>> stats;
+	};
+}
+
+static ProfilerState& profilerState() { static ProfilerState instance; return instance; }
+static StatsRegistry& statsRegistry() { static StatsRegistry instance; return instance; }
+
+static void registerZoneRing(const std::shared_ptr<ZoneRing>& ring) {
+	auto& state = profilerState();
+	auto lock = state.ringsLock.lock();
+	state.rings.push_back(ring);
+}
+
+static ZoneRingHandle& localZoneRingHandle() {
+	thread_local ZoneRingHandle handle;
+	return handle;
+}
+
+static ZoneRingHandle& zoneRingHandle() {
+	auto& handle = localZoneRingHandle();
+	if (!handle.ring) {
+		handle.ring = std::make_shared<ZoneRing>(akt::current().id(), akt::current().name());
+		registerZoneRing(handle.ring);
+	}
+	return handle;
+}
+
+ZoneBuffer akprof::makeZoneBuffer(const std::string& threadName) {
+	auto result = std::make_shared<ZoneRing>(0, threadName);
+	registerZoneRing(result);
+	return result;
+}
+
+bool akprof::adoptZoneBuffer(const ZoneBuffer& buffer) {
+	auto& handle = localZoneRingHandle();
+	if (handle.ring) return true;
+	if (!buffer) return false;
+
+	// A buffer can only belong to one thread, the first to adopt it
+	uint64 unowned = 0;
+	if (!buffer->threadID.compare_exchange_strong(unowned, akt::current().id(), std::memory_order_relaxed)) return false;
+	handle.ring = buffer;
+	return true;
+}
+
+uint32 akprof::internal::enterZone() {
+	return zoneRingHandle().depth++;
+}
+
+void akprof::internal::leaveZone(const char* name, int64 begin, int64 end, uint32 depth) {
+	auto& handle = zoneRingHandle();
+	handle.depth = depth;
+
+	auto data = handle.ring->ring.reserve(sizeof(ZoneRecord));
+	if (!data) { handle.ring->dropped.fetch_add(1, std::memory_order_relaxed); return; }
+
+	ZoneRecord record{name, begin, end, depth};
+	std::memcpy(data, &record, sizeof(ZoneRecord));
+	handle.ring->ring.commit();
+}
+
+// //////////////// //
+// // Collection // //
+// //////////////// //
+
+/// Drains every thread's ring, callers hold collectLock
+static uint64 collectZones(ProfilerState& state) {
+	uint64 dropped = 0;
+
+	auto lock = state.ringsLock.lock();
+	for(auto iter = state.rings.begin(); iter != state.rings.end();) {
+		auto& entry = **iter;
+		bool orphaned = entry.orphaned;
+
+		auto threadID = entry.threadID.load(std::memory_order_relaxed);
+		if (state.capturing && (threadID != 0) && std::none_of(state.threadNames.begin(), state.threadNames.end(), [&](const auto& name){ return name.first == threadID; })) {
+			state.threadNames.emplace_back(threadID, entry.threadName);
+		}
+
+		entry.ring.drain([&](const uint8* data, akSize /*size*/) {
+			ZoneRecord record;
+			std::memcpy(&record, data, sizeof(ZoneRecord));
+			if (entry.frameZones.size() < FRAME_ZONE_LIMIT) entry.frameZones.push_back(record);
+			else dropped++;
+
+			if (!state.capturing) return;
+			if (state.captured.size() < CAPTURE_LIMIT) state.captured.push_back(CapturedZone{threadID, record});
+			else state.captureDropped++;
+		});
+		auto ringDropped = entry.dropped.exchange(0, std::memory_order_relaxed);
+		if (state.capturing) state.captureDropped += ringDropped;
+		dropped += ringDropped;
+
+		// The owning thread has exited, nothing more can be written
+		if (orphaned && entry.frameZones.empty()) iter = state.rings.erase(iter);
+		else iter++;
+	}
+
+	return dropped;
+}
+
+static bool isSameName(const char* lhs, const char* rhs) {
+	return (lhs == rhs) || (std::strcmp(lhs, rhs) == 0);
+}
+
+static ThreadProfile aggregateZones(const ZoneRing& entry, std::vector<ZoneRecord>& zones) {
+	ThreadProfile result{entry.threadID.load(std::memory_order_relaxed), entry.threadName, {}};
+
+	// Zones are recorded as they close, order by opening so parents come first
+	std::sort(zones.begin(), zones.end(), [](const ZoneRecord& lhs, const ZoneRecord& rhs){
+		return (lhs.begin != rhs.begin) ? (lhs.begin < rhs.begin) : (lhs.depth < rhs.depth);
+	});
+
+	std::vector<std::pair<uint32, int64>> open; // Node index and end time of the enclosing zone at each depth
+	for(const auto& zone : zones) {
+		uint32 parent = ProfileNode::NO_PARENT;
+		if ((zone.depth > 0) && (open.size() >= zone.depth) && (open[zone.depth - 1].second >= zone.end)) parent = open[zone.depth - 1].first;
+
+		auto depth = (parent == ProfileNode::NO_PARENT) ? 0 : result.nodes[parent].depth + 1;
+		auto node = std::find_if(result.nodes.begin(), result.nodes.end(), [&](const ProfileNode& entry){ return (entry.parent == parent) && isSameName(entry.name, zone.name); });
+		if (node == result.nodes.end()) node = result.nodes.insert(result.nodes.end(), ProfileNode{zone.name, parent, depth, 0, 0, 0});
+
+		auto duration = zone.end - zone.begin;
+		node->calls++;
+		node->totalNS += duration;
+		node->selfNS += duration;
+		if (parent != ProfileNode::NO_PARENT) result.nodes[parent].selfNS -= duration;
+
+		open.resize(std::min<std::size_t>(open.size(), zone.depth));
+		open.resize(zone.depth, std::make_pair(ProfileNode::NO_PARENT, std::numeric_limits<int64>::min()));
+		open.emplace_back(static_cast<uint32>(node - result.nodes.begin()), zone.end);
+	}
+
+	zones.clear();
+	return result;
+}
+
+void akprof::setEnabled(bool enabled) {
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	if (enabled && !internal::enabled) state.frameStart = internal::now();
+	internal::enabled = enabled;
+}
+
+void akprof::endFrame() {
+	/* Frame Time */ {
+		static akc::FrameStats& frameTimes = frameStats(stats::Frame);
+		static akmet::Counter& frameMetric = akmet::counter("frames");
+		static akmet::Histogram& frameTimeMetric = akmet::histogram("frameTimeNS");
+		static auto lastFrameTime = std::chrono::steady_clock::now();
+		auto frameTime = std::chrono::steady_clock::now();
+		frameTimes.record(frameTime - lastFrameTime);
+		frameMetric.add();
+		frameTimeMetric.record(frameTime - lastFrameTime);
+		lastFrameTime = frameTime;
+	}
+	akmem::endFrame();
+
+	if (!isEnabled()) return;
+
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	auto now = internal::now();
+
+	FrameProfile frame;
+	frame.frame = state.frame++;
+	frame.beginNS = state.frameStart;
+	frame.endNS = now;
+	frame.droppedZones = collectZones(state);
+	static akmet::Counter& droppedMetric = akmet::counter("profiler.droppedZones");
+	droppedMetric.add(frame.droppedZones);
+
+	/* Aggregate */ {
+		auto ringsLock = state.ringsLock.lock();
+		for(auto& ring : state.rings) {
+			if (ring->frameZones.empty()) continue;
+			frame.threads.push_back(aggregateZones(*ring, ring->frameZones));
+		}
+	}
+
+	state.frameStart = now;
+	state.lastFrame = std::move(frame);
+}
+
+FrameProfile akprof::lastFrame() {
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	return state.lastFrame;
+}
+
+std::string akprof::formatFrame(const FrameProfile& frame) {
+	std::stringstream sstream;
+	sstream << std::fixed << std::setprecision(3);
+	sstream << "Frame " << frame.frame << ": " << static_cast<fpDouble>(frame.endNS - frame.beginNS)/1e6 << "ms";
+	if (frame.droppedZones > 0) sstream << ", " << frame.droppedZones << " zones dropped";
+	sstream << "\n";
+
+	for(const auto& thread : frame.threads) {
+		sstream << "[" << thread.threadName << "]\n";
+
+		// Nodes are in first-seen order, walk depth first so children follow their parent
+		auto printNode = [&](uint32 parent, const auto& self) -> void {
+			for(uint32 i = 0; i < thread.nodes.size(); i++) {
+				const auto& node = thread.nodes[i];
+				if (node.parent != parent) continue;
+				sstream << std::string(2*(node.depth + 1), ' ') << node.name << " x" << node.calls << " " << static_cast<fpDouble>(node.totalNS)/1e6 << "ms (self " << static_cast<fpDouble>(node.selfNS)/1e6 << "ms)\n";
+				self(i, self);
+			}
+		};
+		printNode(ProfileNode::NO_PARENT, printNode);
+	}
+
+	return sstream.str();
+}
+
+// ////////////////////// //
+// // Frame Statistics // //
+// ////////////////////// //
+
+akc::FrameStats& akprof::frameStats(const std::string_view& name) {
+	auto& registry = statsRegistry();
+	auto lock = registry.lock.lock();
+
+	auto iter = std::find_if(registry.stats.begin(), registry.stats.end(), [&](const auto& entry){ return entry.first == name; });
+	if (iter != registry.stats.end()) return *iter->second;
+
+	registry.stats.emplace_back(std::string(name), std::make_unique<akc::FrameStats>());
+	return *registry.stats.back().second;
+}
+
+std::vector<std::pair<std::string, akc::FrameStatsSummary>> akprof::frameStatsWindow() {
+	auto& registry = statsRegistry();
+	auto lock = registry.lock.lock();
+
+	std::vector<std::pair<std::string, akc::FrameStatsSummary>> result;
+	result.reserve(registry.stats.size());
+	for(const auto& entry : registry.stats) result.emplace_back(entry.first, entry.second->window());
+	return result;
+}
+
+static fpDouble toMS(uint64 ns) { return static_cast<fpDouble>(ns)/1e6; }
+
+void akprof::logFrameStats() {
+	auto& registry = statsRegistry();
+	auto lock = registry.lock.lock();
+
+	for(const auto& entry : registry.stats) {
+		auto window = entry.second->window();
+		auto total = entry.second->total();
+		if (total.count == 0) continue;
+
+		log.info("'", entry.first, "' last ", (akc::FrameStats::WINDOW_SLOTS*entry.second->slotMS())/1000, "s: p50 ", toMS(window.p50NS), "ms, p95 ", toMS(window.p95NS), "ms, p99 ", toMS(window.p99NS), "ms, max ", toMS(window.maxNS), "ms. Whole run:",
+			akl::field("stat", entry.first), akl::field("count", total.count), akl::field("meanMS", toMS(total.meanNS)),
+			akl::field("p50MS", toMS(total.p50NS)), akl::field("p95MS", toMS(total.p95NS)), akl::field("p99MS", toMS(total.p99NS)), akl::field("maxMS", toMS(total.maxNS)));
+	}
+}
+
+// ///////////// //
+// // Capture // //
+// ///////////// //
+
+static void appendTraceString(std::string& out, const std::string_view& str) {
+	out.push_back('"');
+	for(char c : str) {
+		if ((c == '"') || (c == '\\')) out.push_back('\\');
+		if (static_cast<uint8>(c) < 0x20) c = ' ';
+		out.push_back(c);
+	}
+	out.push_back('"');
+}
+
+static void appendTraceMicroseconds(std::string& out, int64 ns) {
+	char buffer[32];
+	auto length = std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<fpDouble>(ns)/1e3);
+	out.append(buffer, static_cast<std::size_t>(std::max(length, 0)));
+}
+
+static bool writeChromeTrace(const ProfilerState& state) {
+	akfs::CFile file(state.capturePath, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+	if (!file) return false;
+
+	std::string out;
+	out.reserve(1024*1024);
+	auto flushOut = [&]{ file.write(out.data(), out.size()); out.clear(); };
+
+	out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	bool first = true;
+	for(const auto& thread : state.threadNames) {
+		if (!first) out.push_back(',');
+		first = false;
+		out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+		out.append(std::to_string(thread.first));
+		out.append(",\"args\":{\"name\":");
+		appendTraceString(out, thread.second);
+		out.append("}}");
+	}
+
+	for(const auto& entry : state.captured) {
+		if (!first) out.push_back(',');
+		first = false;
+		out.append("\n{\"name\":");
+		appendTraceString(out, entry.zone.name);
+		out.append(",\"ph\":\"X\",\"pid\":1,\"tid\":");
+		out.append(std::to_string(entry.threadID));
+		out.append(",\"ts\":");
+		appendTraceMicroseconds(out, entry.zone.begin - state.captureStart);
+		out.append(",\"dur\":");
+		appendTraceMicroseconds(out, entry.zone.end - entry.zone.begin);
+		out.push_back('}');
+
+		if (out.size() >= 1000*1024) flushOut();
+	}
+	out.append("\n]}\n");
+	flushOut();
+
+	return file.flush();
+}
+
+bool akprof::startCapture(const akfs::Path& path) {
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	if (state.capturing) return false;
+
+	collectZones(state); // Discard zones from before the capture
+	state.captured.clear();
+	state.threadNames.clear();
+	state.captureDropped = 0;
+	state.capturePath = path;
+	state.captureStart = internal::now();
+	state.capturing = true;
+
+	if (!internal::enabled) state.frameStart = state.captureStart;
+	internal::enabled = true;
+	return true;
+}
+
+bool akprof::stopCapture() {
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	if (!state.capturing) return false;
+
+	collectZones(state);
+	state.capturing = false;
+
+	bool written = writeChromeTrace(state);
+	if (written) log.info("Wrote ", state.captured.size(), " zones to '", state.capturePath.str(), "'", state.captureDropped > 0 ? akc::buildString(", ", state.captureDropped, " dropped.") : std::string("."));
+	else log.warn("Could not write profile capture to '", state.capturePath.str(), "'");
+
+	state.captured = std::vector<CapturedZone>();
+	state.threadNames.clear();
+	return written;
+}
+
+bool akprof::isCapturing() {
+	auto& state = profilerState();
+	auto lock = state.collectLock.lock();
+	return state.capturing;
+}
+
+// //////////// //
+// // Config // //
+// //////////// //
+
+static akev::SubscriberID profilerSInitRegenerateConfigHook = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& event){
+	akd::serialize(event.data()["profiler"]["enabled"], false);
+	akd::serialize(event.data()["profiler"]["capture"], false);
+});
+
+static akev::SubscriberID profilerSInitSetConfigHook = ake::setConfigDispatch().subscribe([](ake::SetConfigEvent& event){
+	bool enabled;
+	if (akd::deserialize(enabled, event.data().atOrDef("profiler").atOrDef("enabled"))) setEnabled(enabled);
+
+	bool capture = false;
+	if (!akd::deserialize(capture, event.data().atOrDef("profiler").atOrDef("capture"))) return;
+
+	if (!capture) { stopCapture(); return; }
+	if (isCapturing()) return;
+
+	auto utc = akc::utcTimestamp();
+	std::stringstream filename;
+	filename << "data/profiles/trace_" << std::put_time(&utc.ctime, "%Y%m%d_%H%M%S") << ".json";
+	if (!startCapture(filename.str())) log.warn("Could not start profile capture.");
+});
@@ -12,4 +12,7 @@ include_guard(GLOBAL)
 
 sugar_files(AK_ENGINE_SOURCE 
 	Log.cpp
+	LogSink.cpp
+	Memory.cpp
+	Profiler.cpp
 )
@@ -0,0 +1,283 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akcommon/Time.hpp>
+#include <akengine/Config.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/event/Recorder.hpp>
+#include <akengine/filesystem/CFile.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+using namespace akev;
+
+static constexpr akl::Logger log(AK_STRING_VIEW("Recorder"));
+
+static constexpr char   RECORDING_MAGIC[8] = {'A', 'K', 'E', 'V', 'R', 'E', 'C', '\0'};
+static constexpr uint32 RECORDING_VERSION = 1;
+static constexpr akSize RECORDING_FLUSH_SIZE = 64*1024;
+
+namespace {
+	struct RecorderState final {
+		akt::Spinlock lock{"Recorder"};
+		std::atomic<bool> recording{false};
+
+		akfs::CFile file;
+		std::vector<uint8> buffer;
+
+		std::chrono::steady_clock::time_point startTime;
+		uint64 lastTime = 0;
+		uint64 frame = 0;
+		uint64 lastFrame = 0;
+	};
+
+	struct ReplayHandlers final {
+		akt::Spinlock lock{"Recorder::Replay"};
+		std::unordered_map<RecordChannel, std::function<replay_handler_f>> handlers;
+	};
+
+	struct RecordHeader final {
+		uint64 time;
+		uint64 frame;
+		RecordChannel channel;
+		const uint8* data;
+		akSize size;
+		akSize next;
+	};
+}
+
+static RecorderState& recorderState() { static RecorderState instance; return instance; }
+static ReplayHandlers& replayHandlers() { static ReplayHandlers instance; return instance; }
+
+static void writeVarint(std::vector<uint8>& out, uint64 value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<uint8>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8>(value));
+}
+
+static bool readVarint(const std::vector<uint8>& in, akSize& offset, uint64& value) {
+	value = 0;
+	for(uint32 shift = 0; shift < 64; shift += 7) {
+		if (offset >= in.size()) return false;
+		auto byte = in[offset++];
+		value |= static_cast<uint64>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) return true;
+	}
+	return false;
+}
+
+static bool decodeRecord(const std::vector<uint8>& in, akSize offset, uint64 baseTime, uint64 baseFrame, RecordHeader& out) {
+	uint64 timeDelta, frameDelta, channel, size;
+	if (!readVarint(in, offset, timeDelta)) return false;
+	if (!readVarint(in, offset, frameDelta)) return false;
+	if (!readVarint(in, offset, channel)) return false;
+	if (!readVarint(in, offset, size)) return false;
+	if (size > in.size() - offset) return false;
+
+	out.time = baseTime + timeDelta;
+	out.frame = baseFrame + frameDelta;
+	out.channel = static_cast<RecordChannel>(channel);
+	out.data = in.data() + offset;
+	out.size = static_cast<akSize>(size);
+	out.next = offset + static_cast<akSize>(size);
+	return true;
+}
+
+static void flushBuffer(RecorderState& state) {
+	if (state.buffer.empty()) return;
+	state.file.write(state.buffer.data(), state.buffer.size());
+	state.file.flush();
+	state.buffer.clear();
+}
+
+// /////////////// //
+// // Recording // //
+// /////////////// //
+
+bool akev::startRecording(const akfs::Path& path) {
+	auto& state = recorderState();
+	auto lock = state.lock.lock();
+
+	if (state.recording) { flushBuffer(state); state.recording = false; }
+
+	auto file = akfs::CFile(path, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+	if (!file) return false;
+	file.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	file.write(RECORDING_VERSION);
+
+	state.file = std::move(file);
+	state.buffer.clear();
+	state.buffer.reserve(RECORDING_FLUSH_SIZE + 1024);
+	state.startTime = std::chrono::steady_clock::now();
+	state.lastTime = 0;
+	state.frame = 0;
+	state.lastFrame = 0;
+	state.recording = true;
+
+	return true;
+}
+
+void akev::stopRecording() {
+	auto& state = recorderState();
+	auto lock = state.lock.lock();
+	if (!state.recording) return;
+
+	state.recording = false;
+	flushBuffer(state);
+	state.file = akfs::CFile();
+}
+
+bool akev::isRecording() {
+	return recorderState().recording.load(std::memory_order_relaxed);
+}
+
+void akev::recordFrame() {
+	auto& state = recorderState();
+	if (!state.recording.load(std::memory_order_relaxed)) return;
+	auto lock = state.lock.lock();
+	state.frame++;
+}
+
+void akev::record(RecordChannel channel, const void* data, akSize size) {
+	auto& state = recorderState();
+	if (!state.recording.load(std::memory_order_relaxed)) return;
+
+	auto now = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.startTime).count());
+
+	auto lock = state.lock.lock();
+	if (!state.recording) return;
+
+	// Records from other threads may arrive slightly out of order, keep deltas unsigned.
+	now = std::max(now, state.lastTime);
+	writeVarint(state.buffer, now - state.lastTime);
+	writeVarint(state.buffer, state.frame - state.lastFrame);
+	writeVarint(state.buffer, channel);
+	writeVarint(state.buffer, size);
+	auto bytes = static_cast<const uint8*>(data);
+	state.buffer.insert(state.buffer.end(), bytes, bytes + size);
+
+	state.lastTime = now;
+	state.lastFrame = state.frame;
+
+	if (state.buffer.size() >= RECORDING_FLUSH_SIZE) flushBuffer(state);
+}
+
+// //////////// //
+// // Replay // //
+// //////////// //
+
+void akev::setReplayHandler(RecordChannel channel, const std::function<replay_handler_f>& handler) {
+	auto& state = replayHandlers();
+	auto lock = state.lock.lock();
+	state.handlers[channel] = handler;
+}
+
+void akev::clearReplayHandler(RecordChannel channel) {
+	auto& state = replayHandlers();
+	auto lock = state.lock.lock();
+	state.handlers.erase(channel);
+}
+
+Replay::Replay() : m_data(), m_offset(0), m_speed(ReplaySpeed::Original), m_startTime(), m_started(false), m_time(0), m_recordFrame(0), m_frame(0), m_eventCount(0) {}
+
+bool Replay::open(const akfs::Path& path, ReplaySpeed speed) {
+	*this = Replay();
+
+	akfs::CFile file(path, akfs::OpenFlags::In);
+	if (!file) return false;
+
+	char magic[sizeof(RECORDING_MAGIC)];
+	uint32 version;
+	if ((file.read(magic, sizeof(magic)) != sizeof(magic)) || (std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0)) return false;
+	if ((file.read(version) != 1) || (version != RECORDING_VERSION)) return false;
+
+	m_data = file.readAll();
+	m_speed = speed;
+	return true;
+}
+
+bool Replay::replayFrame() {
+	if (isFinished()) return false;
+
+	if (!m_started) {
+		m_startTime = std::chrono::steady_clock::now();
+		m_started = true;
+	}
+
+	while(!isFinished()) {
+		RecordHeader record;
+		if (!decodeRecord(m_data, m_offset, m_time, m_recordFrame, record)) {
+			log.warn("Truncated record at offset ", m_offset, ", ending replay.");
+			m_offset = static_cast<akSize>(m_data.size());
+			break;
+		}
+		if (record.frame > m_frame) break;
+
+		if (m_speed == ReplaySpeed::Original) std::this_thread::sleep_until(m_startTime + std::chrono::nanoseconds(record.time));
+
+		std::function<replay_handler_f> handler;
+		/* Lookup */ {
+			auto& state = replayHandlers();
+			auto lock = state.lock.lock();
+			auto iter = state.handlers.find(record.channel);
+			if (iter != state.handlers.end()) handler = iter->second;
+		}
+		if (handler) handler(record.data, record.size);
+
+		m_offset = record.next;
+		m_time = record.time;
+		m_recordFrame = record.frame;
+		m_eventCount++;
+	}
+
+	m_frame++;
+	return !isFinished();
+}
+
+uint64 Replay::replayAll() {
+	auto startCount = m_eventCount;
+	while(replayFrame());
+	return m_eventCount - startCount;
+}
+
+// //////////// //
+// // Config // //
+// //////////// //
+
+static akev::SubscriberID recorderSInitRegenerateConfigHook = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& event){
+	akd::serialize(event.data()["events"]["record"], false);
+});
+
+static akev::SubscriberID recorderSInitSetConfigHook = ake::setConfigDispatch().subscribe([](ake::SetConfigEvent& event){
+	bool shouldRecord = false;
+	if (!akd::deserialize(shouldRecord, event.data().atOrDef("events").atOrDef("record"))) return;
+
+	if (!shouldRecord) { stopRecording(); return; }
+	if (isRecording()) return;
+
+	auto utc = akc::utcTimestamp();
+	std::stringstream filename;
+	filename << "data/recordings/events_" << std::put_time(&utc.ctime, "%Y%m%d_%H%M%S") << ".akrec";
+	if (!startRecording(filename.str())) log.warn("Could not open event recording: ", filename.str());
+});
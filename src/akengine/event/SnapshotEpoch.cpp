@@ -0,0 +1,75 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/event/SnapshotEpoch.hpp>
+#include <algorithm>
+#include <limits>
+
+using namespace akev;
+
+static std::atomic<internal::EpochRecord*> epochRecords{nullptr};
+static thread_local bool epochRecordReleased = false;
+
+namespace {
+	/// Returns the thread's record to the list when the thread exits
+	struct EpochRecordOwner final {
+		internal::EpochRecord* record;
+		~EpochRecordOwner() {
+			internal::localEpochRecord = nullptr;
+			epochRecordReleased = true;
+			internal::releaseEpochRecord(record);
+		}
+	};
+}
+
+static internal::EpochRecord* claimEpochRecord() {
+	for(auto record = epochRecords.load(std::memory_order_acquire); record; record = record->next) {
+		bool expected = false;
+		if (!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) return record;
+	}
+
+	auto record = new internal::EpochRecord{{0}, {true}, nullptr, 0};
+	auto head = epochRecords.load(std::memory_order_relaxed);
+	do { record->next = head; } while(!epochRecords.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+	return record;
+}
+
+internal::EpochRecord* internal::acquireEpochRecord(bool& temporary) {
+	if (!epochRecordReleased) {
+		thread_local EpochRecordOwner owner{claimEpochRecord()};
+		localEpochRecord = owner.record;
+		temporary = false;
+		return owner.record;
+	}
+
+	temporary = true;
+	return claimEpochRecord();
+}
+
+void internal::releaseEpochRecord(EpochRecord* record) {
+	record->depth = 0;
+	record->epoch.store(0, std::memory_order_relaxed);
+	record->inUse.store(false, std::memory_order_release);
+}
+
+uint64 internal::oldestReadEpoch() {
+	uint64 result = std::numeric_limits<uint64>::max();
+	for(auto record = epochRecords.load(std::memory_order_acquire); record; record = record->next) {
+		auto epoch = record->epoch.load();
+		if (epoch != 0) result = std::min(result, epoch);
+	}
+	return result;
+}
@@ -0,0 +1,16 @@
+include_guard(GLOBAL)
+
+# ################ #
+# # Include Dirs # #
+# ################ #
+
+# sugar_include()
+
+# ################ #
+# # Source Files # #
+# ################ #
+
+sugar_files(AK_ENGINE_SOURCE 
+	Recorder.cpp
+	SnapshotEpoch.cpp
+)
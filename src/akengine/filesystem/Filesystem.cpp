@@ -40,7 +40,9 @@
 #include <akrender/gl/Types.hpp>
 #include <akrender/window/WindowOptions.hpp>
 #include <dirent.h>
+#ifndef __linux__
 #include <io.h>
+#endif
 #include <sys/stat.h>
 #include <cstdio>
 #include <memory>
@@ -0,0 +1,550 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akcommon/Time.hpp>
+#include <akengine/Config.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/filesystem/CFile.hpp>
+#include <akengine/filesystem/Filesystem.hpp>
+#include <akengine/metrics/Metrics.hpp>
+#include <akengine/thread/CurrentThread.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <akengine/thread/Thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace akmet;
+
+static constexpr akl::Logger log(AK_STRING_VIEW("Metrics"));
+
+namespace {
+	struct MetricEntry final {
+		std::string name;
+		Labels labels;
+		MetricType type;
+		std::unique_ptr<Counter> counter;
+		std::unique_ptr<Gauge> gauge;
+		std::unique_ptr<Histogram> histogram;
+		std::unique_ptr<ShardedCounter> shardedCounter;
+		std::unique_ptr<ShardedGauge> shardedGauge;
+	};
+
+	struct MetricRegistry final {
+		std::mutex lock;
+		std::vector<std::unique_ptr<MetricEntry>> entries;
+		std::unordered_map<std::string, MetricEntry*> byKey;
+	};
+
+	struct ShardRegistry final {
+		std::mutex lock;
+		std::vector<internal::MetricShard*> live;
+		std::array<std::atomic<int64>, internal::MAX_SHARDED_METRICS> exited; /// Totals of shards whose thread has exited
+		akSize nextSlot = 0;
+
+		ShardRegistry() : lock(), live(), exited() {
+			for(auto& value : exited) value.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	/// Folds the thread's shard into the exited totals when the thread ends
+	struct ShardOwner final {
+		internal::MetricShard* shard;
+		ShardOwner();
+		~ShardOwner();
+	};
+
+	struct ExporterState final {
+		akt::Spinlock lock{"Metrics::Exporter"};
+		ExportFormat format = ExportFormat::JsonLines;
+		akfs::Path path;
+	};
+}
+
+// Function local so metrics can be registered during static initialisation, and never destroyed so they can be updated during static destruction
+static MetricRegistry& metricRegistry() {
+	static MetricRegistry* registry = new MetricRegistry();
+	return *registry;
+}
+
+static ShardRegistry& shardRegistry() {
+	static ShardRegistry* registry = new ShardRegistry();
+	return *registry;
+}
+
+static ExporterState& exporterState() {
+	static ExporterState state;
+	return state;
+}
+
+static akt::Thread exporterThread("Metrics");
+static std::mutex exportFileLock;
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// //////////////// //
+// // Histograms // //
+// //////////////// //
+
+HistogramSummary Histogram::summary() const {
+	HistogramSummary result;
+	result.sum = m_sum.load(std::memory_order_relaxed);
+	result.max = m_max.load(std::memory_order_relaxed);
+
+	// Buckets are read one at a time while writers continue, rank against what was actually read
+	std::array<uint64, layout_t::BUCKET_COUNT> counts;
+	for(uint32 i = 0; i < layout_t::BUCKET_COUNT; i++) {
+		counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+		result.count += counts[i];
+	}
+	if (result.count == 0) return result;
+
+	// Nearest rank: the smallest value with at least p% of samples at or below it
+	auto rank = [&](uint64 percent) { return std::max<uint64>(1, (result.count*percent + 99)/100); };
+	std::array<uint64, 3> ranks{{rank(50), rank(95), rank(99)}};
+	std::array<uint64*, 3> outputs{{&result.p50, &result.p95, &result.p99}};
+
+	uint64 cumulative = 0;
+	akSize next = 0;
+	for(uint32 i = 0; (i < layout_t::BUCKET_COUNT) && (next < ranks.size()); i++) {
+		cumulative += counts[i];
+		while((next < ranks.size()) && (cumulative >= ranks[next])) *outputs[next++] = std::min(layout_t::bucketValue(i), result.max);
+	}
+
+	return result;
+}
+
+// //////////// //
+// // Shards // //
+// //////////// //
+
+static thread_local bool shardExited = false;
+
+ShardOwner::ShardOwner() : shard(new internal::MetricShard()) {
+	auto& registry = shardRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+	registry.live.push_back(shard);
+}
+
+ShardOwner::~ShardOwner() {
+	auto& registry = shardRegistry();
+	/* Retire */ {
+		std::lock_guard<std::mutex> lock(registry.lock);
+		for(akSize i = 0; i < internal::MAX_SHARDED_METRICS; i++) registry.exited[i].fetch_add(shard->values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		registry.live.erase(std::find(registry.live.begin(), registry.live.end(), shard));
+	}
+	internal::currentShard = nullptr;
+	shardExited = true;
+	delete shard;
+}
+
+void internal::addToShardSlow(akSize slot, int64 amount) {
+	if (!shardExited) {
+		thread_local ShardOwner owner;
+		currentShard = owner.shard;
+		addToShard(slot, amount);
+		return;
+	}
+	shardRegistry().exited[slot].fetch_add(amount, std::memory_order_relaxed);
+}
+
+int64 internal::sumShards(akSize slot) {
+	auto& registry = shardRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+	int64 result = registry.exited[slot].load(std::memory_order_relaxed);
+	for(auto shard : registry.live) result += shard->values[slot].load(std::memory_order_relaxed);
+	return result;
+}
+
+/// @return False when every slot is taken
+static bool allocateShardSlot(akSize& slot) {
+	auto& registry = shardRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+	if (registry.nextSlot >= internal::MAX_SHARDED_METRICS) return false;
+	slot = registry.nextSlot++;
+	return true;
+}
+
+// ////////////////// //
+// // Registration // //
+// ////////////////// //
+
+static std::string metricKey(const std::string_view& name, const Labels& labels) {
+	std::string result(name);
+	for(const auto& label : labels) {
+		result.push_back('\0');
+		result.append(label.first);
+		result.push_back('=');
+		result.append(label.second);
+	}
+	return result;
+}
+
+/**
+ * @param optional Return null instead of throwing when a sharded metric can't get a slot
+ */
+static MetricEntry* findOrCreate(const std::string_view& name, const Labels& labels, MetricType type, bool sharded = false, bool optional = false) {
+	auto& registry = metricRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+
+	auto key = metricKey(name, labels);
+	auto iter = registry.byKey.find(key);
+	if (iter != registry.byKey.end()) {
+		if (iter->second->type != type) throw std::logic_error(akc::buildString("Metrics: '", name, "' is already registered as a ", se_internal::convertMetricTypeToStringView(iter->second->type), "."));
+		bool isSharded = iter->second->shardedCounter || iter->second->shardedGauge;
+		if (isSharded != sharded) throw std::logic_error(akc::buildString("Metrics: '", name, "' is already registered ", isSharded ? "as sharded." : "as unsharded."));
+		return iter->second;
+	}
+
+	akSize slot = 0;
+	if (sharded && !allocateShardSlot(slot)) {
+		if (optional) return nullptr;
+		throw std::logic_error(akc::buildString("Metrics: Out of sharded metric slots registering '", name, "'."));
+	}
+
+	auto entry = std::make_unique<MetricEntry>(MetricEntry{std::string(name), labels, type, nullptr, nullptr, nullptr, nullptr, nullptr});
+	switch(type) {
+		case MetricType::Counter: {
+			if (sharded) entry->shardedCounter = std::make_unique<ShardedCounter>(slot);
+			else entry->counter = std::make_unique<Counter>();
+		} break;
+		case MetricType::Gauge: {
+			if (sharded) entry->shardedGauge = std::make_unique<ShardedGauge>(slot);
+			else entry->gauge = std::make_unique<Gauge>();
+		} break;
+		case MetricType::Histogram: entry->histogram = std::make_unique<Histogram>(); break;
+	}
+
+	auto result = entry.get();
+	registry.byKey.emplace(std::move(key), result);
+	registry.entries.push_back(std::move(entry));
+	return result;
+}
+
+Counter& akmet::counter(const std::string_view& name, const Labels& labels) {
+	return *findOrCreate(name, labels, MetricType::Counter)->counter;
+}
+
+Gauge& akmet::gauge(const std::string_view& name, const Labels& labels) {
+	return *findOrCreate(name, labels, MetricType::Gauge)->gauge;
+}
+
+Histogram& akmet::histogram(const std::string_view& name, const Labels& labels) {
+	return *findOrCreate(name, labels, MetricType::Histogram)->histogram;
+}
+
+ShardedCounter& akmet::shardedCounter(const std::string_view& name, const Labels& labels) {
+	return *findOrCreate(name, labels, MetricType::Counter, true)->shardedCounter;
+}
+
+ShardedCounter* akmet::tryShardedCounter(const std::string_view& name, const Labels& labels) {
+	auto entry = findOrCreate(name, labels, MetricType::Counter, true, true);
+	if (!entry) {
+		log.warn("Out of sharded metric slots, '", name, "' won't be recorded.");
+		return nullptr;
+	}
+	return entry->shardedCounter.get();
+}
+
+ShardedGauge& akmet::shardedGauge(const std::string_view& name, const Labels& labels) {
+	return *findOrCreate(name, labels, MetricType::Gauge, true)->shardedGauge;
+}
+
+std::vector<MetricSample> akmet::snapshot() {
+	auto& registry = metricRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+
+	std::vector<MetricSample> result;
+	result.reserve(registry.entries.size());
+	for(const auto& entry : registry.entries) {
+		MetricSample sample{entry->name, entry->labels, entry->type, 0, {}};
+		switch(entry->type) {
+			case MetricType::Counter:   sample.value = static_cast<int64>(entry->counter ? entry->counter->value() : entry->shardedCounter->value()); break;
+			case MetricType::Gauge:     sample.value = entry->gauge ? entry->gauge->value() : entry->shardedGauge->value(); break;
+			case MetricType::Histogram: sample.histogram = entry->histogram->summary(); break;
+		}
+		result.push_back(std::move(sample));
+	}
+	return result;
+}
+
+// //////////////// //
+// // Formatting // //
+// //////////////// //
+
+static void appendJsonString(std::string& out, const std::string_view& str) {
+	out.push_back('"');
+	for(auto c : str) {
+		switch(c) {
+			case '"':  out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\n': out.append("\\n");  break;
+			case '\r': out.append("\\r");  break;
+			case '\t': out.append("\\t");  break;
+			default:
+				if (static_cast<uint8>(c) < 0x20) {
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<uint32>(static_cast<uint8>(c)));
+					out.append(buffer);
+				} else out.push_back(c);
+		}
+	}
+	out.push_back('"');
+}
+
+static void appendJsonNumber(std::string& out, const char* key, uint64 value) {
+	out.push_back(',');
+	appendJsonString(out, key);
+	out.push_back(':');
+	out.append(std::to_string(value));
+}
+
+std::string akmet::formatJsonLine(const std::vector<MetricSample>& samples) {
+	auto utc = akc::utcTimestamp();
+	std::stringstream time;
+	time << std::put_time(&utc.ctime, "%Y-%m-%dT%H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << utc.milliseconds << 'Z';
+
+	std::string out;
+	out.append("{\"time\":");
+	appendJsonString(out, time.str());
+	out.append(",\"uptimeMS\":");
+	out.append(std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()));
+	out.append(",\"metrics\":[");
+
+	bool first = true;
+	for(const auto& sample : samples) {
+		if (!first) out.push_back(',');
+		first = false;
+
+		out.append("{\"name\":");
+		appendJsonString(out, sample.name);
+		if (!sample.labels.empty()) {
+			out.append(",\"labels\":{");
+			for(akSize i = 0; i < sample.labels.size(); i++) {
+				if (i > 0) out.push_back(',');
+				appendJsonString(out, sample.labels[i].first);
+				out.push_back(':');
+				appendJsonString(out, sample.labels[i].second);
+			}
+			out.push_back('}');
+		}
+		out.append(",\"type\":");
+		appendJsonString(out, se_internal::convertMetricTypeToStringView(sample.type));
+
+		if (sample.type == MetricType::Histogram) {
+			appendJsonNumber(out, "count", sample.histogram.count);
+			appendJsonNumber(out, "sum",   sample.histogram.sum);
+			appendJsonNumber(out, "p50",   sample.histogram.p50);
+			appendJsonNumber(out, "p95",   sample.histogram.p95);
+			appendJsonNumber(out, "p99",   sample.histogram.p99);
+			appendJsonNumber(out, "max",   sample.histogram.max);
+		} else {
+			out.append(",\"value\":");
+			out.append(std::to_string(sample.value));
+		}
+		out.push_back('}');
+	}
+
+	out.append("]}\n");
+	return out;
+}
+
+/// "log.deferredFallbacks" -> "log_deferred_fallbacks", "frameTimeNS" -> "frame_time_ns"
+static std::string prometheusIdentifier(const std::string_view& name) {
+	std::string result;
+	bool afterLower = false;
+	for(auto c : name) {
+		bool upper = (c >= 'A') && (c <= 'Z');
+		if (upper && afterLower) result.push_back('_');
+		afterLower = ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9'));
+
+		if (upper) {
+			result.push_back(static_cast<char>(c - 'A' + 'a'));
+		} else if (((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9'))) {
+			result.push_back(c);
+		} else if (!result.empty() && (result.back() != '_')) {
+			result.push_back('_');
+		}
+	}
+	return result;
+}
+
+static void appendPrometheusSample(std::string& out, const std::string& name, const Labels& labels, const std::string_view& quantile, const std::string& value) {
+	out.append(name);
+	if (!labels.empty() || !quantile.empty()) {
+		out.push_back('{');
+		bool first = true;
+		auto appendLabel = [&](const std::string_view& key, const std::string_view& labelValue) {
+			if (!first) out.push_back(',');
+			first = false;
+			out.append(prometheusIdentifier(key));
+			out.append("=\"");
+			for(auto c : labelValue) {
+				if      (c == '\\') out.append("\\\\");
+				else if (c == '"')  out.append("\\\"");
+				else if (c == '\n') out.append("\\n");
+				else out.push_back(c);
+			}
+			out.push_back('"');
+		};
+		for(const auto& label : labels) appendLabel(label.first, label.second);
+		if (!quantile.empty()) appendLabel("quantile", quantile);
+		out.push_back('}');
+	}
+	out.push_back(' ');
+	out.append(value);
+	out.push_back('\n');
+}
+
+std::string akmet::formatPrometheus(const std::vector<MetricSample>& samples) {
+	// Every series of a metric has to follow its TYPE line
+	std::vector<const MetricSample*> sorted;
+	sorted.reserve(samples.size());
+	for(const auto& sample : samples) sorted.push_back(&sample);
+	std::stable_sort(sorted.begin(), sorted.end(), [](const MetricSample* lhs, const MetricSample* rhs){ return lhs->name < rhs->name; });
+
+	std::string out;
+	const std::string* previous = nullptr;
+	for(auto sample : sorted) {
+		auto name = "ak_" + prometheusIdentifier(sample->name);
+		bool firstOfName = !previous || (*previous != sample->name);
+		previous = &sample->name;
+
+		switch(sample->type) {
+			case MetricType::Counter: {
+				name.append("_total");
+				if (firstOfName) out.append("# TYPE ").append(name).append(" counter\n");
+				appendPrometheusSample(out, name, sample->labels, {}, std::to_string(sample->value));
+			} break;
+
+			case MetricType::Gauge: {
+				if (firstOfName) out.append("# TYPE ").append(name).append(" gauge\n");
+				appendPrometheusSample(out, name, sample->labels, {}, std::to_string(sample->value));
+			} break;
+
+			case MetricType::Histogram: {
+				if (firstOfName) out.append("# TYPE ").append(name).append(" summary\n");
+				appendPrometheusSample(out, name, sample->labels, "0.5",  std::to_string(sample->histogram.p50));
+				appendPrometheusSample(out, name, sample->labels, "0.95", std::to_string(sample->histogram.p95));
+				appendPrometheusSample(out, name, sample->labels, "0.99", std::to_string(sample->histogram.p99));
+				appendPrometheusSample(out, name + "_sum",   sample->labels, {}, std::to_string(sample->histogram.sum));
+				appendPrometheusSample(out, name + "_count", sample->labels, {}, std::to_string(sample->histogram.count));
+			} break;
+		}
+	}
+	return out;
+}
+
+// ////////////// //
+// // Exporter // //
+// ////////////// //
+
+bool akmet::exportSnapshot(ExportFormat format, const akfs::Path& path) {
+	auto samples = snapshot();
+	std::lock_guard<std::mutex> lock(exportFileLock);
+
+	switch(format) {
+		case ExportFormat::JsonLines: {
+			akfs::makeDirectory(path.parent(), true); // Append mode doesn't create directories
+			akfs::CFile file(path, akfs::OpenFlags::Append);
+			if (!file) return false;
+			auto out = formatJsonLine(samples);
+			return (file.write(out.data(), out.size()) == out.size()) && file.flush();
+		}
+
+		case ExportFormat::Prometheus: {
+			// Scrapers must never see a partially written file
+			auto tmpPath = akfs::Path(path.str() + ".tmp");
+			/* Write */ {
+				akfs::CFile file(tmpPath, akfs::OpenFlags::Out | akfs::OpenFlags::Truncate);
+				if (!file) return false;
+				auto out = formatPrometheus(samples);
+				if ((file.write(out.data(), out.size()) != out.size()) || !file.flush()) return false;
+			}
+			return akfs::rename(tmpPath, path, true);
+		}
+	}
+
+	return false;
+}
+
+bool akmet::startExporting(ExportFormat format, const akfs::Path& path, uint32 intervalMS) {
+	if (exporterThread.isRunning()) {
+		exporterThread.requestClose();
+		exporterThread.join();
+	}
+
+	auto& state = exporterState();
+	/* Update Config */ {
+		auto lock = state.lock.lock();
+		state.format = format;
+		state.path = path;
+	}
+
+	auto intervalUS = static_cast<int64>(std::max<uint32>(intervalMS, 100))*1000;
+	return exporterThread.execute([=]{
+		auto timer = akt::current().scheduleEvery(intervalUS, [=]{
+			if (!exportSnapshot(format, path)) log.warn("Could not write metrics to: ", path.str());
+		});
+		while(!akt::current().isCloseRequested()) {
+			akt::current().update();
+			akt::current().park();
+		}
+		akt::current().cancel(timer);
+	});
+}
+
+bool akmet::stopExporting() {
+	if (!exporterThread.isRunning()) return false;
+	exporterThread.requestClose();
+	exporterThread.join();
+
+	auto& state = exporterState();
+	auto lock = state.lock.lock();
+	return exportSnapshot(state.format, state.path);
+}
+
+bool akmet::isExporting() {
+	return exporterThread.isRunning();
+}
+
+static akev::SubscriberID metricsSInitRegenerateConfigHook = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& event){
+	akd::serialize(event.data()["metrics"]["export"]["enabled"],    false);
+	akd::serialize(event.data()["metrics"]["export"]["format"],     ExportFormat::JsonLines);
+	akd::serialize(event.data()["metrics"]["export"]["path"],       std::string("data/metrics/metrics.jsonl"));
+	akd::serialize(event.data()["metrics"]["export"]["intervalMS"], uint32(10000));
+});
+
+static akev::SubscriberID metricsSInitSetConfigHook = ake::setConfigDispatch().subscribe([](ake::SetConfigEvent& event){
+	auto exportData = event.data().atOrDef("metrics").atOrDef("export");
+
+	bool enabled;
+	if (!akd::deserialize(enabled, exportData.atOrDef("enabled"))) return;
+	if (!enabled) { stopExporting(); return; }
+
+	ExportFormat format = ExportFormat::JsonLines;
+	std::string path = "data/metrics/metrics.jsonl";
+	uint32 intervalMS = 10000;
+	akd::deserialize(format,     exportData.atOrDef("format"));
+	akd::deserialize(path,       exportData.atOrDef("path"));
+	akd::deserialize(intervalMS, exportData.atOrDef("intervalMS"));
+
+	if (!startExporting(format, akfs::Path(path), intervalMS)) log.warn("Could not start the metrics exporter.");
+});
@@ -0,0 +1,15 @@
+include_guard(GLOBAL)
+
+# ################ #
+# # Include Dirs # #
+# ################ #
+
+# sugar_include()
+
+# ################ #
+# # Source Files # #
+# ################ #
+
+sugar_files(AK_ENGINE_SOURCE 
+	Metrics.cpp
+)
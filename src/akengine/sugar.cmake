@@ -7,7 +7,9 @@ include_guard(GLOBAL)
 sugar_include(data)
 sugar_include(debug)
 sugar_include(ecs)
+sugar_include(event)
 sugar_include(filesystem)
+sugar_include(metrics)
 sugar_include(thread)
 
 # ################ #
@@ -31,6 +31,21 @@ bool CurrentThread::schedule(const std::function<void()>& func) {
 	return true;
 }
 
+TimerID CurrentThread::scheduleAfter(int64 delayMicroseconds, const std::function<void()>& func) {
+	if (!m_thread) return 0;
+	return m_thread->scheduleAfter(delayMicroseconds, func);
+}
+
+TimerID CurrentThread::scheduleEvery(int64 intervalMicroseconds, const std::function<void()>& func) {
+	if (!m_thread) return 0;
+	return m_thread->scheduleEvery(intervalMicroseconds, func);
+}
+
+bool CurrentThread::cancel(TimerID id) {
+	if (!m_thread) return false;
+	return m_thread->cancel(id);
+}
+
 bool CurrentThread::update() {
 	if (!m_thread) return false;
 	return m_thread->update();
@@ -55,6 +70,11 @@ bool CurrentThread::sleep(int64 microseconds) const {
 	return true;
 }
 
+bool CurrentThread::park(int64 maxMicroseconds) const {
+	if (!m_thread || (m_id != std::this_thread::get_id())) return false;
+	return m_thread->park(maxMicroseconds);
+}
+
 bool CurrentThread::isCloseRequested() const {
 	if (!m_thread) return true;
 	return m_thread->isCloseRequested();
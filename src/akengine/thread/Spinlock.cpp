@@ -0,0 +1,123 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/thread/Spinlock.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define AK_SPINLOCK_PAUSE() _mm_pause()
+#else
+#define AK_SPINLOCK_PAUSE() std::atomic_signal_fence(std::memory_order_seq_cst)
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace akt;
+
+void Spinlock::lockContended() const {
+#	ifdef AK_SPINLOCK_STATS
+	auto waitStart = std::chrono::steady_clock::now();
+#	endif
+
+	// Spin with exponential backoff, only attempting the exchange once the lock looks free.
+	bool acquired = false;
+	uint32 backoff = 1;
+	for(uint32 i = 0; (i < SPIN_BUDGET) && !acquired; i++) {
+		for(uint32 j = 0; j < backoff; j++) AK_SPINLOCK_PAUSE();
+		backoff = std::min(backoff << 1, MAX_BACKOFF);
+
+		uint32 expected = STATE_UNLOCKED;
+		acquired = (m_state.load(std::memory_order_relaxed) == STATE_UNLOCKED) && m_state.compare_exchange_weak(expected, STATE_LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	// Out of budget, mark the lock as having waiters and park until the holder wakes us.
+	if (!acquired) {
+		while(m_state.exchange(STATE_WAITERS, std::memory_order_acquire) != STATE_UNLOCKED) internal::spinlockPark(m_state, STATE_WAITERS);
+	}
+
+#	ifdef AK_SPINLOCK_STATS
+	auto waitNS = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count();
+	m_stats->acquisitions.fetch_add(1, std::memory_order_relaxed);
+	m_stats->contended.fetch_add(1, std::memory_order_relaxed);
+	m_stats->waitNS.fetch_add(static_cast<uint64>(waitNS), std::memory_order_relaxed);
+#	endif
+}
+
+void akt::internal::spinlockPark(std::atomic<uint32>& state, uint32 expected) {
+#	if defined(__linux__)
+	static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32), "Futex requires a plain 32-bit word");
+	syscall(SYS_futex, reinterpret_cast<uint32*>(&state), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#	else
+	if (state.load(std::memory_order_relaxed) == expected) std::this_thread::yield();
+#	endif
+}
+
+void akt::internal::spinlockWake(std::atomic<uint32>& state [[maybe_unused]]) {
+#	if defined(__linux__)
+	syscall(SYS_futex, reinterpret_cast<uint32*>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#	endif
+}
+
+// //////////////// //
+// // Statistics // //
+// //////////////// //
+
+static std::mutex& statsLock() {
+	static std::mutex instance;
+	return instance;
+}
+
+static std::map<std::string, std::unique_ptr<internal::SpinlockCounters>, std::less<>>& statsRegistry() {
+	static std::map<std::string, std::unique_ptr<internal::SpinlockCounters>, std::less<>> instance;
+	return instance;
+}
+
+internal::SpinlockCounters* akt::internal::spinlockCountersFor(const std::string_view& name) {
+	std::lock_guard<std::mutex> lock(statsLock());
+	auto& registry = statsRegistry();
+
+	auto iter = registry.find(name);
+	if (iter == registry.end()) iter = registry.emplace(std::string(name), std::make_unique<internal::SpinlockCounters>()).first;
+	return iter->second.get();
+}
+
+std::vector<SpinlockStatistics> akt::spinlockStatistics() {
+	std::vector<SpinlockStatistics> result;
+
+#	ifdef AK_SPINLOCK_STATS
+	std::lock_guard<std::mutex> lock(statsLock());
+	for(const auto& entry : statsRegistry()) {
+		result.push_back({
+			entry.first,
+			entry.second->acquisitions.load(std::memory_order_relaxed),
+			entry.second->contended.load(std::memory_order_relaxed),
+			entry.second->waitNS.load(std::memory_order_relaxed)
+		});
+	}
+	std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs){ return lhs.waitNS > rhs.waitNS; });
+#	endif
+
+	return result;
+}
@@ -16,37 +16,61 @@
 
 #include <akengine/thread/CurrentThread.hpp>
 #include <akengine/thread/Thread.hpp>
+#include <akengine/thread/ThreadRole.hpp>
+#include <algorithm>
+#include <chrono>
+#include <optional>
 
 using namespace akt;
 
 static uint64 getNextID();
 static Thread*& currentThreadPtr();
+static uint64 currentTick();
+static std::chrono::steady_clock::time_point tickTime(uint64 tick);
  
 Thread::Thread()
 	: m_name("Thread"),
+	m_role(m_name),
 	m_id(getNextID()),
 	m_threadId(),
 	m_lock(),
 	m_thread(),
 	m_closeRequested(false),
-	m_runLock(false) {}
+	m_runLock(false),
+	m_timers(currentTick()),
+	m_timerLock("Thread::Timers"),
+	m_parked(false),
+	m_wakeRequested(false) {}
 
 Thread::Thread(const std::string& name)
+	: Thread(name, name) {}
+
+Thread::Thread(const std::string& name, const std::string& role)
 	: m_name(name),
+	  m_role(role),
 	  m_id(getNextID()),
 	  m_threadId(),
 	  m_lock(),
 	  m_thread(), 
 	  m_closeRequested(false), 
-	  m_runLock(false) {}
+	  m_runLock(false),
+	  m_timers(currentTick()),
+	  m_timerLock("Thread::Timers"),
+	  m_parked(false),
+	  m_wakeRequested(false) {}
 
 Thread::~Thread() {
 	requestClose();
 	if (!join()) waitFor();
 }
 
+akc::ScopeGuard Thread::prepareThreadCreation() {
+	return akt::prepareThreadCreation(m_role);
+}
+
 akc::ScopeGuard Thread::performThreadStartup() {
 	currentThreadPtr() = this;
+	akt::applyThreadRole(m_name, m_role);
 	return akc::ScopeGuard([this] {
 		m_runLock = false;
 		m_closeRequested = false;
@@ -56,8 +80,34 @@ akc::ScopeGuard Thread::performThreadStartup() {
 
 void Thread::schedule(const std::function<void()>& func) {
 	m_scheduledCallbacks.push_back(func);
+	wake();
 }
 
+TimerID Thread::scheduleAfter(int64 delayMicroseconds, const std::function<void()>& func) {
+	auto delayTicks = static_cast<uint64>(std::max<int64>(delayMicroseconds + 999, 0)/1000);
+	TimerID result; {
+		auto lock = m_timerLock.lock();
+		result = m_timers.add(currentTick() + delayTicks, 0, func);
+	}
+	wake();
+	return result;
+}
+
+TimerID Thread::scheduleEvery(int64 intervalMicroseconds, const std::function<void()>& func) {
+	auto intervalTicks = static_cast<uint64>(std::max<int64>((intervalMicroseconds + 999)/1000, 1));
+	TimerID result; {
+		auto lock = m_timerLock.lock();
+		result = m_timers.add(currentTick() + intervalTicks, intervalTicks, func);
+	}
+	wake();
+	return result;
+}
+
+bool Thread::cancel(TimerID id) {
+	auto lock = m_timerLock.lock();
+	return m_timers.cancel(id);
+}
+
 bool Thread::update() {
 	if (currentThreadPtr() != this) return false;
 
@@ -68,15 +118,69 @@ bool Thread::update() {
 	m_scheduledCallbacks.iterate([](akSize /*i*/, auto& callback){callback();});
 	m_scheduledCallbacks.clear();
 
+	/* Timers */ {
+		auto timerLock = m_timerLock.lock();
+		m_timers.advance(currentTick(), m_expiredTimers);
+	}
+
+	for(auto& expired : m_expiredTimers) {
+		expired.callback();
+		if (!expired.periodic) continue;
+		auto timerLock = m_timerLock.lock();
+		m_timers.restore(expired.id, std::move(expired.callback));
+	}
+	m_expiredTimers.clear();
+
 	return true;
 }
 
+bool Thread::park(int64 maxMicroseconds) {
+	if (currentThreadPtr() != this) return false;
+
+	std::optional<uint64> nextTick; {
+		auto timerLock = m_timerLock.lock();
+		nextTick = m_timers.nextTick();
+	}
+
+	auto wakeCondition = [this]{ return m_wakeRequested.load() || m_closeRequested.load(); };
+
+	m_parked.store(true);
+	/* Wait */ {
+		std::unique_lock<std::mutex> lock(m_parkLock);
+		if ((maxMicroseconds < 0) && !nextTick) {
+			m_parkSignal.wait(lock, wakeCondition);
+		} else {
+			auto deadline = std::chrono::steady_clock::time_point::max();
+			if (maxMicroseconds >= 0) deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(maxMicroseconds);
+			if (nextTick) deadline = std::min(deadline, tickTime(*nextTick));
+			m_parkSignal.wait_until(lock, deadline, wakeCondition);
+		}
+	}
+	m_parked.store(false);
+
+	// Cleared after waking, anything scheduled since is picked up by the next update regardless.
+	m_wakeRequested.store(false);
+	return true;
+}
+
+void Thread::wake() {
+	m_wakeRequested.store(true);
+	if (!m_parked.load()) return;
+	{ std::lock_guard<std::mutex> lock(m_parkLock); }
+	m_parkSignal.notify_one();
+}
+
 void Thread::setName(const std::string& name) {
 	m_name = name;
 }
 
+void Thread::setRole(const std::string& role) {
+	m_role = role;
+}
+
 Thread& Thread::requestClose() {
 	m_closeRequested = true;
+	wake();
 	return *this;
 }
 
@@ -117,6 +221,10 @@ const std::string& Thread::name() const {
 	return m_name;
 }
 
+const std::string& Thread::role() const {
+	return m_role;
+}
+
 uint64 Thread::id() const {
 	return m_id;
 }
@@ -135,6 +243,19 @@ static uint64 getNextID() {
 	return ++CurrentUID;
 }
 
+static std::chrono::steady_clock::time_point tickEpoch() {
+	static const auto epoch = std::chrono::steady_clock::now();
+	return epoch;
+}
+
+static uint64 currentTick() {
+	return static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tickEpoch()).count());
+}
+
+static std::chrono::steady_clock::time_point tickTime(uint64 tick) {
+	return tickEpoch() + std::chrono::milliseconds(tick);
+}
+
 static Thread*& currentThreadPtr() {
 	thread_local Thread* thread = nullptr;
 	return thread;
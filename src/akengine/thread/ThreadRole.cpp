@@ -0,0 +1,221 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/Config.hpp>
+#include <akengine/debug/Log.hpp>
+#include <akengine/thread/ThreadRole.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <mutex>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace akt;
+
+static const std::string DEFAULT_ROLE("Default");
+
+static std::mutex& roleLock() {
+	static std::mutex instance;
+	return instance;
+}
+
+static std::map<std::string, ThreadRole>& roles() {
+	static std::map<std::string, ThreadRole> instance;
+	return instance;
+}
+
+static std::vector<ThreadTopology>& topology() {
+	static std::vector<ThreadTopology> instance;
+	return instance;
+}
+
+ThreadRole akt::threadRole(const std::string& roleName) {
+	std::lock_guard<std::mutex> lock(roleLock());
+
+	auto iter = roles().find(roleName);
+	if (iter != roles().end()) return iter->second;
+
+	iter = roles().find(DEFAULT_ROLE);
+	if (iter != roles().end()) return iter->second;
+
+	return ThreadRole{{}, SchedulePolicy::Normal, 0, 0, 0};
+}
+
+void akt::setThreadRole(const std::string& roleName, const ThreadRole& role) {
+	std::lock_guard<std::mutex> lock(roleLock());
+	roles()[roleName] = role;
+}
+
+// ////////////////// //
+// // Platform API // //
+// ////////////////// //
+
+#if defined(__linux__)
+
+std::thread::native_handle_type akt::currentThreadHandle() {
+	return pthread_self();
+}
+
+static bool applyAffinity(pthread_t thread, const std::vector<uint32>& cpus) {
+	if (cpus.empty()) return true;
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for(auto cpu : cpus) if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuSet);
+
+	return pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet) == 0;
+}
+
+/// @return 0 on success, otherwise the error number
+static int applyPolicy(pthread_t thread, SchedulePolicy policy, int32 realtimePriority) {
+	sched_param param{};
+	int nativePolicy = SCHED_OTHER;
+	switch(policy) {
+		case SchedulePolicy::Normal: nativePolicy = SCHED_OTHER; break;
+		case SchedulePolicy::Batch:  nativePolicy = SCHED_BATCH; break;
+		case SchedulePolicy::Idle:   nativePolicy = SCHED_IDLE;  break;
+		case SchedulePolicy::Realtime: {
+			nativePolicy = SCHED_FIFO;
+			param.sched_priority = std::clamp<int>(realtimePriority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+		} break;
+	}
+
+	return pthread_setschedparam(thread, nativePolicy, &param);
+}
+
+static bool applyNiceLevel(int32 niceLevel) {
+	return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceLevel) == 0;
+}
+
+#else
+
+std::thread::native_handle_type akt::currentThreadHandle() { return std::thread::native_handle_type(); }
+
+static bool applyAffinity(std::thread::native_handle_type /*thread*/, const std::vector<uint32>& cpus) { return cpus.empty(); }
+static int applyPolicy(std::thread::native_handle_type /*thread*/, SchedulePolicy policy, int32 /*realtimePriority*/) { return (policy == SchedulePolicy::Normal) ? 0 : ENOTSUP; }
+static bool applyNiceLevel(int32 niceLevel) { return niceLevel == 0; }
+
+#endif
+
+static bool applyRole(std::thread::native_handle_type thread, bool isCurrentThread, const std::string& threadName, const std::string& roleName) {
+	constexpr akl::Logger log(AK_STRING_VIEW("Thread"));
+	auto role = threadRole(roleName);
+	ThreadTopology result{threadName, roleName, role.affinity, role.policy, role.niceLevel, role.realtimePriority, role.stackSize, true};
+
+	if (!applyAffinity(thread, role.affinity)) {
+		log.warn("Could not set affinity for thread '", threadName, "'.");
+		result.affinity.clear();
+		result.fullyApplied = false;
+	}
+
+	if (auto error = applyPolicy(thread, role.policy, role.realtimePriority); error != 0) {
+		if (error == EPERM) log.warn("Not permitted to set ", se_internal::convertSchedulePolicyToString(role.policy), " scheduling for thread '", threadName, "' (needs CAP_SYS_NICE or an rtprio limit), using Normal.");
+		else log.warn("Could not set ", se_internal::convertSchedulePolicyToString(role.policy), " scheduling for thread '", threadName, "', using Normal.");
+		applyPolicy(thread, SchedulePolicy::Normal, 0);
+		result.policy = SchedulePolicy::Normal;
+		result.realtimePriority = 0;
+		result.fullyApplied = false;
+	}
+
+	if ((result.policy != SchedulePolicy::Realtime) && (role.niceLevel != 0) && (!isCurrentThread || !applyNiceLevel(role.niceLevel))) {
+		log.warn("Could not set nice level ", role.niceLevel, " for thread '", threadName, "'.");
+		result.niceLevel = 0;
+		result.fullyApplied = false;
+	}
+
+	std::lock_guard<std::mutex> lock(roleLock());
+	auto iter = std::find_if(topology().begin(), topology().end(), [&](const auto& entry){ return entry.threadName == threadName; });
+	if (iter != topology().end()) *iter = result;
+	else topology().push_back(result);
+
+	return result.fullyApplied;
+}
+
+bool akt::applyThreadRole(const std::string& threadName, const std::string& roleName) {
+	return applyRole(currentThreadHandle(), true, threadName, roleName);
+}
+
+bool akt::applyThreadRole(std::thread::native_handle_type thread, const std::string& threadName, const std::string& roleName) {
+	return applyRole(thread, false, threadName, roleName);
+}
+
+#if defined(__linux__) && defined(__GLIBC__)
+
+akc::ScopeGuard akt::prepareThreadCreation(const std::string& roleName) {
+	static std::mutex creationLock;
+
+	auto stackSize = threadRole(roleName).stackSize;
+	if (stackSize == 0) return akc::ScopeGuard();
+
+	// std::thread always uses the default attributes, so temporarily change them for the new thread.
+	creationLock.lock();
+	pthread_attr_t previous, modified;
+	pthread_getattr_default_np(&previous);
+	pthread_getattr_default_np(&modified);
+	pthread_attr_setstacksize(&modified, std::max<size_t>(stackSize, PTHREAD_STACK_MIN));
+	pthread_setattr_default_np(&modified);
+	pthread_attr_destroy(&modified);
+
+	return akc::ScopeGuard([previous]() mutable {
+		pthread_setattr_default_np(&previous);
+		pthread_attr_destroy(&previous);
+		creationLock.unlock();
+	});
+}
+
+#else
+
+akc::ScopeGuard akt::prepareThreadCreation(const std::string& /*roleName*/) {
+	return akc::ScopeGuard();
+}
+
+#endif
+
+std::vector<ThreadTopology> akt::threadTopology() {
+	std::lock_guard<std::mutex> lock(roleLock());
+	return topology();
+}
+
+// Elevated priorities need privileges and can starve the rest of the system, only audio asks for one as it underruns without it
+static akev::SubscriberID threadSInitRegenerateConfigHook = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& event){
+	akd::serialize(event.data()["threads"]["Default"], ThreadRole{{}, SchedulePolicy::Normal,   0,  0, 0});
+	akd::serialize(event.data()["threads"]["Main"],    ThreadRole{{}, SchedulePolicy::Normal,   0,  0, 0});
+	akd::serialize(event.data()["threads"]["Render"],  ThreadRole{{}, SchedulePolicy::Normal,   0,  0, 0});
+	akd::serialize(event.data()["threads"]["Audio"],   ThreadRole{{}, SchedulePolicy::Realtime, 0, 20, 0});
+	akd::serialize(event.data()["threads"]["Log"],     ThreadRole{{}, SchedulePolicy::Batch,    5,  0, 0});
+	akd::serialize(event.data()["threads"]["Worker"],  ThreadRole{{}, SchedulePolicy::Normal,   0,  0, 0});
+});
+
+static akev::SubscriberID threadSInitRegisterConfigHooks = ake::setConfigDispatch().subscribe([](ake::SetConfigEvent& event) {
+	const auto& threadConfig = event.data().atOrDef("threads");
+	if (!threadConfig.isObj()) return;
+
+	std::map<std::string, ThreadRole> newRoles;
+	for(const auto& entry : threadConfig.getObj()) {
+		ThreadRole role;
+		if (akd::deserialize(role, entry.second)) newRoles.emplace(entry.first, role);
+	}
+
+	std::lock_guard<std::mutex> lock(roleLock());
+	roles() = std::move(newRoles);
+});
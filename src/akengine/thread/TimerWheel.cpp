@@ -0,0 +1,184 @@
+/**
+ * Copyright 2018 Michael J. Baker
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **/
+
+#include <akengine/thread/TimerWheel.hpp>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace akt;
+
+TimerWheel::TimerWheel(uint64 startTick) : m_nodes(), m_freeNodes(), m_slots(), m_current(startTick), m_count(0) {
+	m_slots.fill(NONE);
+}
+
+TimerID TimerWheel::add(uint64 deadline, uint64 interval, std::function<void()> callback) {
+	uint32 index;
+	if (m_freeNodes.empty()) {
+		index = static_cast<uint32>(m_nodes.size());
+		m_nodes.push_back(Node{0, 0, 1, NONE, NONE, NONE, {}});
+	} else {
+		index = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+
+	auto& node = m_nodes[index];
+	node.deadline = deadline;
+	node.interval = interval;
+	node.callback = std::move(callback);
+
+	link(index);
+	m_count++;
+
+	return (static_cast<uint64>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::cancel(TimerID id) {
+	if (!isValid(id)) return false;
+	auto index = static_cast<uint32>(id & 0xFFFFFFFF);
+	unlink(index);
+	release(index);
+	return true;
+}
+
+void TimerWheel::advance(uint64 tick, std::vector<Expired>& out) {
+	while(m_current <= tick) {
+		if (m_count == 0) { m_current = tick + 1; return; }
+
+		// Pull down any upper level slots that are now within range, highest first
+		for(uint32 level = LEVEL_COUNT; level-- > 0;) {
+			if ((m_current & ((uint64(1) << shiftFor(level)) - 1)) == 0) cascade(level);
+		}
+
+		auto& head = m_slots[m_current & (ROOT_SLOTS - 1)];
+		while(head != NONE) {
+			auto index = head;
+			unlink(index);
+
+			auto& node = m_nodes[index];
+			auto id = (static_cast<uint64>(node.generation) << 32) | index;
+
+			if (node.interval == 0) {
+				out.push_back(Expired{id, std::move(node.callback), false});
+				release(index);
+				continue;
+			}
+
+			// A periodic timer that is still waiting on restore() has already been queued, coalesce it.
+			if (node.callback) {
+				out.push_back(Expired{id, std::move(node.callback), true});
+				node.callback = nullptr;
+			}
+
+			node.deadline = std::max(node.deadline + node.interval, m_current + 1);
+			link(index);
+		}
+
+		m_current++;
+	}
+}
+
+bool TimerWheel::restore(TimerID id, std::function<void()>&& callback) {
+	if (!isValid(id)) return false;
+	m_nodes[id & 0xFFFFFFFF].callback = std::move(callback);
+	return true;
+}
+
+std::optional<uint64> TimerWheel::nextTick() const {
+	if (m_count == 0) return std::nullopt;
+
+	uint64 result = std::numeric_limits<uint64>::max();
+	for(uint64 i = 0; i < ROOT_SLOTS; i++) {
+		if (m_slots[(m_current + i) & (ROOT_SLOTS - 1)] == NONE) continue;
+		result = m_current + i;
+		break;
+	}
+
+	// Upper levels can only give the tick they cascade on, which is never later than their timers expire.
+	for(uint32 level = 0; level < LEVEL_COUNT; level++) {
+		auto shift = shiftFor(level);
+		for(uint64 i = 0; i < LEVEL_SLOTS; i++) {
+			auto block = (m_current >> shift) + i;
+			if (m_slots[ROOT_SLOTS + level*LEVEL_SLOTS + (block & (LEVEL_SLOTS - 1))] == NONE) continue;
+
+			auto cascadeTick = block << shift;
+			if (cascadeTick < m_current) cascadeTick += uint64(LEVEL_SLOTS) << shift;
+			result = std::min(result, cascadeTick);
+		}
+	}
+
+	return result;
+}
+
+void TimerWheel::link(uint32 index) {
+	auto& node = m_nodes[index];
+	node.deadline = std::max(node.deadline, m_current);
+
+	uint64 delta = node.deadline - m_current;
+	uint32 slot;
+	if (delta < ROOT_SLOTS) {
+		slot = static_cast<uint32>(node.deadline & (ROOT_SLOTS - 1));
+	} else {
+		auto placement = (delta < MAX_DELTA) ? node.deadline : (m_current + MAX_DELTA - 1);
+		delta = placement - m_current;
+
+		uint32 level = 0;
+		while((level + 1 < LEVEL_COUNT) && (delta >= (uint64(1) << shiftFor(level + 1)))) level++;
+		slot = ROOT_SLOTS + level*LEVEL_SLOTS + static_cast<uint32>((placement >> shiftFor(level)) & (LEVEL_SLOTS - 1));
+	}
+
+	node.slot = slot;
+	node.prev = NONE;
+	node.next = m_slots[slot];
+	if (node.next != NONE) m_nodes[node.next].prev = index;
+	m_slots[slot] = index;
+}
+
+void TimerWheel::unlink(uint32 index) {
+	auto& node = m_nodes[index];
+	if (node.prev != NONE) m_nodes[node.prev].next = node.next;
+	else m_slots[node.slot] = node.next;
+	if (node.next != NONE) m_nodes[node.next].prev = node.prev;
+	node.slot = NONE;
+	node.prev = NONE;
+	node.next = NONE;
+}
+
+void TimerWheel::release(uint32 index) {
+	auto& node = m_nodes[index];
+	node.callback = nullptr;
+	node.generation++;
+	m_freeNodes.push_back(index);
+	m_count--;
+}
+
+void TimerWheel::cascade(uint32 level) {
+	auto slot = ROOT_SLOTS + level*LEVEL_SLOTS + static_cast<uint32>((m_current >> shiftFor(level)) & (LEVEL_SLOTS - 1));
+	auto index = std::exchange(m_slots[slot], NONE);
+	while(index != NONE) {
+		auto next = m_nodes[index].next;
+		m_nodes[index].slot = NONE;
+		link(index);
+		index = next;
+	}
+}
+
+bool TimerWheel::isValid(TimerID id) const {
+	auto index = static_cast<uint32>(id & 0xFFFFFFFF);
+	if (index >= m_nodes.size()) return false;
+	const auto& node = m_nodes[index];
+	return (node.generation == static_cast<uint32>(id >> 32)) && (node.slot != NONE);
+}
@@ -12,5 +12,8 @@ include_guard(GLOBAL)
 
 sugar_files(AK_ENGINE_SOURCE 
 	CurrentThread.cpp 
+	Spinlock.cpp
 	Thread.cpp
+	ThreadRole.cpp
+	TimerWheel.cpp
 )
@@ -15,43 +15,73 @@
  **/
 
 #include <akasset/Convert.hpp>
+#include <akcommon/Memory.hpp>
 #include <akcommon/PrimitiveTypes.hpp>
 #include <akcommon/String.hpp>
 #include <akcommon/Timer.hpp>
 #include <akengine/Config.hpp>
-#include <akengine/data/Hash.hpp>
 #include <akengine/data/PValue.hpp>
 #include <akengine/data/Serialize.hpp>
 #include <akengine/debug/Log.hpp>
-#include <akengine/ecs/Component.hpp>
-#include <akengine/ecs/Entity.hpp>
-#include <akengine/ecs/Registry.hpp>
-#include <akengine/ecs/Types.hpp>
+#include <akengine/debug/Profiler.hpp>
 #include <akengine/event/Dispatcher.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akengine/filesystem/Path.hpp>
 #include <akgame/game.hpp>
+#include <akinput/keyboard/Keyboard.hpp>
+#include <akinput/mouse/Mouse.hpp>
 #include <akrender/gl/Draw.hpp>
 #include <akrender/window/Types.hpp>
 #include <akrender/window/Window.hpp>
 #include <akrender/window/WindowOptions.hpp>
+#include <aksound/backend/Backend.hpp>
+#include <aksound/backend/Types.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
-void akg::startup(const akl::Logger& log) {
-	log.info("Starting window system."); {
-		akr::win::init();
+static bool headlessMode = false;
+static std::atomic<bool> stopRequested = false;
 
-		if (ake::config().exists("window")) {
-			if (!akr::win::open(akd::deserialize<akr::win::WindowOptions>(ake::config()["window"]))) throw std::runtime_error("Failed to open window");
-		} else {
-			auto defaultWindowOptions = akr::win::WindowOptions().glVSync(akr::win::VSync::FULL);
-			if (!akr::win::open(defaultWindowOptions)) throw std::runtime_error("Failed to open window");
-		}
+static constexpr akSize AUDIO_CHANNELS = 2; // Stereo
+static akSize uploadSilence(void* audioFrames, akSize frameCount, aks::backend::StreamFormat /*streamFormat*/);
 
-		akr::win::setCursorMode(akr::win::CursorMode::Captured);
-	}
+void akg::startup(const akl::Logger& log, bool headless) {
+	headlessMode = headless || ake::config()["engine"]["headless"].asOrDef<bool>(false);
+
+	if (headlessMode) {
+		log.info("Running headless, draw calls are recorded instead of rendered.");
+		akr::gl::initRecording();
+
+		log.info("Starting audio system."); {
+			// No device on build agents and servers, the null backend still drives the audio thread
+			static const std::vector<aks::backend::Backend> headlessBackends = {aks::backend::Backend::Null};
+			aks::backend::StreamFormat streamFormat{aks::backend::Format::FPSingle, aks::backend::ChannelMap::Stereo, 48000};
+			if (aks::backend::init(headlessBackends, aks::backend::DeviceIdentifier(), streamFormat, uploadSilence)) aks::backend::startDevice();
+			else log.warn("Failed to start audio device, continuing without sound.");
+		}
+	} else {
+		log.info("Starting window system."); {
+			akr::win::init();
+
+			if (ake::config().exists("window")) {
+				if (!akr::win::open(akd::deserialize<akr::win::WindowOptions>(ake::config()["window"]))) throw std::runtime_error("Failed to open window");
+			} else {
+				auto defaultWindowOptions = akr::win::WindowOptions().glVSync(akr::win::VSync::FULL);
+				if (!akr::win::open(defaultWindowOptions)) throw std::runtime_error("Failed to open window");
+			}
+
+			akr::win::setCursorMode(akr::win::CursorMode::Captured);
+		}
 
-	log.info("Starting OpenGL system."); {
-		akr::gl::init();
+		log.info("Starting OpenGL system."); {
+			akr::gl::init();
+		}
 	}
 
 	log.info("Converting resources."); {
@@ -60,109 +90,116 @@ void akg::startup(const akl::Logger& log) {
 }
 
 void akg::cleanup(const akl::Logger& log) {
+	if (headlessMode) {
+		log.info("Stopping audio system."); {
+			aks::backend::stopDevice();
+		}
+
+		auto calls = akr::gl::recordedCalls();
+		log.info("Recorded ", calls.draws, " draws, ", calls.indexedDraws, " indexed draws, ", calls.vertices, " vertices, ", calls.clears, " clears and ", calls.stateChanges, " state changes.");
+		return;
+	}
+
 	log.info("Cleaning up window system."); {
 		akr::win::shutdown();
 	}
 }
 
-static void setupGame(/*ake::Scene& scene*/);
-
-class TestComponent1 : public akecs::Component {
-	public:
-		static constexpr std::string_view COMPONENT_NAME = AK_STRING_VIEW("TestComponent1");
-		static constexpr akecs::ComponentTypeUID COMPONENT_UID = akd::hash32FNV1A<char>(COMPONENT_NAME.data(), COMPONENT_NAME.size());
-
-		TestComponent1(akecs::BaseRegistry&, akecs::EntityRef) {}
-		virtual ~TestComponent1() = default;
-
-		TestComponent1(const TestComponent1&) {}
-		TestComponent1& operator=(const TestComponent1&) { return *this; }
-};
-
-class TestComponent2 : public akecs::Component {
-	public:
-		static constexpr std::string_view COMPONENT_NAME = AK_STRING_VIEW("TestComponent2");
-		static constexpr akecs::ComponentTypeUID COMPONENT_UID = akd::hash32FNV1A<char>(COMPONENT_NAME.data(), COMPONENT_NAME.size());
-
-		TestComponent2(akecs::BaseRegistry&, akecs::EntityRef) {}
+bool akg::isHeadless() {
+	return headlessMode;
+}
 
+static akSize uploadSilence(void* audioFrames, akSize frameCount, aks::backend::StreamFormat /*streamFormat*/) {
+	akc::memset(static_cast<fpSingle*>(audioFrames), 0.f, frameCount*AUDIO_CHANNELS);
+	return frameCount;
+}
 
-};
+static void setupGame(/*ake::Scene& scene*/);
 
-class TestComponent3 : public akecs::Component {
-	public:
-		static constexpr std::string_view COMPONENT_NAME = AK_STRING_VIEW("TestComponent3");
-		static constexpr akecs::ComponentTypeUID COMPONENT_UID = akd::hash32FNV1A<char>(COMPONENT_NAME.data(), COMPONENT_NAME.size());
-};
+static constexpr uint32 MAX_CATCH_UP_TICKS = 5;
 
-void akg::runGame() {
-	akl::Logger("Info").info(sizeof(akecs::Registry<TestComponent1>));
-	akl::Logger("Info").info(sizeof(akecs::Registry<TestComponent1, TestComponent2>));
-	akl::Logger("Info").info(sizeof(akecs::Registry<TestComponent1, TestComponent2, TestComponent3>));
+static void requestStop(int /*signal*/) {
+	stopRequested = true;
+}
 
+void akg::runGame(uint64 maxTicks, const std::string& replayPath) {
+	constexpr akl::Logger log(AK_STRING_VIEW("Game"));
+	static akc::FrameStats& updateStats = akprof::frameStats(akprof::stats::Update);
+	static akc::FrameStats& renderStats = akprof::frameStats(akprof::stats::Render);
 
-	akc::Timer timer;
+	auto ticksPerSecond = ake::config()["engine"]["ticksPerSecond"].asOrDef<fpSingle>(60.f);
+	auto tickDelta = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<fpDouble>(1.0/ticksPerSecond));
+	bool paced = !headlessMode || (maxTicks == 0);
 
-	akSize totalMS = 0;
-	for(akSize j = 0; j < 100; j++) {
-		akecs::Registry<TestComponent1, TestComponent2> a;
-		a.reserveEntities(10000000);
-		for(akSize i = 0; i < 10000000; i++) a.create();
-		akSize timeMS = timer.markAndReset().msecs();
-		totalMS += timeMS;
-		akl::Logger("ecs").info("Time taken to create 10,000,000: ", timeMS, "ms");
+	// Headless runs are driven from scripts and have no window to close, normal runs leave the host's handlers alone
+	if (headlessMode) {
+		std::signal(SIGINT, requestStop);
+		std::signal(SIGTERM, requestStop);
 	}
 
-	akl::Logger("ecs").info("Average time taken to create 10,000,000: ", totalMS/100, "ms");
-
-	// for(akSize i = 0; i < 10000000; i++) a.destroy(entities[i]);
-	// akl::Logger("ecs").info("Time taken to destroy 10,000,000: ", timer.markAndReset().msecs(), "ms");
-
-	/*for(akSize i = 0; i < 1000000; i++) {
-		auto entity = a.create();
-		if (!a.   attach<TestComponent1>(entity)) akl::Logger("Info").info(   "attach 1 fail");
-		if (!a.component<TestComponent1>(entity)) akl::Logger("Info").info("component 1 fail");
-		if (!a.   detach<TestComponent1>(entity)) akl::Logger("Info").info(   "detach 1 fail");
-		a.destroy(entity);
-	}*/
-
-
-/*	ake::SceneManager sceneManager;
-	auto& scene = sceneManager.getScene(sceneManager.newScene("World"));
-
-	setupGame(scene);
-
-	fpSingle updateAccum = 0.f;
-	fpSingle updateDelta = 1.f/ake::config()["engine"]["ticksPerSecond"].asOrDef<fpSingle>(60.f);
-	//fpSingle renderDelta = 1.f/static_cast<fpSingle>(akw::currentMonitor().prefVideoMode.refreshRate);
-
-	while(!akr::win::closeRequested()) {
-		static akc::FPSCounter fps(60), tps(60);
-		static akc::Timer loopTimer;
+	// The loop does the pacing, so frames are replayed as soon as their tick comes up
+	akev::Replay replay;
+	bool replaying = false;
+	if (!replayPath.empty()) {
+		if (!headlessMode) log.warn("Replays are only supported headless, ignoring: ", replayPath);
+		else if (!replay.open(akfs::Path(replayPath), akev::ReplaySpeed::Maximum)) log.warn("Could not open replay: ", replayPath);
+		else replaying = true;
+	}
 
-		while(updateAccum >= updateDelta) {
-			akc::Timer updateTimer;
+	setupGame();
+
+	akc::Timer runTimer;
+	uint64 ticks = 0;
+	auto nextTick = std::chrono::steady_clock::now();
+	while(!stopRequested && ((maxTicks == 0) || (ticks < maxTicks))) {
+		if (!headlessMode && akr::win::closeRequested()) break;
+
+		// Fixed-step updates, ticks are dropped rather than spiralling when updates fall behind
+		auto now = std::chrono::steady_clock::now();
+		if (!paced) nextTick = now;
+		nextTick = std::max(nextTick, now - MAX_CATCH_UP_TICKS*tickDelta);
+		while((nextTick <= now) && ((maxTicks == 0) || (ticks < maxTicks))) {
+			akprof::StatScope updateScope(updateStats);
+			AK_PROFILE_SCOPE("Game::update");
+
+			if (headlessMode) {
+				aks::backend::update();
+				akev::recordFrame();
+				if (replaying) {
+					if (!replay.replayFrame()) {
+						replaying = false;
+						log.info("Replay finished after ", replay.frame(), " frames and ", replay.eventCount(), " events.");
+					}
+					akr::win::mouse().update();
+					akr::win::keyboard().update();
+				}
+			} else {
+				akr::win::pollEvents();
+				akr::win::mouse().update();
+				akr::win::keyboard().update();
+			}
+
+			nextTick += tickDelta;
+			ticks++;
+		}
 
-			akr::win::pollEvents();
-			akr::win::mouse().update();
-			akr::win::keyboard().update();
+		/* Render */ {
+			akprof::StatScope renderScope(renderStats);
+			AK_PROFILE_SCOPE("Game::render");
 
-			sceneManager.update(updateDelta);
+			akr::gl::setClearColour(0.2f, 0.2f, 0.2f);
+			akr::gl::clear();
 
-			tps.update();
-			if (updateTimer.mark().secsf() > updateDelta) updateAccum = akm::mod(updateAccum, updateDelta);
-			updateAccum -= updateDelta;
+			if (headlessMode) akprof::endFrame();
+			else akr::win::swapBuffer();
 		}
 
-		sceneManager.render(fps.update().avgTickDelta());
-
-		std::stringstream sstream;
-		sstream << fps.avgTicksPerSecond() << "fps | " << tps.avgTicksPerSecond() << "tps";
-		akr::win::setTitle(sstream.str());
+		// Without vsync to block on, sleep until the next update is due
+		if (headlessMode && paced) std::this_thread::sleep_until(nextTick);
+	}
 
-		updateAccum += loopTimer.mark().secsf();
-		loopTimer.reset();
-	}*/
+	auto seconds = runTimer.mark().secsf();
+	log.info("Ran ", ticks, " ticks in ", seconds, "s, ", static_cast<fpSingle>(ticks)/std::max(seconds, 1e-6f), " ticks per second.");
 }
 
 static void setupGame(/*ake::Scene& scene*/) {
@@ -187,4 +224,5 @@ static void setupGame(/*ake::Scene& scene*/) {
 static const auto cb = ake::regenerateConfigDispatch().subscribe([](ake::RegenerateConfigEvent& ev){
 	auto& config = ev.data()["engine"];
 	config["ticksPerSecond"].set<fpSingle>(60.0f);
+	config["headless"].set<bool>(false);
 });
@@ -16,6 +16,7 @@
 
 #include <akengine/debug/Log.hpp>
 #include <akengine/event/Dispatcher.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akinput/keyboard/EventKeyboard.hpp>
 #include <akinput/keyboard/Keyboard.hpp>
 #include <akinput/keyboard/Keys.hpp>
@@ -27,8 +28,13 @@ using namespace akin;
 Action EventKeyboard::getKeyAction(Key key) const { return m_keyStates[static_cast<size_t>(key)].first; }
 State EventKeyboard::getKeyState(Key key) const { return m_keyStates[static_cast<size_t>(key)].second; }
 
-EventKeyboard::EventKeyboard() = default;
-EventKeyboard::~EventKeyboard() = default;
+EventKeyboard::EventKeyboard() {
+	akev::setReplayHandler<KeyEventData>(KeyEvent::EVENT_ID, [this](KeyEventData data){ data.sender = this; onKeyEvent(data); });
+}
+
+EventKeyboard::~EventKeyboard() {
+	akev::clearReplayHandler(KeyEvent::EVENT_ID);
+}
 
 const akev::DispatcherProxy<KeyEvent>& EventKeyboard::keyEvent() { return m_keyEventProxy; }
 
@@ -59,6 +65,6 @@ void EventKeyboard::update() {
 	});
 }
 
-void EventKeyboard::onKeyEvent(const KeyEventData& data) { m_keyEventBuffer.push_back(data); }
+void EventKeyboard::onKeyEvent(const KeyEventData& data) { akev::record(KeyEvent::EVENT_ID, data); m_keyEventBuffer.push_back(data); }
 
 
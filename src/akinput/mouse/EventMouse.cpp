@@ -15,6 +15,7 @@
  **/
 
 #include <akengine/debug/Log.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akinput/mouse/EventMouse.hpp>
 #include <crtdefs.h>
 #include <glm/vec2.hpp>
@@ -24,8 +25,17 @@ using namespace akin;
 Action EventMouse::getButtonAction(Button key) const { return m_buttonStates[static_cast<size_t>(key)].first; }
 State EventMouse::getButtonState(Button key) const { return m_buttonStates[static_cast<size_t>(key)].second; }
 
-EventMouse::EventMouse() = default;
-EventMouse::~EventMouse() = default;
+EventMouse::EventMouse() {
+	akev::setReplayHandler<ButtonEventData>(ButtonEvent::EVENT_ID, [this](ButtonEventData data){ data.sender = this; onButtonEvent(data); });
+	akev::setReplayHandler<ScrollEventData>(ScrollEvent::EVENT_ID, [this](ScrollEventData data){ data.sender = this; onScrollEvent(data); });
+	akev::setReplayHandler<MoveEventData>(MoveEvent::EVENT_ID,     [this](MoveEventData data){ data.sender = this; onMoveEvent(data); });
+}
+
+EventMouse::~EventMouse() {
+	akev::clearReplayHandler(ButtonEvent::EVENT_ID);
+	akev::clearReplayHandler(ScrollEvent::EVENT_ID);
+	akev::clearReplayHandler(MoveEvent::EVENT_ID);
+}
 
 const akev::DispatcherProxy<ButtonEvent>& EventMouse::buttonEvent() { return m_buttonEventProxy; }
 const akev::DispatcherProxy<ScrollEvent>& EventMouse::scrollEvent() { return m_scrollEventProxy; }
@@ -93,6 +103,6 @@ void EventMouse::update() {
 	});
 }
 
-void EventMouse::onButtonEvent(const ButtonEventData& data) { m_eventBuffer.push_back(EventRecord(data)); }
-void EventMouse::onScrollEvent(const ScrollEventData& data) { m_eventBuffer.push_back(EventRecord(data)); }
-void EventMouse::onMoveEvent(const MoveEventData& data) { m_eventBuffer.push_back(EventRecord(data)); }
+void EventMouse::onButtonEvent(const ButtonEventData& data) { akev::record(ButtonEvent::EVENT_ID, data); m_eventBuffer.push_back(EventRecord(data)); }
+void EventMouse::onScrollEvent(const ScrollEventData& data) { akev::record(ScrollEvent::EVENT_ID, data); m_eventBuffer.push_back(EventRecord(data)); }
+void EventMouse::onMoveEvent(const MoveEventData& data) { akev::record(MoveEvent::EVENT_ID, data); m_eventBuffer.push_back(EventRecord(data)); }
@@ -83,8 +83,7 @@ void akmain::setupDebugHandling() {
 		akl::Logger("Term").warn("Terminate called.");
 	}
 
-	akl::processMessageQueue();
-	akl::processMessageQueue();
+	akl::flush();
 
 	std::abort();
 }
@@ -220,8 +219,7 @@ namespace backward {
 
 				akl::Logger("Signal").fatal("Received fatal signal, program terminating.\n", sstream.str());
 
-				akl::processMessageQueue();
-				akl::processMessageQueue();
+				akl::flush();
 			}
 
 		private:
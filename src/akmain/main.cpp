@@ -2,23 +2,66 @@
 #include <akcommon/String.hpp>
 #include <akcommon/Time.hpp>
 #include <akengine/debug/Log.hpp>
+#include <akengine/debug/Memory.hpp>
+#include <akengine/debug/Profiler.hpp>
+#include <akengine/metrics/Metrics.hpp>
 #include <akengine/Config.hpp>
 #include <akengine/thread/CurrentThread.hpp>
+#include <akengine/thread/Spinlock.hpp>
+#include <akengine/thread/ThreadRole.hpp>
 #include <akgame/game.hpp>
 #include <akmain/Debug.hpp>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 
-static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogToFile);
+static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogToFile, bool headless);
+
+static void printUsage() {
+	std::printf(
+		"Usage: akutenshi [options]\n"
+		"  --headless       Run without a window or GL context\n"
+		"  --ticks <n>      Stop after n updates, headless runs are unthrottled\n"
+		"  --replay <file>  Feed an event recording back one update at a time, implies --headless\n"
+	);
+}
+
+static bool parseArguments(int argc, char* argv[], bool& headless, uint64& maxTicks, std::string& replayPath) {
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") { headless = true; continue; }
+		if ((arg == "--help") || (arg == "-h")) return false;
+
+		if (i + 1 >= argc) { std::fprintf(stderr, "Missing value for '%s'.\n", arg.c_str()); return false; }
+		std::string value = argv[++i];
+
+		if (arg == "--replay") { headless = true; replayPath = value; continue; }
+		if (arg != "--ticks") { std::fprintf(stderr, "Unknown option '%s'.\n", arg.c_str()); return false; }
+
+		// strtoull accepts leading whitespace and negatives, and returns 0 for garbage
+		char* end = nullptr;
+		maxTicks = std::strtoull(value.c_str(), &end, 10);
+		if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0])) || (*end != '\0')) { std::fprintf(stderr, "Invalid tick count '%s'.\n", value.c_str()); return false; }
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	bool headless = false;
+	uint64 maxTicks = 0;
+	std::string replayPath;
+	if (!parseArguments(argc, argv, headless, maxTicks, replayPath)) { printUsage(); return 2; }
 
-int main(int /*argc*/, char* /*argv*/[]) {
 	akmain::setupDebugHandling();
 
 	constexpr akl::Logger startLog(AK_STRING_VIEW("Start"));
-	auto cleanup = bootstrapEngine(startLog, false);
+	auto cleanup = bootstrapEngine(startLog, false, headless);
 
-	akg::runGame();
+	akg::runGame(maxTicks, replayPath);
 
 	return 0;
 }
@@ -27,7 +70,7 @@ static void cleanupEngine();
 static void startupConfig();
 static void printLogHeader(const akl::Logger& log);
 
-static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogToFile) {
+static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogToFile, bool headless) {
 	auto cleanup = akc::ScopeGuard(cleanupEngine);
 
 	/* Setup Thread Name */ {
@@ -36,6 +79,7 @@ static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogT
 
 	log.info("Loading engine config."); {
 		startupConfig();
+		akt::applyThreadRole("Main", "Main");
 	}
 
 	log.info("Starting log system."); {
@@ -44,11 +88,17 @@ static akc::ScopeGuard bootstrapEngine(const akl::Logger& log, bool redirectLogT
 	}
 
 	log.info("Starting game systems."); {
-		akg::startup(log);
+		akg::startup(log, headless);
 	}
 
 	printLogHeader(log);
 
+	for(const auto& entry : akt::threadTopology()) {
+		std::stringstream cpus;
+		for(auto cpu : entry.affinity) cpus << cpu << ' ';
+		log.info("Thread '", entry.threadName, "' (", entry.roleName, "): CPUs [ ", cpus.str(), "], ", akt::se_internal::convertSchedulePolicyToString(entry.policy), ", nice ", entry.niceLevel, ", priority ", entry.realtimePriority, ", stack ", entry.stackSize, entry.fullyApplied ? "." : " (partially applied).");
+	}
+
 	return cleanup;
 }
 
@@ -66,10 +116,20 @@ static void cleanupEngine() {
 	log.info("Saving config.");
 	if (!ake::saveConfig()) log.warn("Failed to save config.");
 
+#	ifdef AK_SPINLOCK_STATS
+	for(const auto& stats : akt::spinlockStatistics()) {
+		log.info("Lock '", stats.name, "': ", stats.acquisitions, " acquisitions, ", stats.contended, " contended, ", stats.waitNS/1000, "us waiting.");
+	}
+#	endif
+
+	akprof::stopCapture();
+	akprof::logFrameStats();
+	akmem::logReport();
+	akmet::stopExporting();
+
 	log.info("Flushing log system.");
 	akl::stopProcessing();
-	akl::processMessageQueue();
-	akl::processMessageQueue();
+	akl::flush();
 }
 
 static void startupConfig() {
@@ -26,8 +26,21 @@
 
 using namespace akr::gl;
 
+static bool recording = false;
+static RecordedCalls recorded;
+
 static void APIENTRY ogl_logErrorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* /*userParam​*/) {
 	akl::Logger glLog("OGL");
+
+	akl::Level level;
+	switch(severity) {
+		case GL_DEBUG_SEVERITY_HIGH:   level = akl::Level::Error; break;
+		case GL_DEBUG_SEVERITY_MEDIUM: level = akl::Level::Warn;  break;
+		case GL_DEBUG_SEVERITY_LOW:    level = akl::Level::Info;  break;
+		default:                       level = akl::Level::Debug; break;
+	}
+	if (!akl::isFilterLevelEnabled(level)) return;
+
 	std::stringstream sstream;
 
 	switch(type) {
@@ -95,11 +108,26 @@ void akr::gl::init() {
 	hasInit = true;
 }
 
+void akr::gl::initRecording() {
+	recording = true;
+	recorded = RecordedCalls();
+}
+
+bool akr::gl::isRecording() {
+	return recording;
+}
+
+RecordedCalls akr::gl::recordedCalls() {
+	return recorded;
+}
+
 void akr::gl::setViewport(const akm::Vec2& offset, const akm::Vec2& size) {
+	if (recording) { recorded.stateChanges++; return; }
 	glViewport(offset.x, offset.y, size.x, size.y);
 }
 
 void akr::gl::draw(DrawType mode, uint32 vertexCount, uint32 offset) {
+	if (recording) { recorded.draws++; recorded.vertices += vertexCount; return; }
 	switch(mode) {
 		case DrawType::Points: glDrawArrays(GL_POINTS, offset, vertexCount); break;
 
@@ -118,6 +146,7 @@ void akr::gl::draw(DrawType mode, uint32 vertexCount, uint32 offset) {
 }
 
 void akr::gl::drawIndexed(DrawType mode, IDataType indexType, uint32 vertexCount, uint32 offset) {
+	if (recording) { recorded.indexedDraws++; recorded.vertices += vertexCount; return; }
 
 	uint32 dataType = 0;
 	switch(indexType) {
@@ -147,6 +176,7 @@ void akr::gl::drawIndexed(DrawType mode, IDataType indexType, uint32 vertexCount
 }
 
 void akr::gl::clear(ClearMode clearMode) {
+	if (recording) { recorded.clears++; return; }
 	constexpr auto COLOUR_BUFFER  = static_cast<uint32>(ClearMode::Colour);
 	constexpr auto DEPTH_BUFFER   = static_cast<uint32>(ClearMode::Depth);
 	constexpr auto STENCIL_BUFFER = static_cast<uint32>(ClearMode::Stencil);
@@ -161,18 +191,22 @@ void akr::gl::clear(ClearMode clearMode) {
 }
 
 void akr::gl::setClearColour(fpSingle red, fpSingle green, fpSingle blue, fpSingle alpha) {
+	if (recording) { recorded.stateChanges++; return; }
 	glClearColor(red, green, blue, alpha);
 }
 
 void akr::gl::setClearDepth(fpSingle depth) {
+	if (recording) { recorded.stateChanges++; return; }
 	glClearDepth(depth);
 }
 
 void akr::gl::setClearStencil(int32 stencil) {
+	if (recording) { recorded.stateChanges++; return; }
 	glClearStencil(stencil);
 }
 
 void akr::gl::setFillMode(FillMode fillMode, Face face) {
+	if (recording) { recorded.stateChanges++; return; }
 	uint32 glFillMode = GL_FILL;
 	switch(fillMode) {
 		case FillMode::Point: glFillMode = GL_POINT; break;
@@ -188,16 +222,19 @@ void akr::gl::setFillMode(FillMode fillMode, Face face) {
 }
 
 void akr::gl::enableDepthTest(bool state) {
+	if (recording) { recorded.stateChanges++; return; }
 	if (state) glEnable(GL_DEPTH_TEST);
 	else glDisable(GL_DEPTH_TEST);
 }
 
 void akr::gl::enableCullFace(bool state) {
+	if (recording) { recorded.stateChanges++; return; }
 	if (state) glEnable(GL_CULL_FACE);
 	else glDisable(GL_CULL_FACE);
 }
 
 void akr::gl::setDepthTestMode(DepthMode depthMode) {
+	if (recording) { recorded.stateChanges++; return; }
 	switch(depthMode) {
 		case DepthMode::Never:        glDepthFunc(GL_NEVER);    break;
 		case DepthMode::Always:       glDepthFunc(GL_ALWAYS);   break;
@@ -211,6 +248,7 @@ void akr::gl::setDepthTestMode(DepthMode depthMode) {
 }
 
 void akr::gl::setCullFaceMode(CullMode cullMode) {
+	if (recording) { recorded.stateChanges++; return; }
 	switch(cullMode) {
 		case CullMode::Front:        glCullFace(GL_FRONT);          break;
 		case CullMode::Back:         glCullFace(GL_BACK);           break;
@@ -15,10 +15,13 @@
  **/
 
 #include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akengine/thread/DoubleBuffer.hpp>
 #include <akrender/window/InternalState.hpp>
 #include <akrender/window/Types.hpp>
 #include <GLFW/glfw3.h>
+#include <cstring>
+#include <vector>
 
 namespace akr {
 	namespace win {
@@ -37,6 +40,50 @@ namespace akr {
 using namespace akr::win;
 using namespace akr::win::internal;
 
+static constexpr akev::RecordChannel ACTION_RECORD_CHANNEL = akev::calculateEventID("WindowAction");
+
+/// Fixed part of a recorded Action, followed by the title bytes. Monitors are replayed as NullMonitor since their handles are process local.
+struct ActionRecord {
+	ActionType type;
+	WindowCoord winCoord1;
+	WindowCoord winCoord2;
+	FrameCoord frameCoord;
+	bool state;
+	int targetFramerate;
+	CursorMode cursorMode;
+};
+
+static void recordAction(const Action& action) {
+	// The record is copied with its padding, which brace initialisation doesn't have to clear
+	ActionRecord record;
+	std::memset(&record, 0, sizeof(ActionRecord));
+	record.type = action.type;
+	record.winCoord1 = action.winCoord1;
+	record.winCoord2 = action.winCoord2;
+	record.frameCoord = action.frameCoord;
+	record.state = action.state;
+	record.targetFramerate = action.targetFramerate;
+	record.cursorMode = action.cursorMode;
+
+	thread_local std::vector<uint8> payload;
+	payload.resize(sizeof(ActionRecord) + action.title.size());
+	std::memcpy(payload.data(), &record, sizeof(ActionRecord));
+	std::memcpy(payload.data() + sizeof(ActionRecord), action.title.data(), action.title.size());
+
+	akev::record(ACTION_RECORD_CHANNEL, payload.data(), payload.size());
+}
+
+static void replayAction(const uint8* data, akSize size) {
+	if (size < sizeof(ActionRecord)) return;
+	ActionRecord record;
+	std::memcpy(&record, data, sizeof(ActionRecord));
+
+	std::string title(reinterpret_cast<const char*>(data) + sizeof(ActionRecord), size - sizeof(ActionRecord));
+	eventBuffer.push_back(Action{record.type, title, record.winCoord1, record.winCoord2, record.frameCoord, record.state, Monitor::NullMonitor(), record.targetFramerate, record.cursorMode});
+}
+
+static bool windowSInitReplayHandler = (akev::setReplayHandler(ACTION_RECORD_CHANNEL, replayAction), true);
+
 static void glfwPosHandler(GLFWwindow* /*handle*/, int x, int y) {
 	eventBuffer.push_back(Action::Position({x, y}));
 }
@@ -75,6 +122,8 @@ void akr::win::internal::processEventBuffer() {
 
 	WindowState newState = windowState;
 	eventBuffer.iterate([&](akSize /*index*/, const Action& action){
+		if (akev::isRecording()) recordAction(action);
+
 		switch(action.type) {
 			case ActionType::Title:
 				newState.title = action.title;
@@ -15,6 +15,8 @@
  **/
 
 #include <akcommon/PrimitiveTypes.hpp>
+#include <akengine/debug/Profiler.hpp>
+#include <akengine/event/Recorder.hpp>
 #include <akengine/thread/DoubleBuffer.hpp>
 #include <akinput/keyboard/EventKeyboard.hpp>
 #include <akinput/keyboard/Keys.hpp>
@@ -182,11 +184,13 @@ void akr::win::pollEvents() {
 	processActionBuffer();
 	glfwPollEvents();
 	processEventBuffer();
+	akev::recordFrame();
 }
 
 bool akr::win::swapBuffer() {
 	if (!windowHandle) return false;
 	glfwSwapBuffers(windowHandle);
+	akprof::endFrame();
 	return true;
 }
 
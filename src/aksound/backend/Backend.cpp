@@ -18,6 +18,9 @@
 #include <akcommon/Iterator.hpp>
 #include <akcommon/ScopeGuard.hpp>
 #include <akengine/debug/Log.hpp>
+#include <akengine/debug/Profiler.hpp>
+#include <akengine/metrics/Metrics.hpp>
+#include <akengine/thread/ThreadRole.hpp>
 #include <aksound/backend/Backend.hpp>
 #include <aksound/backend/internal/Mal.hpp>
 #include <aksound/backend/Util.hpp>
@@ -26,6 +29,7 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 
 using namespace aks::backend;
 
@@ -48,6 +52,20 @@ static std::atomic<bool> malIsInit = false;
 static mal_context malContext;
 static mal_device  malDevice;
 
+// The callback only reports its thread, the role is applied from update so neither the callback nor startDevice block on it
+static std::atomic<bool> audioThreadReported = false;
+static std::thread::native_handle_type audioThread;
+static bool audioRoleApplied = false;
+
+// Made before the device starts, the callback's first zone would otherwise allocate it
+static akprof::ZoneBuffer audioZoneBuffer;
+
+// Looked up in init, lookups lock and allocate so the callback can't make them
+static akc::FrameStats* callbackStats = nullptr;
+static akmet::Counter* callbackMetric = nullptr;
+static akmet::Counter* underrunMetric = nullptr;
+static akmet::Counter* silentFrameMetric = nullptr;
+
 bool aks::backend::init(const DeviceIdentifier& deviceID, StreamFormat streamFormat, const std::function<upload_callback_f>& callback) {
 	return init(internal::DEFAULT_BACKENDS, deviceID, streamFormat, callback);
 }
@@ -57,18 +75,41 @@ bool aks::backend::init(const std::vector<Backend>& backends, const DeviceIdenti
 	akc::ScopeGuard resetInitFlag([&]{malIsInit = false;});
 
 	if (!initContext(&malContext, backends)) return false;
-	if (!initDevice(&malContext, &malDevice, deviceID, streamFormat, callback)) { mal_context_uninit(&malContext); return false; }
+
+	audioThreadReported = false;
+	audioRoleApplied = false;
+	callbackStats = &akprof::frameStats(akprof::stats::Audio);
+	callbackMetric = &akmet::counter("audio.callbacks");
+	underrunMetric = &akmet::counter("audio.underruns");
+	silentFrameMetric = &akmet::counter("audio.silentFrames");
+#ifdef AK_PROFILER
+	if (!audioZoneBuffer) audioZoneBuffer = akprof::makeZoneBuffer("Audio");
+#endif
+	bool deviceCreated = [&]{
+		auto creationGuard = akt::prepareThreadCreation("Audio"); // Mini-al creates its thread during init
+		return initDevice(&malContext, &malDevice, deviceID, streamFormat, callback);
+	}();
+	if (!deviceCreated) { mal_context_uninit(&malContext); return false; }
 
 	resetInitFlag.clear();
 
 	return true;
 }
 
-void aks::backend::startDevice() { if (malIsInit) mal_device_start(&malDevice); }
+void  aks::backend::startDevice() { if (malIsInit) mal_device_start(&malDevice); }
 void  aks::backend::stopDevice() { if (malIsInit) mal_device_stop(&malDevice); }
 
 bool aks::backend::isDeviceStarted() { return (malIsInit) && (mal_device_is_started(&malDevice) == MAL_TRUE); }
 
+void aks::backend::update() {
+	if ((!malIsInit) || (audioRoleApplied)) return;
+
+	// Mini-al doesn't expose its thread, it's known once the first callback has reported it
+	if (!audioThreadReported.load(std::memory_order_acquire)) return;
+	akt::applyThreadRole(audioThread, "Audio", "Audio");
+	audioRoleApplied = true;
+}
+
 std::optional<ContextInfo> aks::backend::getContextInfo() {
 	if (!malIsInit) return {};
 	switch(malContext.backend) {
@@ -207,5 +248,24 @@ static void recvMalMessage(mal_context* /*pContext*/, mal_device* /*pDevice*/, m
 }
 
 static mal_uint32 malCallback_internal(mal_device* device, mal_uint32 frameCount, void* dst) {
-	return static_cast<MalUserData*>(device->pUserData)->callback(dst, frameCount, static_cast<MalUserData*>(device->pUserData)->streamFormat);
+	if (!audioThreadReported.load(std::memory_order_relaxed)) {
+		audioThread = akt::currentThreadHandle();
+		audioThreadReported.store(true, std::memory_order_release);
+	}
+	akprof::StatScope statScope(*callbackStats);
+#ifdef AK_PROFILER
+	akprof::Zone profileZone(akprof::adoptZoneBuffer(audioZoneBuffer) ? "Audio::callback" : nullptr);
+#endif
+
+	auto& userData = *static_cast<MalUserData*>(device->pUserData);
+	auto written = userData.callback(dst, frameCount, userData.streamFormat);
+
+	// Mini-al pads short writes with silence, which is audible as a dropout
+	callbackMetric->add();
+	if (written < frameCount) {
+		underrunMetric->add();
+		silentFrameMetric->add(frameCount - written);
+	}
+
+	return static_cast<mal_uint32>(written);
 }
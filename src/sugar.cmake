@@ -5,6 +5,7 @@ include_guard(GLOBAL)
 # ################ #
 
 sugar_include(akasset)
+sugar_include(akbench)
 sugar_include(akcommon)
 sugar_include(akengine)
 sugar_include(akgame)